@@ -32,6 +32,7 @@
 #include <linux/debugfs.h>
 #include <linux/rbtree.h>
 #include <linux/sched.h>
+#include <linux/sched/rt.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
 #include <linux/vmalloc.h>
@@ -39,6 +40,7 @@
 #include <linux/security.h>
 #include <linux/ratelimit.h>
 #include <linux/pid_namespace.h>
+#include <linux/flight_recorder.h>
 
 #include "binder.h"
 #include "binder_trace.h"
@@ -114,6 +116,13 @@ module_param_named(proc_no_lock, binder_debug_no_lock, bool, S_IWUSR | S_IRUGO);
 static char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, S_IRUGO);
 
+/*
+ * Let every node inherit the rt policy of its synchronous callers, not only
+ * those that ask for it with FLAT_BINDER_FLAG_INHERIT_RT.
+ */
+static bool binder_inherit_rt = true;
+module_param_named(inherit_rt, binder_inherit_rt, bool, S_IWUSR | S_IRUGO);
+
 static DECLARE_WAIT_QUEUE_HEAD(binder_user_error_wait);
 static int binder_stop_on_user_error;
 
@@ -245,6 +254,17 @@ struct binder_work {
 	} type;
 };
 
+/*
+ * Scheduling attributes passed from a caller to the thread handling its
+ * transaction. prio is a kernel priority, see task_struct::normal_prio, and
+ * util_min the minimum utilization clamp.
+ */
+struct binder_priority {
+	unsigned int sched_policy;
+	int prio;
+	unsigned int util_min;
+};
+
 struct binder_node {
 	int debug_id;
 	struct binder_work work;
@@ -265,6 +285,8 @@ struct binder_node {
 	unsigned pending_weak_ref:1;
 	unsigned has_async_transaction:1;
 	unsigned accept_fds:1;
+	unsigned sched_policy:2;
+	unsigned inherit_rt:1;
 	unsigned min_priority:8;
 	struct list_head async_todo;
 };
@@ -347,7 +369,7 @@ struct binder_proc {
 	int requested_threads;
 	int requested_threads_started;
 	int ready_threads;
-	long default_priority;
+	struct binder_priority default_priority;
 	struct dentry *debugfs_entry;
 	struct binder_context *context;
 };
@@ -390,8 +412,11 @@ struct binder_transaction {
 	struct binder_buffer *buffer;
 	unsigned int	code;
 	unsigned int	flags;
-	long	priority;
-	long	saved_priority;
+	struct binder_priority	priority;
+	struct binder_priority	saved_priority;
+	/* deadline parameters lent by the sender, and those of the target */
+	struct sched_dl_donation dl_donation;
+	struct sched_dl_donation saved_dl;
 	uid_t	sender_euid;
 };
 
@@ -460,36 +485,188 @@ static inline void binder_unlock(const char *tag)
 	mutex_unlock(&binder_main_lock);
 }
 
-static void __set_user_nice_no_resched(long nice)
+static void kfree_no_resched(const void *objp)
 {
 	preempt_disable();
-	set_user_nice(current, nice);
+	kfree(objp);
 	preempt_enable_no_resched();
 }
 
-static void kfree_no_resched(const void *objp)
+static bool is_rt_policy(int policy)
+{
+	return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+static bool is_fair_policy(int policy)
+{
+	return policy == SCHED_NORMAL || policy == SCHED_BATCH;
+}
+
+static bool binder_supported_policy(int policy)
+{
+	return is_fair_policy(policy) || is_rt_policy(policy);
+}
+
+/* nice value or rt priority of a kernel priority, as userspace sees it */
+static int to_userspace_prio(int policy, int kernel_priority)
+{
+	if (is_fair_policy(policy))
+		return kernel_priority - DEFAULT_PRIO;
+	else
+		return MAX_USER_RT_PRIO - 1 - kernel_priority;
+}
+
+static int to_kernel_prio(int policy, int user_priority)
 {
+	if (is_fair_policy(policy))
+		return user_priority + DEFAULT_PRIO;
+	else
+		return MAX_USER_RT_PRIO - 1 - user_priority;
+}
+
+static unsigned int binder_util_min(struct task_struct *task)
+{
+#ifdef CONFIG_UCLAMP_TASK
+	return task->uclamp_req[UCLAMP_MIN].value;
+#else
+	return 0;
+#endif
+}
+
+static void binder_get_priority(struct task_struct *task,
+				struct binder_priority *prio)
+{
+	prio->sched_policy = task->policy;
+	prio->prio = task->normal_prio;
+	prio->util_min = binder_util_min(task);
+}
+
+/*
+ * Switch the current thread to the given policy, priority and minimum
+ * utilization clamp. Unless restoring attributes the thread had before,
+ * the rt priority and nice value are capped to what RLIMIT_RTPRIO and
+ * RLIMIT_NICE allow, as binder_set_nice() used to do. A thread that holds
+ * a SCHED_DEADLINE reservation of its own keeps it. Like kfree_no_resched(),
+ * this does not reschedule while binder_main_lock is held.
+ */
+static void binder_do_set_priority(struct binder_priority desired,
+				   bool verify)
+{
+	struct task_struct *task = current;
+	struct sched_attr attr;
+	unsigned int policy = desired.sched_policy;
+	int priority;
+
+	if (task->policy == SCHED_DEADLINE ||
+	    !binder_supported_policy(policy))
+		return;
+	if (task->policy == policy && task->normal_prio == desired.prio &&
+	    binder_util_min(task) == desired.util_min)
+		return;
+
+	priority = to_userspace_prio(policy, desired.prio);
+
+	if (verify && is_rt_policy(policy) && !capable(CAP_SYS_NICE)) {
+		unsigned long max_rtprio = task_rlimit(task, RLIMIT_RTPRIO);
+
+		if (max_rtprio == 0) {
+			policy = SCHED_NORMAL;
+			priority = -20;
+		} else if (priority > max_rtprio) {
+			priority = max_rtprio;
+		}
+	}
+
+	if (verify && is_fair_policy(policy) && !can_nice(task, priority)) {
+		long min_nice = 20 - task_rlimit(task, RLIMIT_NICE);
+
+		if (min_nice >= 20) {
+			binder_user_error("%d RLIMIT_NICE not set\n",
+					  task->pid);
+			return;
+		}
+		priority = min_nice;
+	}
+
+	if (policy != desired.sched_policy ||
+	    to_kernel_prio(policy, priority) != desired.prio)
+		binder_debug(BINDER_DEBUG_PRIORITY_CAP,
+			     "%d: priority %d not allowed, using %d instead\n",
+			     task->pid, desired.prio,
+			     to_kernel_prio(policy, priority));
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = policy;
+	if (is_rt_policy(policy))
+		attr.sched_priority = priority;
+	else
+		attr.sched_nice = priority;
+	if (task->sched_reset_on_fork)
+		attr.sched_flags |= SCHED_FLAG_RESET_ON_FORK;
+#ifdef CONFIG_UCLAMP_TASK
+	attr.sched_flags |= SCHED_FLAG_UTIL_CLAMP_MIN;
+	attr.sched_util_min = min_t(unsigned int, desired.util_min,
+				    task->uclamp_req[UCLAMP_MAX].value);
+#endif
+
 	preempt_disable();
-	kfree(objp);
+	sched_setattr_nocheck(task, &attr);
 	preempt_enable_no_resched();
 }
 
-static void binder_set_nice(long nice)
+static void binder_set_priority(struct binder_priority desired)
 {
-	long min_nice;
+	binder_do_set_priority(desired, true);
+}
 
-	if (can_nice(current, nice)) {
-		__set_user_nice_no_resched(nice);
-		return;
+static void binder_restore_priority(struct binder_priority desired)
+{
+	binder_do_set_priority(desired, false);
+}
+
+/*
+ * Save the attributes of the current thread, then run it with those of the
+ * caller of @t, or with the minimum priority of @node if that is higher.
+ * Rt callers only pass their policy on to nodes that inherit it.
+ */
+static void binder_transaction_priority(struct binder_transaction *t,
+					struct binder_node *node)
+{
+	struct binder_priority desired = t->priority;
+	struct binder_priority node_prio = {
+		.sched_policy = node->sched_policy,
+		.prio = node->min_priority,
+	};
+
+	binder_get_priority(current, &t->saved_priority);
+
+	if (!node->inherit_rt && !binder_inherit_rt &&
+	    is_rt_policy(desired.sched_policy)) {
+		desired.sched_policy = SCHED_NORMAL;
+		desired.prio = DEFAULT_PRIO;
 	}
-	min_nice = 20 - current->signal->rlim[RLIMIT_NICE].rlim_cur;
-	binder_debug(BINDER_DEBUG_PRIORITY_CAP,
-		     "%d: nice value %ld not allowed use %ld instead\n",
-		      current->pid, nice, min_nice);
-	__set_user_nice_no_resched(min_nice);
-	if (min_nice < 20)
-		return;
-	binder_user_error("%d RLIMIT_NICE not set\n", current->pid);
+
+	if (node_prio.prio < desired.prio ||
+	    (node_prio.prio == desired.prio &&
+	     node_prio.sched_policy == SCHED_FIFO)) {
+		desired.sched_policy = node_prio.sched_policy;
+		desired.prio = node_prio.prio;
+	}
+
+	binder_set_priority(desired);
+}
+
+/*
+ * Run with the deadline parameters lent by the caller, or with none for
+ * NULL, see sched_dl_inherit(). Like binder_set_priority(), this does not
+ * reschedule while binder_main_lock is held.
+ */
+static void binder_set_dl(const struct sched_dl_donation *d)
+{
+	preempt_disable();
+	sched_dl_inherit(current, d);
+	preempt_enable_no_resched();
 }
 
 static size_t binder_buffer_size(struct binder_proc *proc,
@@ -966,6 +1143,8 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 	node->proc = proc;
 	node->ptr = ptr;
 	node->cookie = cookie;
+	node->sched_policy = SCHED_NORMAL;
+	node->min_priority = DEFAULT_PRIO;
 	node->work.type = BINDER_WORK_NODE;
 	INIT_LIST_HEAD(&node->work.entry);
 	INIT_LIST_HEAD(&node->async_todo);
@@ -976,6 +1155,29 @@ static struct binder_node *binder_new_node(struct binder_proc *proc,
 	return node;
 }
 
+/*
+ * The priority bits of a flat_binder_object are a nice value for the fair
+ * policies and an rt priority otherwise, see FLAT_BINDER_FLAG_SCHED_POLICY_MASK.
+ */
+static void binder_init_node_priority(struct binder_node *node, __u32 flags)
+{
+	int policy = (flags & FLAT_BINDER_FLAG_SCHED_POLICY_MASK) >>
+		     FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT;
+	int priority;
+
+	if (is_fair_policy(policy))
+		priority = clamp_t(int, (s8)(flags &
+					     FLAT_BINDER_FLAG_PRIORITY_MASK),
+				   -20, 19);
+	else
+		priority = clamp_t(int, flags & FLAT_BINDER_FLAG_PRIORITY_MASK,
+				   1, MAX_USER_RT_PRIO - 1);
+
+	node->sched_policy = policy;
+	node->min_priority = to_kernel_prio(policy, priority);
+	node->inherit_rt = !!(flags & FLAT_BINDER_FLAG_INHERIT_RT);
+}
+
 static int binder_inc_node(struct binder_node *node, int strong, int internal,
 			   struct list_head *target_list)
 {
@@ -1594,7 +1796,7 @@ static int binder_translate_binder(struct flat_binder_object *fp,
 		if (!node)
 			return -ENOMEM;
 
-		node->min_priority = fp->flags & FLAT_BINDER_FLAG_PRIORITY_MASK;
+		binder_init_node_priority(node, fp->flags);
 		node->accept_fds = !!(fp->flags & FLAT_BINDER_FLAG_ACCEPTS_FDS);
 	}
 	if (fp->cookie != node->cookie) {
@@ -1884,7 +2086,8 @@ static void binder_transaction(struct binder_proc *proc,
 			return_error = BR_FAILED_REPLY;
 			goto err_empty_call_stack;
 		}
-		binder_set_nice(in_reply_to->saved_priority);
+		binder_restore_priority(in_reply_to->saved_priority);
+		binder_set_dl(&in_reply_to->saved_dl);
 		if (in_reply_to->to_thread != thread) {
 			binder_user_error("%d:%d got reply transaction with bad transaction stack, transaction %d has target %d:%d\n",
 				proc->pid, thread->pid, in_reply_to->debug_id,
@@ -2020,9 +2223,19 @@ static void binder_transaction(struct binder_proc *proc,
 	t->to_thread = target_thread;
 	t->code = tr->code;
 	t->flags = tr->flags;
-	t->priority = task_nice(current);
+	if (!(t->flags & TF_ONE_WAY) &&
+	    binder_supported_policy(current->policy))
+		binder_get_priority(current, &t->priority);
+	else
+		t->priority = target_proc->default_priority;
+	if (!reply && !(t->flags & TF_ONE_WAY))
+		sched_dl_donation(current, &t->dl_donation);
 
 	trace_binder_transaction(reply, t, target_node);
+	flight_rec_log(reply ? FLIGHT_REC_BINDER_REPLY :
+		       FLIGHT_REC_BINDER_TRANSACTION, thread->pid,
+		       target_thread ? target_thread->pid : target_proc->pid,
+		       t->debug_id);
 
 	t->buffer = binder_alloc_buf(target_proc, tr->data_size,
 		tr->offsets_size, extra_buffers_size,
@@ -2739,7 +2952,8 @@ retry:
 			wait_event_interruptible(binder_user_error_wait,
 						 binder_stop_on_user_error < 2);
 		}
-		binder_set_nice(proc->default_priority);
+		binder_restore_priority(proc->default_priority);
+		binder_set_dl(NULL);
 		if (non_block) {
 			if (!binder_has_proc_work(proc, thread))
 				ret = -EAGAIN;
@@ -2920,13 +3134,11 @@ retry:
 
 			tr.target.ptr = target_node->ptr;
 			tr.cookie =  target_node->cookie;
-			t->saved_priority = task_nice(current);
-			if (t->priority < target_node->min_priority &&
-			    !(t->flags & TF_ONE_WAY))
-				binder_set_nice(t->priority);
-			else if (!(t->flags & TF_ONE_WAY) ||
-				 t->saved_priority > target_node->min_priority)
-				binder_set_nice(target_node->min_priority);
+			binder_transaction_priority(t, target_node);
+			if (!(t->flags & TF_ONE_WAY)) {
+				sched_dl_lent(current, &t->saved_dl);
+				binder_set_dl(&t->dl_donation);
+			}
 			cmd = BR_TRANSACTION;
 		} else {
 			tr.target.ptr = 0;
@@ -2965,6 +3177,8 @@ retry:
 		ptr += sizeof(tr);
 
 		trace_binder_transaction_received(t);
+		flight_rec_log(FLIGHT_REC_BINDER_RECEIVED, thread->pid, 0,
+			       t->debug_id);
 		binder_stat_br(proc, thread, cmd);
 		binder_debug(BINDER_DEBUG_TRANSACTION,
 			     "%d:%d %s %d %d:%d, cmd %d size %zd-%zd ptr %016llx-%016llx\n",
@@ -3499,7 +3713,12 @@ static int binder_open(struct inode *nodp, struct file *filp)
 	proc->tsk = current;
 	INIT_LIST_HEAD(&proc->todo);
 	init_waitqueue_head(&proc->wait);
-	proc->default_priority = task_nice(current);
+	if (binder_supported_policy(current->policy)) {
+		binder_get_priority(current, &proc->default_priority);
+	} else {
+		proc->default_priority.sched_policy = SCHED_NORMAL;
+		proc->default_priority.prio = DEFAULT_PRIO;
+	}
 	binder_dev = container_of(filp->private_data, struct binder_device,
 				  miscdev);
 	proc->context = &binder_dev->context;
@@ -3787,13 +4006,14 @@ static void print_binder_transaction(struct seq_file *m, const char *prefix,
 				     struct binder_transaction *t)
 {
 	seq_printf(m,
-		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %ld r%d",
+		   "%s %d: %p from %d:%d to %d:%d code %x flags %x pri %d:%d r%d",
 		   prefix, t->debug_id, t,
 		   t->from ? t->from->proc->pid : 0,
 		   t->from ? t->from->pid : 0,
 		   t->to_proc ? t->to_proc->pid : 0,
 		   t->to_thread ? t->to_thread->pid : 0,
-		   t->code, t->flags, t->priority, t->need_reply);
+		   t->code, t->flags, t->priority.sched_policy,
+		   t->priority.prio, t->need_reply);
 	if (t->buffer == NULL) {
 		seq_puts(m, " buffer free\n");
 		return;
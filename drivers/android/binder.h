@@ -43,6 +43,16 @@ enum {
 enum {
 	FLAT_BINDER_FLAG_PRIORITY_MASK = 0xff,
 	FLAT_BINDER_FLAG_ACCEPTS_FDS = 0x100,
+	/*
+	 * Bits 9..10 hold the scheduling policy the minimum priority of the
+	 * node applies to: for SCHED_NORMAL and SCHED_BATCH the priority bits
+	 * are a nice value, for SCHED_FIFO and SCHED_RR an rt priority.
+	 */
+	FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT = 9,
+	FLAT_BINDER_FLAG_SCHED_POLICY_MASK =
+		3U << FLAT_BINDER_FLAG_SCHED_POLICY_SHIFT,
+	/* synchronous callers with an rt policy pass it on to the node */
+	FLAT_BINDER_FLAG_INHERIT_RT = 0x800,
 };
 
 #ifdef BINDER_IPC_32BIT
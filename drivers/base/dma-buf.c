@@ -29,6 +29,7 @@
 #include <linux/export.h>
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
+#include <linux/uaccess.h>
 
 static inline int is_dma_buf_file(struct file *);
 
@@ -50,6 +51,11 @@ static int dma_buf_release(struct inode *inode, struct file *file)
 
 	BUG_ON(dmabuf->vmapping_counter);
 
+	/* cpu accesses userspace began and never ended */
+	for (; dmabuf->user_cpu_access; dmabuf->user_cpu_access--)
+		dma_buf_end_cpu_access(dmabuf, 0, dmabuf->size,
+				       DMA_BIDIRECTIONAL);
+
 	dmabuf->ops->release(dmabuf);
 
 	mutex_lock(&db_list.lock);
@@ -77,9 +83,78 @@ static int dma_buf_mmap_internal(struct file *file, struct vm_area_struct *vma)
 	return dmabuf->ops->mmap(dmabuf, vma);
 }
 
+static int dma_buf_sync_user(struct dma_buf *dmabuf, bool end, size_t start,
+			     size_t len, enum dma_data_direction direction)
+{
+	int ret = 0;
+
+	mutex_lock(&dmabuf->lock);
+	if (!end) {
+		ret = dma_buf_begin_cpu_access(dmabuf, start, len, direction);
+		if (!ret)
+			dmabuf->user_cpu_access++;
+	} else if (dmabuf->user_cpu_access) {
+		dma_buf_end_cpu_access(dmabuf, start, len, direction);
+		dmabuf->user_cpu_access--;
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&dmabuf->lock);
+
+	return ret;
+}
+
+static long dma_buf_ioctl(struct file *file, unsigned int cmd,
+			  unsigned long arg)
+{
+	struct dma_buf *dmabuf;
+	struct dma_buf_sync sync;
+	enum dma_data_direction direction;
+
+	if (!is_dma_buf_file(file))
+		return -EINVAL;
+
+	dmabuf = file->private_data;
+
+	switch (cmd) {
+	case DMA_BUF_IOCTL_SYNC:
+		if (copy_from_user(&sync, (void __user *)arg, sizeof(sync)))
+			return -EFAULT;
+
+		if (sync.flags & ~DMA_BUF_SYNC_VALID_FLAGS_MASK)
+			return -EINVAL;
+
+		switch (sync.flags & DMA_BUF_SYNC_RW) {
+		case DMA_BUF_SYNC_READ:
+			direction = DMA_FROM_DEVICE;
+			break;
+		case DMA_BUF_SYNC_WRITE:
+			direction = DMA_TO_DEVICE;
+			break;
+		case DMA_BUF_SYNC_RW:
+			direction = DMA_BIDIRECTIONAL;
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		if (sync.offset >= dmabuf->size ||
+		    sync.len > dmabuf->size - sync.offset)
+			return -EINVAL;
+		if (!sync.len)
+			sync.len = dmabuf->size - sync.offset;
+
+		return dma_buf_sync_user(dmabuf, sync.flags & DMA_BUF_SYNC_END,
+					 sync.offset, sync.len, direction);
+	default:
+		return -ENOTTY;
+	}
+}
+
 static const struct file_operations dma_buf_fops = {
 	.release	= dma_buf_release,
 	.mmap		= dma_buf_mmap_internal,
+	.unlocked_ioctl	= dma_buf_ioctl,
 };
 
 /*
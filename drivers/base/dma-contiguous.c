@@ -41,8 +41,48 @@
 #include <linux/dma-contiguous.h>
 #include <linux/dma-removed.h>
 #include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
+#include <linux/moduleparam.h>
+#include <linux/export.h>
+#include <linux/ktime.h>
 #include <trace/events/kmem.h>
 
+#ifdef CONFIG_CMA_EVACUATE
+/* bucket i counts allocations that took [2^(i-1), 2^i) us */
+#define CMA_HIST_BUCKETS	24
+
+struct cma_hist {
+	unsigned long count[CMA_HIST_BUCKETS];
+	unsigned long samples;
+	u64 total_us;
+	u64 max_us;
+};
+
+/*
+ * Pages of the area that were evacuated ahead of time are kept allocated,
+ * and marked in the area bitmap, until an allocation claims them.
+ */
+struct cma_evac {
+	/* bit clear: evacuated page waiting for an allocation */
+	unsigned long *unready;
+	unsigned long nr_ready;
+	/* pages to keep evacuated, on their own and asked for by hints */
+	unsigned long headroom;
+	unsigned long hinted;
+	unsigned long hint_expires;
+	struct delayed_work work;
+	/* statistics */
+	unsigned long evacuated;
+	unsigned long released;
+	unsigned long failed;
+	unsigned long alloc_failed;
+	struct cma_hist hist_ready;
+	struct cma_hist hist_migrate;
+};
+#endif
+
 struct cma {
 	unsigned long	base_pfn;
 	unsigned long	count;
@@ -50,6 +90,9 @@ struct cma {
 	bool in_system;
 	bool fixup;
 	struct mutex lock;
+#ifdef CONFIG_CMA_EVACUATE
+	struct cma_evac evac;
+#endif
 };
 
 static DEFINE_MUTEX(cma_mutex);
@@ -183,6 +226,437 @@ static __init int cma_activate_area(unsigned long base_pfn, unsigned long count)
 	return 0;
 }
 
+#ifdef CONFIG_CMA_EVACUATE
+
+#undef MODULE_PARAM_PREFIX
+#define MODULE_PARAM_PREFIX "cma."
+
+/* evacuated headroom every area starts with */
+static unsigned int headroom_kb;
+module_param(headroom_kb, uint, 0444);
+
+/* a hint that no allocation consumed lapses after this */
+static unsigned int hint_ms = 2000;
+module_param(hint_ms, uint, 0644);
+
+static struct workqueue_struct *cma_evac_wq;
+
+/* alloc_contig_range() isolates whole MAX_ORDER blocks and pageblocks */
+#define CMA_EVAC_CHUNK	max_t(unsigned long, MAX_ORDER_NR_PAGES, \
+			      pageblock_nr_pages)
+
+static void cma_hist_add(struct cma_hist *hist, u64 us)
+{
+	int bucket = min_t(int, fls64(us), CMA_HIST_BUCKETS - 1);
+
+	hist->count[bucket]++;
+	hist->samples++;
+	hist->total_us += us;
+	if (us > hist->max_us)
+		hist->max_us = us;
+}
+
+/* Called with cma->lock held */
+static unsigned long cma_evac_target(struct cma *cma)
+{
+	struct cma_evac *evac = &cma->evac;
+
+	if (evac->hinted && time_after_eq(jiffies, evac->hint_expires))
+		evac->hinted = 0;
+	return min(evac->headroom + evac->hinted, cma->count);
+}
+
+static bool cma_evac_enabled(struct cma *cma)
+{
+	return cma_evac_wq && cma->evac.unready && cma->in_system &&
+		!cma->fixup;
+}
+
+/* Called with cma->lock held */
+static void cma_evac_kick(struct cma *cma)
+{
+	unsigned long target = cma_evac_target(cma);
+
+	if (!cma_evac_enabled(cma))
+		return;
+	if (cma->evac.nr_ready < target ||
+	    cma->evac.nr_ready >= target + CMA_EVAC_CHUNK)
+		mod_delayed_work(cma_evac_wq, &cma->evac.work, 0);
+}
+
+/*
+ * Gives evacuated pages back to the page allocator until no more than
+ * @target are left. Called with cma->lock held, returns the number of
+ * pages released.
+ */
+static unsigned long cma_evac_release(struct cma *cma, unsigned long target)
+{
+	struct cma_evac *evac = &cma->evac;
+	unsigned long start, end, nr, released = 0;
+
+	if (evac->nr_ready <= target)
+		return 0;
+
+	start = find_first_zero_bit(evac->unready, cma->count);
+	while (evac->nr_ready > target && start < cma->count) {
+		end = find_next_bit(evac->unready, cma->count, start);
+		nr = min(end - start, evac->nr_ready - target);
+
+		bitmap_set(evac->unready, start, nr);
+		evac->nr_ready -= nr;
+		free_contig_range(cma->base_pfn + start, nr);
+		bitmap_clear(cma->bitmap, start, nr);
+		released += nr;
+
+		start = find_next_zero_bit(evac->unready, cma->count,
+					   start + nr);
+	}
+
+	evac->released += released;
+	return released;
+}
+
+/*
+ * Gives back evacuated pages in the way of an allocation of @count pages
+ * that found no free range: first what lapsed hints left beyond the
+ * target, then @count pages at a time, so that as much of the headroom
+ * as possible survives. Called with cma->lock held, returns the number of
+ * pages released.
+ */
+static unsigned long cma_evac_make_room(struct cma *cma, int count)
+{
+	struct cma_evac *evac = &cma->evac;
+	unsigned long target = cma_evac_target(cma);
+
+	if (evac->nr_ready <= target)
+		target = evac->nr_ready > count ? evac->nr_ready - count : 0;
+	return cma_evac_release(cma, target);
+}
+
+/*
+ * Hands out @count evacuated pages, so that the allocation does not need
+ * to migrate anything. Called with cma->lock held, returns the page number
+ * or cma->count if there is no suitable evacuated range.
+ */
+static unsigned long cma_evac_claim(struct cma *cma, int count,
+				    unsigned long mask)
+{
+	struct cma_evac *evac = &cma->evac;
+	unsigned long pageno;
+
+	if (evac->nr_ready < count)
+		return cma->count;
+
+	pageno = bitmap_find_next_zero_area(evac->unready, cma->count, 0,
+					    count, mask);
+	if (pageno >= cma->count)
+		return cma->count;
+
+	bitmap_set(evac->unready, pageno, count);
+	evac->nr_ready -= count;
+	evac->hinted -= min_t(unsigned long, evac->hinted, count);
+	return pageno;
+}
+
+/*
+ * Migrates movable pages out of the area, a chunk at a time, until the
+ * evacuated pages reach the headroom plus the pending hints, and gives
+ * back what goes beyond that by a chunk or more.
+ */
+static void cma_evac_work_fn(struct work_struct *work)
+{
+	struct cma *cma = container_of(to_delayed_work(work), struct cma,
+				       evac.work);
+	struct cma_evac *evac = &cma->evac;
+	unsigned long chunk = CMA_EVAC_CHUNK;
+	unsigned long pageno, pfn, target, start = 0;
+	int ret;
+
+	mutex_lock(&cma->lock);
+	while (cma_evac_enabled(cma) && evac->nr_ready < cma_evac_target(cma)) {
+		pageno = bitmap_find_next_zero_area(cma->bitmap, cma->count,
+						    start, chunk, chunk - 1);
+		if (pageno >= cma->count)
+			break;
+		bitmap_set(cma->bitmap, pageno, chunk);
+		mutex_unlock(&cma->lock);
+
+		pfn = cma->base_pfn + pageno;
+		mutex_lock(&cma_mutex);
+		ret = alloc_contig_range(pfn, pfn + chunk, MIGRATE_CMA);
+		mutex_unlock(&cma_mutex);
+
+		mutex_lock(&cma->lock);
+		if (ret) {
+			bitmap_clear(cma->bitmap, pageno, chunk);
+			evac->failed++;
+		} else {
+			bitmap_clear(evac->unready, pageno, chunk);
+			evac->nr_ready += chunk;
+			evac->evacuated += chunk;
+		}
+		start = pageno + chunk;
+		cond_resched();
+	}
+
+	target = cma_evac_target(cma);
+	if (evac->nr_ready >= target + chunk)
+		cma_evac_release(cma, target);
+
+	/* come back when the hint lapses to give its pages back */
+	if (evac->hinted)
+		queue_delayed_work(cma_evac_wq, &evac->work,
+				   time_after(evac->hint_expires, jiffies) ?
+				   evac->hint_expires - jiffies : 0);
+	mutex_unlock(&cma->lock);
+}
+
+/*
+ * Records how long an allocation took, and refills what it consumed. An
+ * allocation that migrated its pages itself still consumes a hint.
+ */
+static void cma_evac_account(struct cma *cma, unsigned long pfn, int count,
+			     bool ready, ktime_t begin)
+{
+	u64 us = ktime_us_delta(ktime_get(), begin);
+	struct cma_evac *evac = &cma->evac;
+
+	mutex_lock(&cma->lock);
+	if (!pfn) {
+		evac->alloc_failed++;
+	} else if (ready) {
+		cma_hist_add(&evac->hist_ready, us);
+	} else {
+		cma_hist_add(&evac->hist_migrate, us);
+		evac->hinted -= min_t(unsigned long, evac->hinted, count);
+	}
+	cma_evac_kick(cma);
+	mutex_unlock(&cma->lock);
+}
+
+/* Without its bitmap, the area simply is never evacuated ahead of time */
+static void __init cma_evac_init(struct cma *cma)
+{
+	struct cma_evac *evac = &cma->evac;
+
+	memset(evac, 0, sizeof(*evac));
+	INIT_DELAYED_WORK(&evac->work, cma_evac_work_fn);
+	evac->unready = kmalloc(BITS_TO_LONGS(cma->count) * sizeof(long),
+				GFP_KERNEL);
+	if (evac->unready)
+		bitmap_fill(evac->unready, cma->count);
+}
+
+/**
+ * dma_contiguous_prepare() - announce an upcoming contiguous allocation
+ * @dev:   Pointer to device which is going to allocate.
+ * @count: Number of pages it is going to need.
+ *
+ * Drivers call this ahead of large allocations they can predict, like
+ * at camera or secure video session setup. The pages are migrated out of
+ * the device's area in the background, so that dma_alloc_from_contiguous()
+ * does not have to do it. A hint that no allocation consumed lapses after
+ * cma.hint_ms.
+ */
+void dma_contiguous_prepare(struct device *dev, int count)
+{
+	struct cma *cma = dev_get_cma_area(dev);
+	struct cma_evac *evac;
+
+	if (!cma || count <= 0)
+		return;
+	evac = &cma->evac;
+
+	mutex_lock(&cma->lock);
+	/* drop a lapsed hint before adding to it */
+	cma_evac_target(cma);
+	evac->hinted = min_t(unsigned long, evac->hinted + count, cma->count);
+	evac->hint_expires = jiffies + msecs_to_jiffies(hint_ms);
+	cma_evac_kick(cma);
+	mutex_unlock(&cma->lock);
+}
+EXPORT_SYMBOL(dma_contiguous_prepare);
+
+static int cma_headroom_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	*val = (u64)cma->evac.headroom << (PAGE_SHIFT - 10);
+	return 0;
+}
+
+static int cma_headroom_set(void *data, u64 val)
+{
+	struct cma *cma = data;
+
+	mutex_lock(&cma->lock);
+	cma->evac.headroom = min_t(u64, val >> (PAGE_SHIFT - 10), cma->count);
+	cma_evac_kick(cma);
+	mutex_unlock(&cma->lock);
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_headroom_fops, cma_headroom_get,
+			cma_headroom_set, "%llu\n");
+
+#define K(pages)	((pages) << (PAGE_SHIFT - 10))
+
+static int cma_evac_stats_show(struct seq_file *m, void *v)
+{
+	struct cma *cma = m->private;
+	struct cma_evac *evac = &cma->evac;
+
+	mutex_lock(&cma->lock);
+	seq_printf(m, "ready %lu kB\n" "target %lu kB\n" "hinted %lu kB\n"
+		   "evacuated %lu kB\n" "released %lu kB\n"
+		   "evacuate_failed %lu\n" "alloc_failed %lu\n",
+		   K(evac->nr_ready), K(cma_evac_target(cma)),
+		   K(evac->hinted), K(evac->evacuated), K(evac->released),
+		   evac->failed, evac->alloc_failed);
+	mutex_unlock(&cma->lock);
+	return 0;
+}
+
+static int cma_evac_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_evac_stats_show, inode->i_private);
+}
+
+static const struct file_operations cma_evac_stats_fops = {
+	.open		= cma_evac_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void cma_hist_show_summary(struct seq_file *m, const char *name,
+				  struct cma_hist *hist)
+{
+	u64 avg = hist->samples ? div_u64(hist->total_us, hist->samples) : 0;
+
+	seq_printf(m, "#%s: %lu samples, avg %llu us, max %llu us\n", name,
+		   hist->samples, (unsigned long long)avg,
+		   (unsigned long long)hist->max_us);
+}
+
+/*
+ * Allocations served from evacuated pages and those that had to migrate
+ * pages themselves, side by side.
+ */
+static int cma_latency_show(struct seq_file *m, void *v)
+{
+	struct cma *cma = m->private;
+	struct cma_evac *evac = &cma->evac;
+	int i;
+
+	mutex_lock(&cma->lock);
+	cma_hist_show_summary(m, "Prepared", &evac->hist_ready);
+	cma_hist_show_summary(m, "Migrated", &evac->hist_migrate);
+	seq_printf(m, "#usecs<\tprepared\tmigrated\n");
+
+	for (i = 0; i < CMA_HIST_BUCKETS - 1; i++)
+		seq_printf(m, "%llu\t%lu\t%lu\n", 1ULL << i,
+			   evac->hist_ready.count[i],
+			   evac->hist_migrate.count[i]);
+	seq_printf(m, "inf\t%lu\t%lu\n", evac->hist_ready.count[i],
+		   evac->hist_migrate.count[i]);
+	mutex_unlock(&cma->lock);
+	return 0;
+}
+
+static int cma_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_latency_show, inode->i_private);
+}
+
+/* Writing anything clears the histograms */
+static ssize_t cma_latency_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct cma *cma = ((struct seq_file *)file->private_data)->private;
+
+	mutex_lock(&cma->lock);
+	memset(&cma->evac.hist_ready, 0, sizeof(cma->evac.hist_ready));
+	memset(&cma->evac.hist_migrate, 0, sizeof(cma->evac.hist_migrate));
+	mutex_unlock(&cma->lock);
+	return count;
+}
+
+static const struct file_operations cma_latency_fops = {
+	.open		= cma_latency_open,
+	.read		= seq_read,
+	.write		= cma_latency_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init cma_evac_late_init(void)
+{
+	struct dentry *root, *dir;
+	char name[32];
+	struct cma *cma;
+	int i;
+
+	cma_evac_wq = alloc_workqueue("cma_evac", WQ_UNBOUND | WQ_FREEZABLE,
+				      1);
+	if (!cma_evac_wq)
+		return -ENOMEM;
+
+	root = debugfs_create_dir("cma", NULL);
+	for (i = 0; i < cma_area_count; i++) {
+		cma = cma_areas[i].cma;
+		if (!cma)
+			continue;
+
+		mutex_lock(&cma->lock);
+		cma->evac.headroom = min_t(unsigned long,
+				headroom_kb >> (PAGE_SHIFT - 10), cma->count);
+		cma_evac_kick(cma);
+		mutex_unlock(&cma->lock);
+
+		if (IS_ERR_OR_NULL(root))
+			continue;
+		if (cma_areas[i].name)
+			strlcpy(name, cma_areas[i].name, sizeof(name));
+		else
+			snprintf(name, sizeof(name), "area%d", i);
+		dir = debugfs_create_dir(name, root);
+		if (IS_ERR_OR_NULL(dir))
+			continue;
+		debugfs_create_file("headroom_kb", 0644, dir, cma,
+				    &cma_headroom_fops);
+		debugfs_create_file("stats", 0444, dir, cma,
+				    &cma_evac_stats_fops);
+		debugfs_create_file("alloc_latency", 0644, dir, cma,
+				    &cma_latency_fops);
+	}
+	return 0;
+}
+late_initcall(cma_evac_late_init);
+
+#else
+
+static inline unsigned long cma_evac_make_room(struct cma *cma, int count)
+{
+	return 0;
+}
+
+static inline unsigned long cma_evac_claim(struct cma *cma, int count,
+					   unsigned long mask)
+{
+	return cma->count;
+}
+
+static inline void cma_evac_account(struct cma *cma, unsigned long pfn,
+				    int count, bool ready, ktime_t begin)
+{
+}
+
+static inline void cma_evac_init(struct cma *cma)
+{
+}
+
+#endif
+
 static __init struct cma *cma_create_area(unsigned long base_pfn,
 				     unsigned long count, bool system,
 				     bool fixup)
@@ -211,6 +685,7 @@ static __init struct cma *cma_create_area(unsigned long base_pfn,
 		if (ret)
 			goto error;
 	}
+	cma_evac_init(cma);
 	mutex_init(&cma->lock);
 
 	pr_debug("%s: returned %p\n", __func__, (void *)cma);
@@ -649,6 +1124,8 @@ unsigned long dma_alloc_from_contiguous(struct device *dev, int count,
 	int ret = 0;
 	int tries = 0;
 	int retry_after_sleep = 0;
+	ktime_t begin = ktime_get();
+	bool ready = false;
 
 	if (!cma || !cma->count)
 		return 0;
@@ -667,9 +1144,23 @@ unsigned long dma_alloc_from_contiguous(struct device *dev, int count,
 
 	for (;;) {
 		mutex_lock(&cma->lock);
+		pageno = cma_evac_claim(cma, count, mask);
+		if (pageno < cma->count) {
+			mutex_unlock(&cma->lock);
+			pfn = cma->base_pfn + pageno;
+			ready = true;
+			break;
+		}
+
 		pageno = bitmap_find_next_zero_area(cma->bitmap, cma->count,
 						    start, count, mask);
 		if (pageno >= cma->count) {
+			/* pages evacuated ahead of time may be in the way */
+			if (cma_evac_make_room(cma, count)) {
+				start = 0;
+				mutex_unlock(&cma->lock);
+				continue;
+			}
 			if (retry_after_sleep < 2) {
 				pfn = 0;
 				start = 0;
@@ -727,6 +1218,7 @@ unsigned long dma_alloc_from_contiguous(struct device *dev, int count,
 		/* fixup is only one time */
 		cma->fixup = 0;
 	}
+	cma_evac_account(cma, pfn, count, ready, begin);
 	pr_debug("%s(): returned %lx\n", __func__, pfn);
 	return pfn;
 }
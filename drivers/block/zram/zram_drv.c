@@ -30,6 +30,7 @@
 #include <linux/err.h>
 #include <linux/idr.h>
 #include <linux/sysfs.h>
+#include <linux/swap.h>
 
 #include "zram_drv.h"
 
@@ -607,6 +608,7 @@ static void zram_free_page(struct zram *zram, size_t index)
 		if (zram_test_flag(meta, index, ZRAM_ZERO)) {
 			zram_clear_flag(meta, index, ZRAM_ZERO);
 			atomic64_dec(&zram->stats.zero_pages);
+			swap_compr_account(-1, 0);
 		}
 		return;
 	}
@@ -616,6 +618,7 @@ static void zram_free_page(struct zram *zram, size_t index)
 	atomic64_sub(zram_get_obj_size(meta, index),
 			&zram->stats.compr_data_size);
 	atomic64_dec(&zram->stats.pages_stored);
+	swap_compr_account(-1, -(long)zram_get_obj_size(meta, index));
 
 	meta->table[index].handle = 0;
 	zram_set_obj_size(meta, index, 0);
@@ -755,6 +758,7 @@ compress_again:
 		bit_spin_unlock(ZRAM_ACCESS, &meta->table[index].value);
 
 		atomic64_inc(&zram->stats.zero_pages);
+		swap_compr_account(1, 0);
 		ret = 0;
 		goto out;
 	}
@@ -853,6 +857,7 @@ compress_again:
 	/* Update stats */
 	atomic64_add(clen, &zram->stats.compr_data_size);
 	atomic64_inc(&zram->stats.pages_stored);
+	swap_compr_account(1, clen);
 out:
 	if (zstrm)
 		zcomp_strm_release(zram->comp, zstrm);
@@ -1098,6 +1103,9 @@ static void zram_reset_device(struct zram *zram)
 	wait_event(zram->io_done, atomic_read(&zram->refcount) == 0);
 
 	/* Reset stats */
+	swap_compr_account(-(long)(atomic64_read(&zram->stats.pages_stored) +
+				   atomic64_read(&zram->stats.zero_pages)),
+			   -(long)atomic64_read(&zram->stats.compr_data_size));
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zram->disksize = 0;
 
@@ -1326,6 +1334,7 @@ static int zram_add(void)
 	snprintf(zram->disk->disk_name, 16, "zram%d", device_id);
 
 	__set_bit(QUEUE_FLAG_FAST, &zram->disk->queue->queue_flags);
+	__set_bit(QUEUE_FLAG_COMPRESSED, &zram->disk->queue->queue_flags);
 	/* Actual capacity set using syfs (/sys/block/zram<id>/disksize */
 	set_capacity(zram->disk, 0);
 	/* zram devices sort of resembles non-rotational disks */
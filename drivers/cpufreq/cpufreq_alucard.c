@@ -123,6 +123,8 @@ static void ac_check_cpu(int cpu, unsigned int load)
 	unsigned int cpus_down_rate = ac_tuners->cpus_down_rate;
 	unsigned int index = 0;
 
+	load = sched_cpu_util_clamp(cpu, load, 100);
+
 	/* Get min, current, max indexes from current cpu policy */
 	alucard_get_cpu_frequency_table_cur(policy,
 				dbs_info->freq_table,
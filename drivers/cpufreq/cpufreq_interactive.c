@@ -439,6 +439,8 @@ static void cpufreq_interactive_timer(unsigned long data)
 		cputime_speedadj = pcpu->cputime_speedadj;
 		do_div(cputime_speedadj, delta_time);
 		tmploadadjfreq = (unsigned int)cputime_speedadj * 100;
+		tmploadadjfreq = sched_cpu_util_clamp(i, tmploadadjfreq,
+						ppol->policy->max * 100);
 		pcpu->loadadjfreq = tmploadadjfreq;
 		trace_cpufreq_interactive_cpuload(i, tmploadadjfreq /
 						  ppol->policy->cur);
@@ -193,6 +193,26 @@ static struct ion_iommu_map *ion_iommu_lookup(struct ion_buffer *buffer,
 	return NULL;
 }
 
+/*
+ * Tracks the pages of a cached buffer allocated with ION_FLAG_CPU_SYNC
+ * the cpu may have dirtied. Nothing is known about them yet, so they all
+ * start out dirty. Without the bitmap the buffer is simply not tracked.
+ */
+static void ion_buffer_track_cpu(struct ion_buffer *buffer)
+{
+	unsigned long npages = PAGE_ALIGN(buffer->size) >> PAGE_SHIFT;
+
+	if (!ION_IS_CACHED(buffer->flags) ||
+	    !(buffer->flags & ION_FLAG_CPU_SYNC) ||
+	    !buffer->heap->ops->cache_op)
+		return;
+
+	buffer->cpu_dirty = kcalloc(BITS_TO_LONGS(npages),
+				    sizeof(unsigned long), GFP_KERNEL);
+	if (buffer->cpu_dirty)
+		bitmap_fill(buffer->cpu_dirty, npages);
+}
+
 /* this function should only be called while dev->lock is held */
 static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 				     struct ion_device *dev,
@@ -228,6 +248,7 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 		return ERR_PTR(PTR_ERR(table));
 	}
 	buffer->sg_table = table;
+	ion_buffer_track_cpu(buffer);
 
 	mutex_init(&buffer->lock);
 	mutex_lock(&dev->buffer_lock);
@@ -283,6 +304,7 @@ static void ion_buffer_destroy(struct kref *kref)
 	mutex_lock(&dev->buffer_lock);
 	rb_erase(&buffer->node, &dev->buffers);
 	mutex_unlock(&dev->buffer_lock);
+	kfree(buffer->cpu_dirty);
 	kfree(buffer);
 }
 
@@ -848,6 +870,64 @@ void ion_unmap_kernel(struct ion_client *client, struct ion_handle *handle)
 }
 EXPORT_SYMBOL(ion_unmap_kernel);
 
+/*
+ * Bytes of cached buffers cache maintenance was done for, and bytes of
+ * cleans skipped because the cpu could not have dirtied them.
+ */
+static atomic64_t ion_cache_bytes_flushed = ATOMIC64_INIT(0);
+static atomic64_t ion_cache_bytes_avoided = ATOMIC64_INIT(0);
+
+/*
+ * Cache maintenance over [offset, offset + len) of a tracked buffer mapped
+ * at base: dirty_cmd for the pages the cpu may have dirtied, and clean_cmd,
+ * if any, for the others. Each run of pages in the same state takes a
+ * single cache op, which never leaves the range: base may be a user
+ * mapping that covers nothing more. Dirty pages the range covers whole
+ * are clean afterwards.
+ */
+static int ion_buffer_sync_range(struct ion_buffer *buffer, void *base,
+				 unsigned long offset, unsigned long len,
+				 unsigned int dirty_cmd, unsigned int clean_cmd)
+{
+	unsigned long end = PAGE_ALIGN(offset + len) >> PAGE_SHIFT;
+	unsigned long pg, next, from, to, first, last;
+	unsigned int cmd;
+	bool dirty;
+	int ret;
+
+	for (pg = offset >> PAGE_SHIFT; pg < end; pg = next) {
+		dirty = test_bit(pg, buffer->cpu_dirty);
+		if (dirty)
+			next = find_next_zero_bit(buffer->cpu_dirty, end, pg);
+		else
+			next = find_next_bit(buffer->cpu_dirty, end, pg);
+		from = max(offset, pg << PAGE_SHIFT);
+		to = min(offset + len, next << PAGE_SHIFT);
+
+		cmd = dirty ? dirty_cmd : clean_cmd;
+		if (!cmd) {
+			atomic64_add(to - from, &ion_cache_bytes_avoided);
+			continue;
+		}
+
+		ret = buffer->heap->ops->cache_op(buffer->heap, buffer,
+						  base + from, from, to - from,
+						  cmd);
+		if (ret)
+			return ret;
+		atomic64_add(to - from, &ion_cache_bytes_flushed);
+		if (!dirty)
+			continue;
+
+		/* a partial last page of the buffer counts as whole */
+		first = PAGE_ALIGN(from) >> PAGE_SHIFT;
+		last = to >= buffer->size ? next : to >> PAGE_SHIFT;
+		if (last > first)
+			bitmap_clear(buffer->cpu_dirty, first, last - first);
+	}
+	return 0;
+}
+
 int ion_do_cache_op(struct ion_client *client, struct ion_handle *handle,
 			void *uaddr, unsigned long offset, unsigned long len,
 			unsigned int cmd)
@@ -877,9 +957,23 @@ int ion_do_cache_op(struct ion_client *client, struct ion_handle *handle,
 		goto out;
 	}
 
+	/*
+	 * Only the pages the cpu may have dirtied need cleaning. Without a
+	 * mapping the heap works on the whole buffer, as it always did.
+	 */
+	if (buffer->cpu_dirty && uaddr && offset < buffer->size &&
+	    cmd != ION_IOC_INV_CACHES) {
+		len = min_t(unsigned long, len, buffer->size - offset);
+		ret = ion_buffer_sync_range(buffer, uaddr - offset, offset, len,
+				cmd, cmd == ION_IOC_CLEAN_CACHES ?
+				0 : ION_IOC_INV_CACHES);
+		goto out;
+	}
 
 	ret = buffer->heap->ops->cache_op(buffer->heap, buffer, uaddr,
 						offset, len, cmd);
+	if (!ret)
+		atomic64_add(len, &ion_cache_bytes_flushed);
 
 out:
 	mutex_unlock(&buffer->lock);
@@ -1207,12 +1301,58 @@ static void ion_dma_buf_kunmap(struct dma_buf *dmabuf, unsigned long offset,
 	return;
 }
 
+/*
+ * The cpu writes to a tracked buffer are bracketed by begin and end, by
+ * everyone that maps it: that is what its allocator promised by passing
+ * ION_FLAG_CPU_SYNC. Before reading, the cpu drops its lines for the
+ * range, writing back the ones it may have dirtied. Pages about to be
+ * written become dirty, and are cleaned when the write ends or when the
+ * buffer is next cleaned.
+ */
+static int ion_buffer_begin_cpu(struct ion_buffer *buffer, size_t start,
+				size_t len, enum dma_data_direction direction)
+{
+	int ret;
+
+	if (!buffer->cpu_dirty || start >= buffer->size)
+		return 0;
+	len = min(len, buffer->size - start);
+	if (!len)
+		return 0;
+
+	if (direction != DMA_TO_DEVICE) {
+		ret = ion_buffer_sync_range(buffer, buffer->vaddr, start, len,
+					    ION_IOC_CLEAN_INV_CACHES,
+					    ION_IOC_INV_CACHES);
+		if (ret)
+			return ret;
+	}
+	if (direction != DMA_FROM_DEVICE)
+		bitmap_set(buffer->cpu_dirty, start >> PAGE_SHIFT,
+			   (PAGE_ALIGN(start + len) >> PAGE_SHIFT) -
+			   (start >> PAGE_SHIFT));
+	return 0;
+}
+
+static void ion_buffer_end_cpu(struct ion_buffer *buffer, size_t start,
+			       size_t len, enum dma_data_direction direction)
+{
+	if (!buffer->cpu_dirty || direction == DMA_FROM_DEVICE ||
+	    start >= buffer->size)
+		return;
+	len = min(len, buffer->size - start);
+	if (len)
+		ion_buffer_sync_range(buffer, buffer->vaddr, start, len,
+				      ION_IOC_CLEAN_CACHES, 0);
+}
+
 static int ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf, size_t start,
 					size_t len,
 					enum dma_data_direction direction)
 {
 	struct ion_buffer *buffer = dmabuf->priv;
 	void *vaddr;
+	int ret;
 
 	if (!buffer->heap->ops->map_kernel) {
 		pr_err("%s: map kernel is not implemented by this heap.\n",
@@ -1222,12 +1362,15 @@ static int ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf, size_t start,
 
 	mutex_lock(&buffer->lock);
 	vaddr = ion_buffer_kmap_get(buffer);
+	if (IS_ERR_OR_NULL(vaddr)) {
+		mutex_unlock(&buffer->lock);
+		return vaddr ? PTR_ERR(vaddr) : -ENOMEM;
+	}
+	ret = ion_buffer_begin_cpu(buffer, start, len, direction);
+	if (ret)
+		ion_buffer_kmap_put(buffer);
 	mutex_unlock(&buffer->lock);
-	if (IS_ERR(vaddr))
-		return PTR_ERR(vaddr);
-	if (!vaddr)
-		return -ENOMEM;
-	return 0;
+	return ret;
 }
 
 static void ion_dma_buf_end_cpu_access(struct dma_buf *dmabuf, size_t start,
@@ -1237,6 +1380,7 @@ static void ion_dma_buf_end_cpu_access(struct dma_buf *dmabuf, size_t start,
 	struct ion_buffer *buffer = dmabuf->priv;
 
 	mutex_lock(&buffer->lock);
+	ion_buffer_end_cpu(buffer, start, len, direction);
 	ion_buffer_kmap_put(buffer);
 	mutex_unlock(&buffer->lock);
 }
@@ -1801,6 +1945,27 @@ static const struct file_operations debug_leak_fops = {
 	.release = single_release,
 };
 
+static int ion_debug_cache_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "bytes flushed: %lld\n",
+		   (long long)atomic64_read(&ion_cache_bytes_flushed));
+	seq_printf(s, "bytes avoided: %lld\n",
+		   (long long)atomic64_read(&ion_cache_bytes_avoided));
+	return 0;
+}
+
+static int ion_debug_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ion_debug_cache_show, inode->i_private);
+}
+
+static const struct file_operations debug_cache_fops = {
+	.open = ion_debug_cache_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 
 
 struct ion_device *ion_device_create(long (*custom_ioctl)
@@ -1837,6 +2002,8 @@ struct ion_device *ion_device_create(long (*custom_ioctl)
 	idev->clients = RB_ROOT;
 	debugfs_create_file("check_leaked_fds", 0664, idev->debug_root, idev,
 			    &debug_leak_fops);
+	debugfs_create_file("cache_stats", 0444, idev->debug_root, idev,
+			    &debug_cache_fops);
 	return idev;
 }
 
@@ -21,6 +21,7 @@
 #include <linux/errno.h>
 #include <linux/err.h>
 #include <linux/dma-mapping.h>
+#include <linux/dma-contiguous.h>
 #include <linux/msm_ion.h>
 #include <mach/iommu_domains.h>
 
@@ -98,6 +99,12 @@ static int ion_cma_allocate(struct ion_heap *heap, struct ion_buffer *buffer,
 			info->table, info->cpu_addr, info->handle, len))
 		goto free_table;
 
+	/*
+	 * Camera and video allocate their buffers in batches of one size:
+	 * have the next one evacuated while this one is being set up.
+	 */
+	dma_contiguous_prepare(dev, PAGE_ALIGN(len) >> PAGE_SHIFT);
+
 	/* keep this for memory release */
 	buffer->priv_virt = info;
 	dev_dbg(dev, "Allocate buffer %p\n", buffer);
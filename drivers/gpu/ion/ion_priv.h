@@ -81,6 +81,8 @@ struct ion_buffer *ion_handle_buffer(struct ion_handle *handle);
  * @vaddr:		the kenrel mapping if kmap_cnt is not zero
  * @dmap_cnt:		number of times the buffer is mapped for dma
  * @sg_table:		the sg table for the buffer if dmap_cnt is not zero
+ * @cpu_dirty:		bitmap of the pages the cpu may hold dirty cache lines
+ *			for, if the buffer was allocated with ION_FLAG_CPU_SYNC
 */
 struct ion_buffer {
 	struct kref ref;
@@ -102,6 +104,7 @@ struct ion_buffer {
 	unsigned int iommu_map_cnt;
 	struct rb_root iommu_maps;
 	int marked;
+	unsigned long *cpu_dirty;
 };
 
 /**
@@ -216,23 +216,48 @@ int ion_system_heap_cache_ops(struct ion_heap *heap, struct ion_buffer *buffer,
 	}
 
 	if (system_heap_has_outer_cache) {
-		unsigned long pstart;
+		unsigned long pstart = 0, pend = 0;
+		unsigned long first = 0, last = ULONG_MAX;
 		struct sg_table *table = buffer->priv_virt;
 		struct scatterlist *sg;
 		int i;
+
+		/* with a mapping, only the pages of the range it covers */
+		if (vaddr) {
+			if (!length)
+				return 0;
+			first = offset >> PAGE_SHIFT;
+			last = (offset + length - 1) >> PAGE_SHIFT;
+		}
 		for_each_sg(table->sgl, sg, table->nents, i) {
 			struct page *page = sg_page(sg);
-			pstart = page_to_phys(page);
+			unsigned long phys;
+
+			if (i < first)
+				continue;
+			if (i > last)
+				break;
+			phys = page_to_phys(page);
 			/*
 			 * If page -> phys is returning NULL, something
 			 * has really gone wrong...
 			 */
-			if (!pstart) {
+			if (!phys) {
 				WARN(1, "Could not translate virtual address to physical address\n");
 				return -EINVAL;
 			}
-			outer_cache_op(pstart, pstart + PAGE_SIZE);
+			/* one op for each physically contiguous run of pages */
+			if (phys == pend) {
+				pend += PAGE_SIZE;
+				continue;
+			}
+			if (pend)
+				outer_cache_op(pstart, pend);
+			pstart = phys;
+			pend = phys + PAGE_SIZE;
 		}
+		if (pend)
+			outer_cache_op(pstart, pend);
 	}
 	return 0;
 }
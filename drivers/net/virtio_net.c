@@ -26,6 +26,7 @@
 #include <linux/scatterlist.h>
 #include <linux/if_vlan.h>
 #include <linux/slab.h>
+#include <net/page_pool.h>
 
 static int napi_weight = 128;
 module_param(napi_weight, int, 0444);
@@ -75,6 +76,9 @@ struct virtnet_info {
 	/* Chain pages by the private ptr. */
 	struct page *pages;
 
+	/* Receive pages, recycled once the stack is done with them. */
+	struct page_pool *page_pool;
+
 	/* fragments + linear part + virtio header */
 	struct scatterlist rx_sg[MAX_SKB_FRAGS + 2];
 	struct scatterlist tx_sg[MAX_SKB_FRAGS + 2];
@@ -125,6 +129,11 @@ static struct page *get_a_page(struct virtnet_info *vi, gfp_t gfp_mask)
 		vi->pages = (struct page *)p->private;
 		/* clear private here, it is used to chain pages */
 		p->private = 0;
+	} else if (vi->page_pool) {
+		p = page_pool_alloc_pages(vi->page_pool, gfp_mask);
+		/* a recycled page may still have its old chain */
+		if (p)
+			p->private = 0;
 	} else
 		p = alloc_page(gfp_mask);
 	return p;
@@ -172,6 +181,9 @@ static struct sk_buff *page_to_skb(struct virtnet_info *vi,
 	if (unlikely(!skb))
 		return NULL;
 
+	if (vi->page_pool)
+		skb_mark_for_recycle(skb);
+
 	hdr = skb_vnet_hdr(skb);
 
 	if (vi->mergeable_rx_bufs) {
@@ -921,10 +933,46 @@ static void virtnet_get_drvinfo(struct net_device *dev,
 
 }
 
+static void virtnet_get_strings(struct net_device *dev, u32 stringset, u8 *buf)
+{
+	struct virtnet_info *vi = netdev_priv(dev);
+
+	if (stringset == ETH_SS_STATS && vi->page_pool)
+		page_pool_ethtool_stats_get_strings(buf);
+}
+
+static int virtnet_get_sset_count(struct net_device *dev, int sset)
+{
+	struct virtnet_info *vi = netdev_priv(dev);
+
+	switch (sset) {
+	case ETH_SS_STATS:
+		return vi->page_pool ? page_pool_ethtool_stats_get_count() : 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+static void virtnet_get_ethtool_stats(struct net_device *dev,
+				      struct ethtool_stats *stats, u64 *data)
+{
+	struct virtnet_info *vi = netdev_priv(dev);
+	struct page_pool_stats pp_stats;
+
+	if (!vi->page_pool)
+		return;
+
+	page_pool_get_stats(vi->page_pool, &pp_stats);
+	page_pool_ethtool_stats_get(data, &pp_stats);
+}
+
 static const struct ethtool_ops virtnet_ethtool_ops = {
 	.get_drvinfo = virtnet_get_drvinfo,
 	.get_link = ethtool_op_get_link,
 	.get_ringparam = virtnet_get_ringparam,
+	.get_strings = virtnet_get_strings,
+	.get_sset_count = virtnet_get_sset_count,
+	.get_ethtool_stats = virtnet_get_ethtool_stats,
 };
 
 #define MIN_MTU 68
@@ -1095,6 +1143,20 @@ static int virtnet_probe(struct virtio_device *vdev)
 	if (err)
 		goto free_stats;
 
+	/* Pages of big and mergeable buffers are recycled, if we can. */
+	if (vi->big_packets || vi->mergeable_rx_bufs) {
+		struct page_pool_params pp = {
+			.pool_size = virtqueue_get_impl_size(vi->rvq),
+			.nid = -1,
+		};
+
+		if (!vi->mergeable_rx_bufs)
+			pp.pool_size *= MAX_SKB_FRAGS + 2;
+		vi->page_pool = page_pool_create(&pp);
+		if (IS_ERR(vi->page_pool))
+			vi->page_pool = NULL;
+	}
+
 	err = register_netdev(dev);
 	if (err) {
 		pr_debug("virtio_net: registering device failed\n");
@@ -1127,6 +1189,8 @@ unregister:
 	unregister_netdev(dev);
 free_vqs:
 	vdev->config->del_vqs(vdev);
+	if (vi->page_pool)
+		page_pool_destroy(vi->page_pool);
 free_stats:
 	free_percpu(vi->stats);
 free:
@@ -1165,8 +1229,13 @@ static void remove_vq_common(struct virtnet_info *vi)
 
 	vi->vdev->config->del_vqs(vi->vdev);
 
-	while (vi->pages)
-		__free_pages(get_a_page(vi, GFP_KERNEL), 0);
+	while (vi->pages) {
+		struct page *page = get_a_page(vi, GFP_KERNEL);
+
+		if (vi->page_pool)
+			page_pool_release_page(vi->page_pool, page);
+		__free_pages(page, 0);
+	}
 }
 
 static void __devexit virtnet_remove(struct virtio_device *vdev)
@@ -1177,6 +1246,8 @@ static void __devexit virtnet_remove(struct virtio_device *vdev)
 
 	remove_vq_common(vi);
 
+	if (vi->page_pool)
+		page_pool_destroy(vi->page_pool);
 	free_percpu(vi->stats);
 	free_netdev(vi->dev);
 }
@@ -47,6 +47,7 @@
 #include <linux/show_mem_notifier.h>
 #include <linux/vmpressure.h>
 #include <linux/zcache.h>
+#include <linux/flight_recorder.h>
 
 #include <trace/events/memkill.h>
 #define CREATE_TRACE_POINTS
@@ -725,6 +726,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		trace_lmk_kill(selected->pid, selected->comm,
 				selected_oom_score_adj, selected_tasksize,
 				min_score_adj, sc->gfp_mask, zinfo);
+		flight_rec_log(FLIGHT_REC_LMK_KILL, selected->pid,
+			       selected_oom_score_adj, selected_tasksize);
 		set_tsk_thread_flag(selected, TIF_MEMDIE);
 		send_sig(SIGKILL, selected, 0);
 		rem += selected_tasksize;
@@ -36,6 +36,8 @@
 #include <linux/blkdev.h>
 #include <linux/compat.h>
 #include <linux/personality.h>
+#include <linux/cred.h>
+#include <linux/pagemap.h>
 
 #include <asm/kmap_types.h>
 #include <asm/uaccess.h>
@@ -108,6 +110,12 @@ struct kioctx {
 		spinlock_t	completion_lock;
 	} ____cacheline_aligned_in_smp;
 
+	struct {
+		spinlock_t	worker_lock;
+		struct list_head worker_reqs;	/* waiting for a worker */
+		int		nr_workers;
+	} ____cacheline_aligned_in_smp;
+
 	struct page		*internal_pages[AIO_RING_PAGES];
 };
 
@@ -115,11 +123,14 @@ struct kioctx {
 static DEFINE_SPINLOCK(aio_nr_lock);
 unsigned long aio_nr;		/* current system wide number of aio requests */
 unsigned long aio_max_nr = 0x10000; /* system wide maximum number of aio requests */
+int aio_max_workers = 4;	/* per context, 0 runs everything at submit */
 /*----end sysctl variables---*/
 
 static struct kmem_cache	*kiocb_cachep;
 static struct kmem_cache	*kioctx_cachep;
 
+static struct workqueue_struct *aio_wq;
+
 /* aio_setup
  *	Creates the slab caches used by the aio routines, panic on
  *	failure as this is done early during the boot sequence.
@@ -129,6 +140,9 @@ static int __init aio_setup(void)
 	kiocb_cachep = KMEM_CACHE(kiocb, SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 	kioctx_cachep = KMEM_CACHE(kioctx,SLAB_HWCACHE_ALIGN|SLAB_PANIC);
 
+	aio_wq = alloc_workqueue("aio", WQ_UNBOUND, 0);
+	BUG_ON(!aio_wq);
+
 	pr_debug("sizeof(struct page) = %zu\n", sizeof(struct page));
 
 	return 0;
@@ -371,8 +385,10 @@ static struct kioctx *ioctx_alloc(unsigned nr_events)
 	spin_lock_init(&ctx->completion_lock);
 	mutex_init(&ctx->ring_lock);
 	init_waitqueue_head(&ctx->wait);
+	spin_lock_init(&ctx->worker_lock);
 
 	INIT_LIST_HEAD(&ctx->active_reqs);
+	INIT_LIST_HEAD(&ctx->worker_reqs);
 
 	if (aio_setup_ring(ctx) < 0)
 		goto out_freectx;
@@ -1000,6 +1016,176 @@ static ssize_t aio_setup_single_vector(int rw, struct kiocb *kiocb)
 	return 0;
 }
 
+static void aio_finish_iocb(struct kiocb *req, ssize_t ret)
+{
+	if (ret != -EIOCBQUEUED) {
+		/*
+		 * There's no easy way to restart the syscall since other AIO's
+		 * may be already running. Just fail this IO with EINTR.
+		 */
+		if (unlikely(ret == -ERESTARTSYS || ret == -ERESTARTNOINTR ||
+			     ret == -ERESTARTNOHAND ||
+			     ret == -ERESTART_RESTARTBLOCK))
+			ret = -EINTR;
+		aio_complete(req, ret, 0);
+	}
+}
+
+/*
+ * Reads of data that is already in the page cache are cheaper done by
+ * the submitter right away than handed to a worker.  Larger reads are
+ * not looked up, the worker does them.
+ */
+#define AIO_INLINE_MAX_PAGES	64
+
+static bool aio_pages_cached(struct file *file, loff_t pos, size_t count)
+{
+	struct address_space *mapping = file->f_mapping;
+	loff_t isize = i_size_read(mapping->host);
+	pgoff_t index, end;
+	struct page *page;
+	bool uptodate;
+
+	if (pos >= isize || !count)
+		return true;
+	if (pos + count > isize)
+		count = isize - pos;
+
+	index = pos >> PAGE_CACHE_SHIFT;
+	end = (pos + count - 1) >> PAGE_CACHE_SHIFT;
+	if (end - index >= AIO_INLINE_MAX_PAGES)
+		return false;
+
+	for (; index <= end; index++) {
+		page = find_get_page(mapping, index);
+		if (!page)
+			return false;
+		uptodate = PageUptodate(page);
+		page_cache_release(page);
+		if (!uptodate)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Only O_DIRECT i/o is really asynchronous, buffered reads and writes of
+ * files and block devices block the submitter until they are done.
+ */
+static bool aio_should_offload(struct kiocb *req, int rw)
+{
+	struct file *file = req->ki_filp;
+	struct inode *inode = file->f_mapping->host;
+
+	if (!aio_max_workers || (file->f_flags & O_DIRECT))
+		return false;
+	if (!S_ISREG(inode->i_mode) && !S_ISBLK(inode->i_mode))
+		return false;
+	if (rw == READ && aio_pages_cached(file, req->ki_pos, req->ki_nbytes))
+		return false;
+	/*
+	 * The workers run with the kernel's RLIMIT_FSIZE, so a write that
+	 * is subject to the submitter's limit, and its SIGXFSZ, stays here.
+	 */
+	if (rw == WRITE && rlimit(RLIMIT_FSIZE) != RLIM_INFINITY)
+		return false;
+	return true;
+}
+
+static void aio_run_work(struct kiocb *req)
+{
+	struct file *file = req->ki_filp;
+	struct mm_struct *mm = req->ki_mm;
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	use_mm(mm);
+	old_cred = override_creds(req->ki_cred);
+
+	switch (req->ki_opcode) {
+	case IOCB_CMD_PREAD:
+	case IOCB_CMD_PREADV:
+		ret = aio_rw_vect_retry(req, READ, file->f_op->aio_read);
+		break;
+	case IOCB_CMD_PWRITE:
+	case IOCB_CMD_PWRITEV:
+		ret = aio_rw_vect_retry(req, WRITE, file->f_op->aio_write);
+		break;
+	case IOCB_CMD_FDSYNC:
+		ret = vfs_fsync(file, 1);
+		break;
+	case IOCB_CMD_FSYNC:
+		ret = vfs_fsync(file, 0);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	revert_creds(old_cred);
+	put_cred(req->ki_cred);
+	unuse_mm(mm);
+
+	aio_finish_iocb(req, ret);
+	mmput(mm);
+}
+
+/*
+ * An aio worker runs the request it was started for, then the ones queued
+ * on the context meanwhile, and exits when there are none left.  It holds
+ * a reference to the context so that the queue outlives the requests.
+ */
+static void aio_worker(struct work_struct *work)
+{
+	struct kiocb *req = container_of(work, struct kiocb, ki_work);
+	struct kioctx *ctx = req->ki_ctx;
+
+	do {
+		aio_run_work(req);
+
+		spin_lock(&ctx->worker_lock);
+		if (list_empty(&ctx->worker_reqs)) {
+			ctx->nr_workers--;
+			req = NULL;
+		} else {
+			req = list_first_entry(&ctx->worker_reqs,
+					       struct kiocb, ki_work_list);
+			list_del(&req->ki_work_list);
+		}
+		spin_unlock(&ctx->worker_lock);
+	} while (req);
+
+	put_ioctx(ctx);
+}
+
+/*
+ * Hands the request to a worker of its context, starting one unless
+ * aio_max_workers of them are running already.
+ */
+static void aio_queue_work(struct kiocb *req)
+{
+	struct kioctx *ctx = req->ki_ctx;
+	bool start = false;
+
+	atomic_inc(&current->mm->mm_users);
+	req->ki_mm = current->mm;
+	req->ki_cred = get_current_cred();
+
+	spin_lock(&ctx->worker_lock);
+	if (ctx->nr_workers < aio_max_workers || !ctx->nr_workers) {
+		ctx->nr_workers++;
+		start = true;
+	} else
+		list_add_tail(&req->ki_work_list, &ctx->worker_reqs);
+	spin_unlock(&ctx->worker_lock);
+
+	if (start) {
+		atomic_inc(&ctx->users);
+		INIT_WORK(&req->ki_work, aio_worker);
+		queue_work(aio_wq, &req->ki_work);
+	}
+}
+
 /*
  * aio_setup_iocb:
  *	Performs the initial checks and aio retry method
@@ -1048,21 +1234,26 @@ rw_common:
 		req->ki_nbytes = ret;
 		req->ki_left = ret;
 
+		if (aio_should_offload(req, rw)) {
+			aio_queue_work(req);
+			return 0;
+		}
+
 		ret = aio_rw_vect_retry(req, rw, rw_op);
 		break;
 
 	case IOCB_CMD_FDSYNC:
-		if (!file->f_op->aio_fsync)
-			return -EINVAL;
-
-		ret = file->f_op->aio_fsync(req, 1);
-		break;
-
 	case IOCB_CMD_FSYNC:
-		if (!file->f_op->aio_fsync)
-			return -EINVAL;
+		if (!file->f_op->aio_fsync) {
+			if (!aio_max_workers || !file->f_op->fsync)
+				return -EINVAL;
+
+			aio_queue_work(req);
+			return 0;
+		}
 
-		ret = file->f_op->aio_fsync(req, 0);
+		ret = file->f_op->aio_fsync(req,
+				req->ki_opcode == IOCB_CMD_FDSYNC);
 		break;
 
 	default:
@@ -1070,18 +1261,7 @@ rw_common:
 		return -EINVAL;
 	}
 
-	if (ret != -EIOCBQUEUED) {
-		/*
-		 * There's no easy way to restart the syscall since other AIO's
-		 * may be already running. Just fail this IO with EINTR.
-		 */
-		if (unlikely(ret == -ERESTARTSYS || ret == -ERESTARTNOINTR ||
-			     ret == -ERESTARTNOHAND ||
-			     ret == -ERESTART_RESTARTBLOCK))
-			ret = -EINTR;
-		aio_complete(req, ret, 0);
-	}
-
+	aio_finish_iocb(req, ret);
 	return 0;
 }
 
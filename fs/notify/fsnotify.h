@@ -8,6 +8,8 @@
 
 /* destroy all events sitting in this groups notification queue */
 extern void fsnotify_flush_notify(struct fsnotify_group *group);
+/* expiry of the group wakeup timer, wakes the readers */
+extern void fsnotify_wakeup_timer_fn(unsigned long data);
 
 /* protects reads of inode and vfsmount marks list */
 extern struct srcu_struct fsnotify_mark_srcu;
@@ -33,6 +33,8 @@
  */
 void fsnotify_final_destroy_group(struct fsnotify_group *group)
 {
+	del_timer_sync(&group->wakeup_timer);
+
 	if (group->ops->free_group_priv)
 		group->ops->free_group_priv(group);
 
@@ -94,6 +96,8 @@ struct fsnotify_group *fsnotify_alloc_group(const struct fsnotify_ops *ops)
 	INIT_LIST_HEAD(&group->notification_list);
 	init_waitqueue_head(&group->notification_waitq);
 	group->max_events = UINT_MAX;
+	setup_timer(&group->wakeup_timer, fsnotify_wakeup_timer_fn,
+		    (unsigned long)group);
 
 	mutex_init(&group->mark_mutex);
 	INIT_LIST_HEAD(&group->marks_list);
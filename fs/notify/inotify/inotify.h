@@ -12,6 +12,7 @@ struct inotify_event_private_data {
 struct inotify_inode_mark {
 	struct fsnotify_mark fsn_mark;
 	int wd;
+	bool coalesce;		/* IN_COALESCE */
 };
 
 extern void inotify_ignored_and_remove_idr(struct fsnotify_mark *fsn_mark,
@@ -89,6 +89,45 @@ static struct fsnotify_event *inotify_merge(struct list_head *list,
 	return last_event;
 }
 
+/*
+ * How far back a coalescing watch looks for an identical event.  This bounds
+ * the work done under the notification mutex for every event.
+ */
+#define INOTIFY_COALESCE_SCAN	128
+
+/*
+ * For IN_COALESCE watches: merge into the last pending event about the same
+ * inode if it is identical.  Events about other inodes may sit in between,
+ * but nothing is merged past a different event about this inode, so the
+ * listener still sees the events of a file in order.
+ */
+static struct fsnotify_event *inotify_coalesce(struct list_head *list,
+					       struct fsnotify_event *event)
+{
+	struct fsnotify_event_holder *holder;
+	struct fsnotify_event *old_event = NULL;
+	unsigned int scanned = 0;
+
+	/* and the list better be locked by something too */
+	spin_lock(&event->lock);
+
+	list_for_each_entry_reverse(holder, list, event_list) {
+		if (scanned++ >= INOTIFY_COALESCE_SCAN)
+			break;
+		if (holder->event->to_tell != event->to_tell)
+			continue;
+		if (event_compare(holder->event, event)) {
+			old_event = holder->event;
+			fsnotify_get_event(old_event);
+		}
+		break;
+	}
+
+	spin_unlock(&event->lock);
+
+	return old_event;
+}
+
 static int inotify_handle_event(struct fsnotify_group *group,
 				struct fsnotify_mark *inode_mark,
 				struct fsnotify_mark *vfsmount_mark,
@@ -122,7 +161,12 @@ static int inotify_handle_event(struct fsnotify_group *group,
 	fsn_event_priv->group = group;
 	event_priv->wd = wd;
 
-	added_event = fsnotify_add_notify_event(group, event, fsn_event_priv, inotify_merge);
+	if (i_mark->coalesce)
+		added_event = fsnotify_add_deferred_event(group, event, fsn_event_priv,
+							  inotify_coalesce);
+	else
+		added_event = fsnotify_add_notify_event(group, event, fsn_event_priv,
+							inotify_merge);
 	if (added_event) {
 		inotify_free_event_priv(fsn_event_priv);
 		if (!IS_ERR(added_event))
@@ -48,6 +48,8 @@
 static int inotify_max_user_instances __read_mostly;
 static int inotify_max_queued_events __read_mostly;
 static int inotify_max_user_watches __read_mostly;
+static int inotify_coalesce_delay_ms __read_mostly;
+static int inotify_coalesce_batch __read_mostly;
 
 static struct kmem_cache *inotify_inode_mark_cachep __read_mostly;
 struct kmem_cache *event_priv_cachep __read_mostly;
@@ -83,6 +85,22 @@ ctl_table inotify_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= &zero
 	},
+	{
+		.procname	= "coalesce_delay_ms",
+		.data		= &inotify_coalesce_delay_ms,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero
+	},
+	{
+		.procname	= "coalesce_batch",
+		.data		= &inotify_coalesce_batch,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero
+	},
 	{ }
 };
 #endif /* CONFIG_SYSCTL */
@@ -578,10 +596,13 @@ static int inotify_update_existing_watch(struct fsnotify_group *group,
 	spin_lock(&fsn_mark->lock);
 
 	old_mask = fsn_mark->mask;
-	if (add)
+	if (add) {
 		fsnotify_set_mark_mask_locked(fsn_mark, (fsn_mark->mask | mask));
-	else
+		i_mark->coalesce |= !!(arg & IN_COALESCE);
+	} else {
 		fsnotify_set_mark_mask_locked(fsn_mark, mask);
+		i_mark->coalesce = !!(arg & IN_COALESCE);
+	}
 	new_mask = fsn_mark->mask;
 
 	spin_unlock(&fsn_mark->lock);
@@ -626,6 +647,7 @@ static int inotify_new_watch(struct fsnotify_group *group,
 	fsnotify_init_mark(&tmp_i_mark->fsn_mark, inotify_free_mark);
 	tmp_i_mark->fsn_mark.mask = mask;
 	tmp_i_mark->wd = -1;
+	tmp_i_mark->coalesce = !!(arg & IN_COALESCE);
 
 	ret = -ENOSPC;
 	if (atomic_read(&group->inotify_data.user->inotify_watches) >= inotify_max_user_watches)
@@ -686,6 +708,8 @@ static struct fsnotify_group *inotify_new_group(unsigned int max_events)
 		return group;
 
 	group->max_events = max_events;
+	group->wakeup_delay = msecs_to_jiffies(inotify_coalesce_delay_ms);
+	group->wakeup_batch = inotify_coalesce_batch;
 
 	spin_lock_init(&group->inotify_data.idr_lock);
 	idr_init(&group->inotify_data.idr);
@@ -849,7 +873,7 @@ static int __init inotify_user_setup(void)
 	BUILD_BUG_ON(IN_ISDIR != FS_ISDIR);
 	BUILD_BUG_ON(IN_ONESHOT != FS_IN_ONESHOT);
 
-	BUG_ON(hweight32(ALL_INOTIFY_BITS) != 21);
+	BUG_ON(hweight32(ALL_INOTIFY_BITS) != 22);
 
 	inotify_inode_mark_cachep = KMEM_CACHE(inotify_inode_mark, SLAB_PANIC);
 	event_priv_cachep = KMEM_CACHE(inotify_event_private_data, SLAB_PANIC);
@@ -857,6 +881,8 @@ static int __init inotify_user_setup(void)
 	inotify_max_queued_events = 16384;
 	inotify_max_user_instances = 128;
 	inotify_max_user_watches = 8192;
+	inotify_coalesce_delay_ms = 50;
+	inotify_coalesce_batch = 256;
 
 	return 0;
 }
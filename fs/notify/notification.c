@@ -132,15 +132,32 @@ struct fsnotify_event_private_data *fsnotify_remove_priv_from_event(struct fsnot
 	return priv;
 }
 
+static void fsnotify_wakeup(struct fsnotify_group *group)
+{
+	wake_up(&group->notification_waitq);
+	kill_fasync(&group->fsn_fa, SIGIO, POLL_IN);
+}
+
+void fsnotify_wakeup_timer_fn(unsigned long data)
+{
+	fsnotify_wakeup((struct fsnotify_group *)data);
+}
+
 /*
  * Add an event to the group notification queue.  The group can later pull this
  * event off the queue to deal with.  If the event is successfully added to the
  * group's notification queue, a reference is taken on event.
+ *
+ * With @defer, readers are not woken right away but when the wakeup timer of
+ * the group expires, unless the queue already holds wakeup_batch events.  A
+ * reader busy with a flood of events then handles them in batches.
  */
-struct fsnotify_event *fsnotify_add_notify_event(struct fsnotify_group *group, struct fsnotify_event *event,
-						 struct fsnotify_event_private_data *priv,
-						 struct fsnotify_event *(*merge)(struct list_head *,
-										 struct fsnotify_event *))
+static struct fsnotify_event *__fsnotify_add_notify_event(struct fsnotify_group *group,
+							  struct fsnotify_event *event,
+							  struct fsnotify_event_private_data *priv,
+							  struct fsnotify_event *(*merge)(struct list_head *,
+											  struct fsnotify_event *),
+							  bool defer)
 {
 	struct fsnotify_event *return_event = NULL;
 	struct fsnotify_event_holder *holder = NULL;
@@ -222,13 +239,37 @@ alloc_holder:
 	if (priv)
 		list_add_tail(&priv->event_list, &event->private_data_list);
 	spin_unlock(&event->lock);
+
+	if (defer && group->wakeup_delay && event != q_overflow_event &&
+	    group->q_len < group->wakeup_batch) {
+		if (!timer_pending(&group->wakeup_timer))
+			mod_timer(&group->wakeup_timer,
+				  jiffies + group->wakeup_delay);
+		mutex_unlock(&group->notification_mutex);
+		return return_event;
+	}
 	mutex_unlock(&group->notification_mutex);
 
-	wake_up(&group->notification_waitq);
-	kill_fasync(&group->fsn_fa, SIGIO, POLL_IN);
+	fsnotify_wakeup(group);
 	return return_event;
 }
 
+struct fsnotify_event *fsnotify_add_notify_event(struct fsnotify_group *group, struct fsnotify_event *event,
+						 struct fsnotify_event_private_data *priv,
+						 struct fsnotify_event *(*merge)(struct list_head *,
+										 struct fsnotify_event *))
+{
+	return __fsnotify_add_notify_event(group, event, priv, merge, false);
+}
+
+struct fsnotify_event *fsnotify_add_deferred_event(struct fsnotify_group *group, struct fsnotify_event *event,
+						   struct fsnotify_event_private_data *priv,
+						   struct fsnotify_event *(*merge)(struct list_head *,
+										   struct fsnotify_event *))
+{
+	return __fsnotify_add_notify_event(group, event, priv, merge, true);
+}
+
 /*
  * Remove and return the first event from the notification list.  There is a
  * reference held on this event since it was on the list.  It is the responsibility
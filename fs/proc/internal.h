@@ -155,6 +155,8 @@ extern int proc_pid_status(struct seq_file *, struct pid_namespace *,
 			   struct pid *, struct task_struct *);
 extern int proc_pid_statm(struct seq_file *, struct pid_namespace *,
 			  struct pid *, struct task_struct *);
+extern int proc_pid_footprint(struct seq_file *, struct pid_namespace *,
+			      struct pid *, struct task_struct *);
 
 /*
  * base.c
@@ -298,3 +300,4 @@ extern unsigned long task_statm(struct mm_struct *,
 				unsigned long *, unsigned long *,
 				unsigned long *, unsigned long *);
 extern void task_mem(struct seq_file *, struct mm_struct *);
+extern void task_footprint(struct seq_file *, struct mm_struct *);
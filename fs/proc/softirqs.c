@@ -1,26 +1,47 @@
 #include <linux/init.h>
 #include <linux/kernel_stat.h>
+#include <linux/math64.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 
 /*
- * /proc/softirqs  ... display the number of softirqs
+ * /proc/softirqs  ... display the number of softirqs, and with
+ * CONFIG_SOFTIRQ_THREADS the time spent in them
  */
 static int show_softirqs(struct seq_file *p, void *v)
 {
-	int i, j;
+	int i, j, width = 12;
+#ifdef CONFIG_SOFTIRQ_THREADS
+	char name[32];
 
-	seq_puts(p, "                    ");
+	/* room for the longest name with its _us suffix */
+	for (i = 0; i < NR_SOFTIRQS; i++)
+		width = max_t(int, width, strlen(softirq_to_name[i]) + 3);
+#endif
+
+	seq_printf(p, "%*s", width + 8, "");
 	for_each_possible_cpu(i)
 		seq_printf(p, "CPU%-8d", i);
 	seq_putc(p, '\n');
 
 	for (i = 0; i < NR_SOFTIRQS; i++) {
-		seq_printf(p, "%12s:", softirq_to_name[i]);
+		seq_printf(p, "%*s:", width, softirq_to_name[i]);
 		for_each_possible_cpu(j)
 			seq_printf(p, " %10u", kstat_softirqs_cpu(i, j));
 		seq_putc(p, '\n');
 	}
+#ifdef CONFIG_SOFTIRQ_THREADS
+	/* time spent in the handlers, in us */
+	for (i = 0; i < NR_SOFTIRQS; i++) {
+		snprintf(name, sizeof(name), "%s_us", softirq_to_name[i]);
+		seq_printf(p, "%*s:", width, name);
+		for_each_possible_cpu(j)
+			seq_printf(p, " %10llu",
+				   div_u64(softirq_runtime_cpu(i, j),
+					   NSEC_PER_USEC));
+		seq_putc(p, '\n');
+	}
+#endif
 	return 0;
 }
 
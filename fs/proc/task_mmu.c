@@ -68,6 +68,37 @@ void task_mem(struct seq_file *m, struct mm_struct *mm)
 		swap << (PAGE_SHIFT-10));
 }
 
+/*
+ * Memory footprint from the mm counters only: no VMA or page table walk
+ * and no mmap_sem, so it is cheap enough to poll for many processes.
+ * The swap figures are estimates based on system-wide swap sharing and
+ * on the compression ratio reported by compressed swap backends.
+ */
+void task_footprint(struct seq_file *m, struct mm_struct *mm)
+{
+	unsigned long anon, file, swap, swap_pss, swap_compr;
+
+	anon = get_mm_counter(mm, MM_ANONPAGES);
+	file = get_mm_counter(mm, MM_FILEPAGES);
+	swap = get_mm_counter(mm, MM_SWAPENTS);
+	swap_pss = swap_pss_estimate(swap);
+	/* only what sits on a compressed device has a compressed size */
+	swap_compr = swap_pss_estimate(get_mm_counter(mm, MM_SWAPENTS_COMPR));
+	seq_printf(m,
+		"Rss:\t%8lu kB\n"
+		"RssAnon:\t%8lu kB\n"
+		"RssFile:\t%8lu kB\n"
+		"Swap:\t%8lu kB\n"
+		"SwapPss:\t%8lu kB\n"
+		"SwapCompressed:\t%8lu kB\n",
+		(anon + file) << (PAGE_SHIFT-10),
+		anon << (PAGE_SHIFT-10),
+		file << (PAGE_SHIFT-10),
+		swap << (PAGE_SHIFT-10),
+		swap_pss << (PAGE_SHIFT-10),
+		swap_compr_estimate(swap_compr) >> 10);
+}
+
 unsigned long task_vsize(struct mm_struct *mm)
 {
 	return PAGE_SIZE * mm->total_vm;
@@ -84,6 +84,15 @@ struct kiocb {
 	 * this is the underlying eventfd context to deliver events to.
 	 */
 	struct eventfd_ctx	*ki_eventfd;
+
+	/*
+	 * Requests that would block the submitter are run by an aio
+	 * worker, in the mm and with the credentials of the submitter.
+	 */
+	struct work_struct	ki_work;
+	struct list_head	ki_work_list;
+	struct mm_struct	*ki_mm;
+	const struct cred	*ki_cred;
 };
 
 static inline bool is_sync_kiocb(struct kiocb *kiocb)
@@ -134,5 +143,6 @@ static inline struct kiocb *list_kiocb(struct list_head *h)
 /* for sysctl: */
 extern unsigned long aio_nr;
 extern unsigned long aio_max_nr;
+extern int aio_max_workers;
 
 #endif /* __LINUX__AIO_H */
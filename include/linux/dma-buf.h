@@ -24,6 +24,39 @@
 #ifndef __DMA_BUF_H__
 #define __DMA_BUF_H__
 
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/**
+ * struct dma_buf_sync - brackets cpu accesses to a mmap'ed buffer
+ * @flags: DMA_BUF_SYNC_START or DMA_BUF_SYNC_END, or'ed with the kind of
+ *	   access: DMA_BUF_SYNC_READ, DMA_BUF_SYNC_WRITE or DMA_BUF_SYNC_RW
+ * @offset: start of the range accessed
+ * @len: length of the range accessed, 0 for up to the end of the buffer
+ *
+ * Lets the exporter do cache maintenance only for the range and the kind
+ * of access userspace actually does. Each START must be followed by an
+ * END for the same range and access once the cpu is done.
+ */
+struct dma_buf_sync {
+	__u64 flags;
+	__u64 offset;
+	__u64 len;
+};
+
+#define DMA_BUF_SYNC_READ	(1 << 0)
+#define DMA_BUF_SYNC_WRITE	(2 << 0)
+#define DMA_BUF_SYNC_RW		(DMA_BUF_SYNC_READ | DMA_BUF_SYNC_WRITE)
+#define DMA_BUF_SYNC_START	(0 << 2)
+#define DMA_BUF_SYNC_END	(1 << 2)
+#define DMA_BUF_SYNC_VALID_FLAGS_MASK \
+	(DMA_BUF_SYNC_RW | DMA_BUF_SYNC_END)
+
+#define DMA_BUF_BASE		'b'
+#define DMA_BUF_IOCTL_SYNC	_IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+
+#ifdef __KERNEL__
+
 #include <linux/file.h>
 #include <linux/err.h>
 #include <linux/scatterlist.h>
@@ -115,6 +148,7 @@ struct dma_buf_ops {
  * @exp_name: name of the exporter; useful for debugging.
  * @list_node: node for dma_buf accounting and debugging.
  * @priv: exporter specific private data for this buffer object.
+ * @user_cpu_access: cpu accesses userspace began and has not ended yet.
  */
 struct dma_buf {
 	size_t size;
@@ -128,6 +162,7 @@ struct dma_buf {
 	const char *exp_name;
 	struct list_head list_node;
 	void *priv;
+	unsigned int user_cpu_access;
 };
 
 /**
@@ -196,4 +231,7 @@ void *dma_buf_vmap(struct dma_buf *);
 void dma_buf_vunmap(struct dma_buf *, void *vaddr);
 int dma_buf_debugfs_create_file(const char *name,
 				int (*write)(struct seq_file *));
+
+#endif /* __KERNEL__ */
+
 #endif /* __DMA_BUF_H__ */
@@ -156,6 +156,12 @@ static inline phys_addr_t cma_get_base(struct device *dev)
 
 #endif
 
+#ifdef CONFIG_CMA_EVACUATE
+void dma_contiguous_prepare(struct device *dev, int count);
+#else
+static inline void dma_contiguous_prepare(struct device *dev, int count) { }
+#endif
+
 #endif
 
 #endif
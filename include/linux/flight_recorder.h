@@ -0,0 +1,62 @@
+#ifndef _LINUX_FLIGHT_RECORDER_H
+#define _LINUX_FLIGHT_RECORDER_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/*
+ * Always-on scheduler/power flight recorder.
+ *
+ * Compact binary records are kept in a fixed size per-cpu ring buffer.
+ * FLIGHT_REC_IOC_SNAPSHOT freezes the recorded history, keeping only the
+ * given number of seconds (0 for all of it), and read() on the device then
+ * returns it as struct flight_rec_entry, oldest first.
+ */
+
+enum flight_rec_type {
+	FLIGHT_REC_SCHED_SWITCH = 1,	/* pid: next, arg0: prev, arg1: state */
+	FLIGHT_REC_SCHED_WAKEUP,	/* pid: woken, arg0: cpu */
+	FLIGHT_REC_CPU_FREQ,		/* arg0: kHz, arg1: cpu */
+	FLIGHT_REC_IDLE_ENTER,		/* arg0: state, arg1: cpu */
+	FLIGHT_REC_IDLE_EXIT,		/* arg1: cpu */
+	FLIGHT_REC_IRQ_ENTER,		/* arg0: irq */
+	FLIGHT_REC_IRQ_EXIT,		/* arg0: irq, arg1: handled */
+	FLIGHT_REC_BINDER_TRANSACTION,	/* pid: from, arg0: to, arg1: id */
+	FLIGHT_REC_BINDER_REPLY,	/* pid: from, arg0: to, arg1: id */
+	FLIGHT_REC_BINDER_RECEIVED,	/* pid: to, arg1: id */
+	FLIGHT_REC_LMK_KILL,		/* pid: victim, arg0: adj, arg1: pages */
+};
+
+struct flight_rec_entry {
+	__u64 ts;			/* ns, trace clock */
+	__u16 cpu;
+	__u8 type;
+	__u8 pad;
+	__u32 pid;
+	__u32 arg0;
+	__u32 arg1;
+};
+
+#define FLIGHT_REC_IOC_MAGIC		'F'
+#define FLIGHT_REC_IOC_SNAPSHOT		_IOW(FLIGHT_REC_IOC_MAGIC, 1, __u32)
+
+#ifdef __KERNEL__
+
+#ifdef CONFIG_FLIGHT_RECORDER
+#include <linux/jump_label.h>
+
+extern struct static_key flight_rec_key;
+extern void __flight_rec_log(u8 type, u32 pid, u32 arg0, u32 arg1);
+
+static inline void flight_rec_log(u8 type, u32 pid, u32 arg0, u32 arg1)
+{
+	if (static_key_false(&flight_rec_key))
+		__flight_rec_log(type, pid, arg0, arg1);
+}
+#else
+static inline void flight_rec_log(u8 type, u32 pid, u32 arg0, u32 arg1) { }
+#endif
+
+#endif /* __KERNEL__ */
+
+#endif /* _LINUX_FLIGHT_RECORDER_H */
@@ -83,13 +83,32 @@ static inline bool try_to_freeze(void)
 extern bool freeze_task(struct task_struct *p);
 extern bool set_freezable(void);
 
+/* Batched freeze requests, called with interrupts disabled */
+extern void freezer_batch_begin(void);
+extern void freezer_batch_end(void);
+extern bool __freeze_task_lazy(struct task_struct *p);
+extern void __thaw_task_locked(struct task_struct *p);
+
+/*
+ * A user task that got a lazy freeze request while sleeping interruptibly
+ * was left asleep. It cannot get back to userspace without entering the
+ * refrigerator, so it is as good as frozen.
+ */
+static inline bool freezer_parked(struct task_struct *p)
+{
+	return !(p->flags & PF_KTHREAD) && (p->state & TASK_INTERRUPTIBLE) &&
+		test_tsk_thread_flag(p, TIF_SIGPENDING);
+}
+
 #ifdef CONFIG_CGROUP_FREEZER
 extern bool cgroup_freezing(struct task_struct *task);
+extern void cgroup_freezer_frozen(struct task_struct *task);
 #else /* !CONFIG_CGROUP_FREEZER */
 static inline bool cgroup_freezing(struct task_struct *task)
 {
 	return false;
 }
+static inline void cgroup_freezer_frozen(struct task_struct *task) { }
 #endif /* !CONFIG_CGROUP_FREEZER */
 
 /*
@@ -14,6 +14,7 @@
 #include <linux/list.h>
 #include <linux/path.h> /* struct path */
 #include <linux/spinlock.h>
+#include <linux/timer.h>
 #include <linux/types.h>
 
 #include <linux/atomic.h>
@@ -132,6 +133,14 @@ struct fsnotify_group {
 	wait_queue_head_t notification_waitq;	/* read() on the notification file blocks on this waitq */
 	unsigned int q_len;			/* events on the queue */
 	unsigned int max_events;		/* maximum events allowed on the list */
+	/*
+	 * Readers are woken at most every wakeup_delay jiffies for deferred
+	 * events, or as soon as wakeup_batch events are queued.  See
+	 * fsnotify_add_deferred_event().
+	 */
+	struct timer_list wakeup_timer;
+	unsigned long wakeup_delay;
+	unsigned int wakeup_batch;
 	/*
 	 * Valid fsnotify group priorities.  Events are send in order from highest
 	 * priority to lowest priority.  We default to the lowest priority.
@@ -383,6 +392,12 @@ extern struct fsnotify_event *fsnotify_add_notify_event(struct fsnotify_group *g
 							struct fsnotify_event_private_data *priv,
 							struct fsnotify_event *(*merge)(struct list_head *,
 											struct fsnotify_event *));
+/* same, but the readers may be woken later */
+extern struct fsnotify_event *fsnotify_add_deferred_event(struct fsnotify_group *group,
+							  struct fsnotify_event *event,
+							  struct fsnotify_event_private_data *priv,
+							  struct fsnotify_event *(*merge)(struct list_head *,
+											  struct fsnotify_event *));
 /* true if the group notification queue is empty */
 extern bool fsnotify_notify_queue_is_empty(struct fsnotify_group *group);
 /* return, but do not dequeue the first event on the notification queue */
@@ -16,6 +16,7 @@
 #include <linux/workqueue.h>
 
 #include <linux/atomic.h>
+#include <linux/jump_label.h>
 #include <asm/ptrace.h>
 
 /*
@@ -409,6 +410,11 @@ enum
  */
 extern char *softirq_to_name[NR_SOFTIRQS];
 
+#ifdef CONFIG_SOFTIRQ_THREADS
+/* ns spent in the handler of softirq @nr on @cpu */
+extern u64 softirq_runtime_cpu(unsigned int nr, int cpu);
+#endif
+
 /* softirq mask and active fields moved to irq_cpustat_t in
  * asm/hardirq.h to get better cache usage.  KAO
  */
@@ -419,6 +425,20 @@ struct softirq_action
 };
 
 asmlinkage void do_softirq(void);
+
+#ifdef CONFIG_IRQ_BALANCE
+extern struct static_key irq_balance_key;
+extern void irq_balance_account_softirq(u64 start);
+
+/* Whether the irq balancer measures time spent in interrupt context */
+static inline bool irq_balance_enabled(void)
+{
+	return static_key_false(&irq_balance_key);
+}
+#else
+static inline void irq_balance_account_softirq(u64 start) { }
+static inline bool irq_balance_enabled(void) { return false; }
+#endif
 asmlinkage void __do_softirq(void);
 extern void open_softirq(int nr, void (*action)(struct softirq_action *));
 extern void softirq_init(void);
@@ -59,6 +59,12 @@ enum ion_heap_type {
 					   cached, ion will do cache
 					   maintenance when the buffer is
 					   mapped for dma */
+#define ION_FLAG_CPU_SYNC (1 << 4)	/* every cpu access to this cached
+					   buffer is bracketed with
+					   DMA_BUF_IOCTL_SYNC or
+					   dma_buf_begin/end_cpu_access, so
+					   ion may skip cleaning pages the
+					   cpu did not write */
 
 #ifdef __KERNEL__
 #include <linux/err.h>
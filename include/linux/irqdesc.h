@@ -14,6 +14,18 @@ struct timer_rand_state;
 struct module;
 struct irq_desc;
 
+#ifdef CONFIG_IRQ_BALANCE
+struct irq_balance_stat {
+	u64			ns;		/* handler time, all in all */
+	u64			last_ns;	/* ns at the last balancing pass */
+	u64			load;		/* us per second, last pass */
+	unsigned int		cpu;		/* cpu that last handled it */
+	unsigned int		moves;
+	unsigned long		last_move;	/* jiffies */
+	bool			pinned;		/* left alone by the balancer */
+};
+#endif
+
 /**
  * struct irq_desc - interrupt descriptor
  * @irq_data:		per irq and chip data passed down to chip functions
@@ -42,6 +54,7 @@ struct irq_desc;
  * @wait_for_threads:	wait queue for sync_irq to wait for threaded handlers
  * @dir:		/proc/irq/ procfs entry
  * @name:		flow handler name for /proc/interrupts output
+ * @balance:		handler time and state for the in-kernel irq balancer
  */
 struct irq_desc {
 	struct irq_data		irq_data;
@@ -76,6 +89,9 @@ struct irq_desc {
 	wait_queue_head_t       wait_for_threads;
 #ifdef CONFIG_PROC_FS
 	struct proc_dir_entry	*dir;
+#endif
+#ifdef CONFIG_IRQ_BALANCE
+	struct irq_balance_stat	balance;
 #endif
 	int			parent_irq;
 	struct module		*owner;
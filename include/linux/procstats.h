@@ -0,0 +1,106 @@
+/* procstats.h - exporting per-process statistics in bulk
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of version 2.1 of the GNU Lesser General Public License
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it would be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef _LINUX_PROCSTATS_H
+#define _LINUX_PROCSTATS_H
+
+#include <linux/types.h>
+#include <linux/taskstats.h>
+#include <linux/cgroupstats.h>
+
+/*
+ * Fields of struct procstats, selected with PROCSTATS_CMD_ATTR_MASK.
+ * Fields not requested are left zero; the pid is always filled in.
+ */
+#define PROCSTATS_F_IDS		(1 << 0)	/* ppid, uid */
+#define PROCSTATS_F_COMM	(1 << 1)	/* comm */
+#define PROCSTATS_F_STATE	(1 << 2)	/* state */
+#define PROCSTATS_F_SCHED	(1 << 3)	/* nice, policy, nr_threads */
+#define PROCSTATS_F_OOM		(1 << 4)	/* oom_score_adj */
+#define PROCSTATS_F_CPU		(1 << 5)	/* times and faults */
+#define PROCSTATS_F_MEM		(1 << 6)	/* vsize, rss, swap */
+#define PROCSTATS_F_ALL		((1 << 7) - 1)
+
+/*
+ * Per-process data returned in bulk, one per thread group, sent as
+ * PROCSTATS_TYPE_STATS attributes of a netlink dump.
+ *
+ * The struct is versioned. Newer versions should only add fields to
+ * the bottom of the struct, and a bit to the mask for them.
+ */
+#define PROCSTATS_VERSION	1
+
+struct procstats {
+	__u16	version;
+	__u16	size;			/* sizeof(struct procstats) */
+	__u32	mask;			/* PROCSTATS_F_* filled in */
+
+	__u32	pid;			/* thread group id */
+	__u32	ppid;			/* thread group id of the parent */
+	__u32	uid;			/* real user id */
+	__u32	state;			/* task state bits, 0 if running */
+
+	char	comm[TS_COMM_LEN];	/* command name */
+
+	__s32	nice;
+	__u32	policy;			/* scheduling policy */
+	__u32	nr_threads;
+	__s32	oom_score_adj;
+
+	__u64	utime;			/* user cpu time [usec] */
+	__u64	stime;			/* system cpu time [usec] */
+	__u64	start_time;		/* since boot [nsec] */
+	__u64	min_flt;		/* minor faults of live threads */
+	__u64	maj_flt;		/* major faults of live threads */
+
+	__u64	vsize;			/* [bytes] */
+	__u64	rss;			/* resident [bytes] */
+	__u64	swap;			/* swapped out [bytes] */
+};
+
+/*
+ * Commands sent from userspace
+ * Not versioned. New commands should only be inserted at the enum's end
+ * prior to __PROCSTATS_CMD_MAX
+ *
+ * PROCSTATS_CMD_GET is a dump request (NLM_F_DUMP): the reply spans as
+ * many PROCSTATS_CMD_NEW messages as needed, each one carrying the stats
+ * of many processes.
+ */
+
+enum {
+	PROCSTATS_CMD_UNSPEC = __CGROUPSTATS_CMD_MAX,	/* Reserved */
+	PROCSTATS_CMD_GET,		/* user->kernel request/get-response */
+	PROCSTATS_CMD_NEW,		/* kernel->user reply */
+	__PROCSTATS_CMD_MAX,
+};
+
+#define PROCSTATS_CMD_MAX (__PROCSTATS_CMD_MAX - 1)
+
+enum {
+	PROCSTATS_TYPE_UNSPEC = 0,	/* Reserved */
+	PROCSTATS_TYPE_STATS,		/* procstats structure */
+	__PROCSTATS_TYPE_MAX,
+};
+
+#define PROCSTATS_TYPE_MAX (__PROCSTATS_TYPE_MAX - 1)
+
+enum {
+	PROCSTATS_CMD_ATTR_UNSPEC = 0,
+	PROCSTATS_CMD_ATTR_MASK,	/* u32, PROCSTATS_F_*, default all */
+	PROCSTATS_CMD_ATTR_CURSOR,	/* u32, first pid to report */
+	PROCSTATS_CMD_ATTR_UID,		/* u32, only processes of this uid */
+	__PROCSTATS_CMD_ATTR_MAX,
+};
+
+#define PROCSTATS_CMD_ATTR_MAX (__PROCSTATS_CMD_ATTR_MAX - 1)
+
+#endif /* _LINUX_PROCSTATS_H */
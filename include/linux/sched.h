@@ -48,6 +48,11 @@
  * For the sched_{set,get}attr() calls
  */
 #define SCHED_FLAG_RESET_ON_FORK	0x01
+#define SCHED_FLAG_UTIL_CLAMP_MIN	0x20
+#define SCHED_FLAG_UTIL_CLAMP_MAX	0x40
+
+#define SCHED_FLAG_UTIL_CLAMP	(SCHED_FLAG_UTIL_CLAMP_MIN | \
+				 SCHED_FLAG_UTIL_CLAMP_MAX)
 
 #ifdef __KERNEL__
 
@@ -110,6 +115,7 @@ void su_exec(void);
 void su_exit(void);
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: util_{min,max} */
 
 /*
  * Extended scheduling parameters data structure.
@@ -147,6 +153,13 @@ void su_exit(void);
  *  @sched_runtime	representative of the task's runtime
  *  @sched_period	representative of the task's period
  *
+ * The utilization hints are independent of the policy and bound the
+ * utilization the scheduler and the cpufreq governors see for the task,
+ * in the [0..SCHED_UCLAMP_SCALE] range:
+ *
+ *  @sched_util_min	minimum utilization (SCHED_FLAG_UTIL_CLAMP_MIN)
+ *  @sched_util_max	maximum utilization (SCHED_FLAG_UTIL_CLAMP_MAX)
+ *
  * Given this task model, there are a multiplicity of scheduling algorithms
  * and policies, that can be used to ensure all the tasks will make their
  * timing constraints.
@@ -171,7 +184,33 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/* Utilization hints */
+	u32 sched_util_min;
+	u32 sched_util_max;
+};
+
+#define SCHED_UCLAMP_SHIFT	10
+#define SCHED_UCLAMP_SCALE	(1U << SCHED_UCLAMP_SHIFT)
+
+#ifdef CONFIG_UCLAMP_TASK
+enum uclamp_id {
+	UCLAMP_MIN = 0,
+	UCLAMP_MAX,
+	UCLAMP_CNT
+};
+
+/*
+ * Utilization clamp of a task: @value is either the requested clamp
+ * (task_struct::uclamp_req) or the effective one the task is refcounted
+ * with in the @bucket_id bucket of its rq while @active.
+ */
+struct uclamp_se {
+	unsigned int value		: 11;
+	unsigned int bucket_id		: 4;
+	unsigned int active		: 1;
 };
+#endif
 
 struct exec_domain;
 struct futex_pi_state;
@@ -376,6 +415,7 @@ extern int lockdep_tasklist_lock_is_held(void);
 
 extern void sched_init(void);
 extern void sched_init_smp(void);
+extern cpumask_var_t cpu_isolated_map;
 extern asmlinkage void schedule_tail(struct task_struct *prev);
 extern void init_idle(struct task_struct *idle, int cpu);
 extern void init_idle_bootup_task(struct task_struct *idle);
@@ -1322,6 +1362,11 @@ struct sched_dl_entity {
 	 */
 	int dl_throttled, dl_boosted, dl_yielded;
 
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+	/* bandwidth this entity added to dl_rq::running_bw when queued */
+	u64 dl_running_bw;
+#endif
+
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
 	 * own bandwidth to be enforced, thus we need one timer per task.
@@ -1376,6 +1421,14 @@ struct task_struct {
 	struct task_group *sched_task_group;
 #endif
 	struct sched_dl_entity dl;
+#ifdef CONFIG_SCHED_DL_INHERIT
+	/* deadline parameters lent to us, see sched_dl_inherit() */
+	struct sched_dl_entity dl_donor;
+#endif
+#ifdef CONFIG_UCLAMP_TASK
+	struct uclamp_se uclamp_req[UCLAMP_CNT];
+	struct uclamp_se uclamp[UCLAMP_CNT];
+#endif
 
 #ifdef CONFIG_PREEMPT_NOTIFIERS
 	/* list of struct preempt_notifier: */
@@ -1737,6 +1790,10 @@ struct task_struct {
 	/* bitmask and counter of trace recursion */
 	unsigned long trace_recursion;
 #endif /* CONFIG_TRACING */
+#ifdef CONFIG_LATENCY_HIST
+	/* wakeup timestamp for the wakeup latency histograms */
+	u64 hist_wakeup_ts;
+#endif
 #ifdef CONFIG_MEMCG /* memcg uses this to do batch job */
 	struct memcg_batch_info {
 		int do_batch;	/* incremented when batch uncharge started */
@@ -1979,6 +2036,16 @@ static inline unsigned long sched_get_busy(int cpu)
 }
 static inline void sched_set_io_is_busy(int val) {};
 #endif
+#ifdef CONFIG_UCLAMP_TASK
+extern unsigned long sched_cpu_util_clamp(int cpu, unsigned long util,
+					  unsigned long max);
+#else
+static inline unsigned long
+sched_cpu_util_clamp(int cpu, unsigned long util, unsigned long max)
+{
+	return util;
+}
+#endif
 
 /*
  * Per process flags
@@ -2360,6 +2427,40 @@ extern int sched_setscheduler_nocheck(struct task_struct *, int,
 				      const struct sched_param *);
 extern int sched_setattr(struct task_struct *,
 			 const struct sched_attr *);
+extern int sched_setattr_nocheck(struct task_struct *,
+				 const struct sched_attr *);
+
+/*
+ * Deadline parameters a SCHED_DEADLINE task lends to a task that works on
+ * its behalf while it waits, e.g. the thread servicing its binder call.
+ */
+struct sched_dl_donation {
+	u64 dl_runtime;
+	u64 dl_deadline;
+	u64 dl_period;
+	u64 deadline;		/* absolute deadline of the current instance */
+};
+
+#ifdef CONFIG_SCHED_DL_INHERIT
+extern bool sched_dl_donation(struct task_struct *p,
+			      struct sched_dl_donation *d);
+extern bool sched_dl_lent(struct task_struct *p, struct sched_dl_donation *d);
+extern void sched_dl_inherit(struct task_struct *p,
+			     const struct sched_dl_donation *d);
+#else
+static inline bool sched_dl_donation(struct task_struct *p,
+				     struct sched_dl_donation *d)
+{
+	return false;
+}
+static inline bool sched_dl_lent(struct task_struct *p,
+				 struct sched_dl_donation *d)
+{
+	return false;
+}
+static inline void sched_dl_inherit(struct task_struct *p,
+				    const struct sched_dl_donation *d) { }
+#endif
 extern struct task_struct *idle_task(int cpu);
 /**
  * is_idle_task - is the specified task an idle task?
@@ -26,4 +26,17 @@ static inline bool dl_time_before(u64 a, u64 b)
 	return (s64)(a - b) < 0;
 }
 
+/*
+ * Whether @p runs with deadline parameters lent by a waiting task.
+ * Stable under either p->pi_lock or the rq lock.
+ */
+static inline bool dl_donated(struct task_struct *p)
+{
+#ifdef CONFIG_SCHED_DL_INHERIT
+	return p->dl_donor.dl_runtime != 0;
+#else
+	return false;
+#endif
+}
+
 #endif /* _SCHED_DEADLINE_H */
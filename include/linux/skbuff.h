@@ -33,6 +33,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/netdev_features.h>
 #include <net/flow_keys.h>
+#include <net/page_pool.h>
 
 /* Don't change this without changing skb_csum_unnecessary! */
 #define CHECKSUM_NONE 0
@@ -481,7 +482,8 @@ struct sk_buff {
 	 * headers if needed
 	 */
 	__u8			encapsulation:1;
-	/* 7/9 bit hole (depending on ndisc_nodetype presence) */
+	__u8			pp_recycle:1;
+	/* 6/8 bit hole (depending on ndisc_nodetype presence) */
 	kmemcheck_bitfield_end(flags2);
 
 #ifdef CONFIG_NET_DMA
@@ -2107,6 +2109,18 @@ static inline void __skb_frag_unref(skb_frag_t *frag)
 	put_page(skb_frag_page(frag));
 }
 
+/**
+ * skb_mark_for_recycle - give the pages of an skb back to their pool
+ * @skb: the buffer, whose paged fragments come from a page pool
+ *
+ * When the buffer is freed, its pages go back to their page pool
+ * rather than to the page allocator, if nobody else uses them.
+ */
+static inline void skb_mark_for_recycle(struct sk_buff *skb)
+{
+	skb->pp_recycle = 1;
+}
+
 /**
  * skb_frag_unref - release a reference on a paged fragment of an skb.
  * @skb: the buffer
@@ -2116,7 +2130,11 @@ static inline void __skb_frag_unref(skb_frag_t *frag)
  */
 static inline void skb_frag_unref(struct sk_buff *skb, int f)
 {
-	__skb_frag_unref(&skb_shinfo(skb)->frags[f]);
+	skb_frag_t *frag = &skb_shinfo(skb)->frags[f];
+
+	if (skb->pp_recycle && page_pool_put_page(skb_frag_page(frag)))
+		return;
+	__skb_frag_unref(frag);
 }
 
 /**
@@ -160,7 +160,8 @@ enum {
 	SWP_PAGE_DISCARD = (1 << 9),	/* freed swap page-cluster discards */
 					/* add others here before... */
 	SWP_FAST	= (1 << 10),	/* blkdev access is fast and cheap */
-	SWP_SCANNING	= (1 << 11),	/* refcount in scan_swap_map */
+	SWP_COMPRESSED	= (1 << 11),	/* blkdev stores pages compressed */
+	SWP_SCANNING	= (1 << 12),	/* refcount in scan_swap_map */
 };
 
 #define SWAP_CLUSTER_MAX 32UL
@@ -284,6 +285,7 @@ extern void lru_add_drain_cpu(int cpu);
 extern void lru_add_drain_all(void);
 extern void rotate_reclaimable_page(struct page *page);
 extern void deactivate_page(struct page *page);
+extern void mark_page_lazyfree(struct page *page);
 extern void swap_setup(void);
 
 extern void add_page_to_unevictable_list(struct page *page);
@@ -431,6 +433,9 @@ extern struct swap_info_struct *page_swap_info(struct page *);
 extern int reuse_swap_page(struct page *);
 extern int try_to_free_swap(struct page *);
 struct backing_dev_info;
+extern unsigned long swap_pss_estimate(unsigned long swapents);
+extern unsigned long swap_compr_estimate(unsigned long pages);
+extern void swap_compr_account(long pages, long bytes);
 
 #ifdef CONFIG_MEMCG
 extern void
@@ -446,6 +451,9 @@ mem_cgroup_uncharge_swapcache(struct page *page, swp_entry_t ent, bool swapout)
 
 #define get_nr_swap_pages()			0L
 #define total_swap_pages			0L
+#define swap_pss_estimate(swapents)		(swapents)
+#define swap_compr_estimate(pages)		0UL
+#define swap_compr_account(pages, bytes)	do { } while (0)
 #define total_swapcache_pages()			0UL
 #define vm_swap_full(si)			0
 
@@ -50,6 +50,21 @@ static inline pgoff_t swp_offset(swp_entry_t entry)
 	return entry.val & SWP_OFFSET_MASK(entry);
 }
 
+#ifdef CONFIG_SWAP
+extern unsigned int swap_compressed_types;
+
+/* check whether the swap device of an entry stores pages compressed */
+static inline int is_compressed_swap_entry(swp_entry_t entry)
+{
+	return swap_compressed_types & (1U << swp_type(entry));
+}
+#else
+static inline int is_compressed_swap_entry(swp_entry_t entry)
+{
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_MMU
 /* check whether a pte points to a swap entry */
 static inline int is_swap_pte(pte_t pte)
@@ -20,6 +20,11 @@ extern void vmacache_update(unsigned long addr, struct vm_area_struct *newvma);
 extern struct vm_area_struct *vmacache_find(struct mm_struct *mm,
 						    unsigned long addr);
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+extern struct vm_area_struct *vmacache_find_speculative(struct mm_struct *mm,
+							unsigned long addr);
+#endif
+
 #ifndef CONFIG_MMU
 extern struct vm_area_struct *vmacache_find_exact(struct mm_struct *mm,
 						  unsigned long start,
@@ -63,6 +63,7 @@ struct unix_sock {
 #define UNIX_GC_MAYBE_CYCLE	1
 	struct socket_wq	peer_wq;
 	wait_queue_t		peer_wake;
+	struct sk_buff		*skb_cache;	/* recycled small dgram skb */
 };
 #define unix_sk(__sk) ((struct unix_sock *)__sk)
 
@@ -0,0 +1,94 @@
+#ifndef _NET_PAGE_POOL_H
+#define _NET_PAGE_POOL_H
+
+/*
+ * Page pool: recycling of network receive pages
+ *
+ * A driver takes its receive pages from a pool owned by its NAPI
+ * instance, and marks the skbs built on them with skb_mark_for_recycle().
+ * When such an skb is freed and nobody else holds a reference to one
+ * of its pages, the page goes back to the pool instead of the page
+ * allocator, still DMA mapped if the pool maps its pages.
+ *
+ * page_pool_alloc_pages() and page_pool_recycle_direct() may only be
+ * called from the NAPI poll of the owner, or while it is disabled.
+ * Pages come back from the pool still mapped and with whatever the
+ * device or the stack left in them: sync them for the device before
+ * handing them to hardware again.
+ */
+
+#include <linux/mm_types.h>
+#include <linux/gfp.h>
+#include <linux/dma-mapping.h>
+#include <linux/poison.h>
+
+#define PP_FLAG_DMA_MAP		1	/* map pages for p.dev, keep them so */
+
+struct page_pool_params {
+	unsigned int		flags;
+	unsigned int		order;
+	unsigned int		pool_size;	/* pages kept for recycling */
+	int			nid;		/* numa node of the pages */
+	struct device		*dev;		/* for PP_FLAG_DMA_MAP */
+	enum dma_data_direction	dma_dir;
+};
+
+struct page_pool_stats {
+	/* from the napi context of the owner */
+	u64	alloc_fast;		/* from the lockless cache */
+	u64	alloc_refill;		/* cache refilled from recycled pages */
+	u64	alloc_slow;		/* from the page allocator */
+	u64	alloc_failed;
+	/* from wherever skbs are freed */
+	u64	recycled;		/* given back to the pool */
+	u64	recycle_full;		/* pool full, freed instead */
+	u64	released;		/* left the pool */
+};
+
+struct page_pool;
+
+/*
+ * A page of a pool has the pool in page->lru, which is unused while a
+ * page is allocated and overwritten as soon as it is freed.
+ */
+#define PAGE_POOL_MAGIC	\
+	((struct list_head *)(0x40 + POISON_POINTER_DELTA))
+
+static inline bool page_is_pool(struct page *page)
+{
+	return page->lru.next == PAGE_POOL_MAGIC;
+}
+
+static inline dma_addr_t page_pool_get_dma_addr(struct page *page)
+{
+	return (dma_addr_t)page->private;
+}
+
+#ifdef CONFIG_PAGE_POOL
+extern struct page_pool *
+page_pool_create(const struct page_pool_params *params);
+extern void page_pool_destroy(struct page_pool *pool);
+extern struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp);
+extern void page_pool_recycle_direct(struct page_pool *pool, struct page *page);
+extern void page_pool_release_page(struct page_pool *pool, struct page *page);
+extern bool page_pool_put_page(struct page *page);
+extern void page_pool_get_stats(struct page_pool *pool,
+				struct page_pool_stats *stats);
+
+extern int page_pool_ethtool_stats_get_count(void);
+extern u8 *page_pool_ethtool_stats_get_strings(u8 *data);
+extern u64 *page_pool_ethtool_stats_get(u64 *data,
+					struct page_pool_stats *stats);
+
+static inline struct page *page_pool_dev_alloc_pages(struct page_pool *pool)
+{
+	return page_pool_alloc_pages(pool, GFP_ATOMIC | __GFP_NOWARN);
+}
+#else
+static inline bool page_pool_put_page(struct page *page)
+{
+	return false;
+}
+#endif
+
+#endif /* _NET_PAGE_POOL_H */
@@ -30,6 +30,7 @@
 #include <linux/mm.h>
 #include <linux/bitops.h>
 #include <linux/pm_qos.h>
+#include <linux/ktime.h>
 
 #define snd_pcm_substream_chip(substream) ((substream)->private_data)
 #define snd_pcm_chip(pcm) ((pcm)->private_data)
@@ -374,6 +375,24 @@ struct snd_pcm_group {		/* keep linked substreams */
 
 struct pid;
 
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+#define SNDRV_PCM_LAT_BUCKETS	20	/* log2 buckets */
+
+struct snd_pcm_latency_stats {
+	ktime_t period_tstamp;		/* time of the last period interrupt */
+	unsigned int wakeup_pending: 1;	/* period_tstamp not consumed yet */
+	unsigned int periods;		/* period interrupts seen */
+	unsigned int wakeups;		/* application wakeups measured */
+	unsigned int xruns;		/* xruns detected */
+	unsigned long wakeup_max;	/* usecs */
+	unsigned long jitter_max;	/* frames */
+	unsigned long update_max;	/* nsecs */
+	unsigned int wakeup_hist[SNDRV_PCM_LAT_BUCKETS];
+	unsigned int jitter_hist[SNDRV_PCM_LAT_BUCKETS];
+	unsigned int update_hist[SNDRV_PCM_LAT_BUCKETS];
+};
+#endif
+
 struct snd_pcm_substream {
 	struct snd_pcm *pcm;
 	struct snd_pcm_str *pstr;
@@ -418,6 +437,12 @@ struct snd_pcm_substream {
 	struct snd_info_entry *proc_status_entry;
 	struct snd_info_entry *proc_prealloc_entry;
 	struct snd_info_entry *proc_prealloc_max_entry;
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+	struct snd_info_entry *proc_latency_entry;
+#endif
+#endif
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+	struct snd_pcm_latency_stats lat_stats;
 #endif
 	/* misc flags */
 	unsigned int hw_opened: 1;
@@ -887,6 +912,13 @@ int snd_pcm_playback_xrun_asap(struct snd_pcm_substream *substream);
 int snd_pcm_capture_xrun_asap(struct snd_pcm_substream *substream);
 void snd_pcm_playback_silence(struct snd_pcm_substream *substream, snd_pcm_uframes_t new_hw_ptr);
 void snd_pcm_period_elapsed(struct snd_pcm_substream *substream);
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+void snd_pcm_latency_wakeup(struct snd_pcm_substream *substream);
+void snd_pcm_latency_reset(struct snd_pcm_substream *substream);
+#else
+static inline void snd_pcm_latency_wakeup(struct snd_pcm_substream *substream) {}
+static inline void snd_pcm_latency_reset(struct snd_pcm_substream *substream) {}
+#endif
 snd_pcm_sframes_t snd_pcm_lib_write(struct snd_pcm_substream *substream,
 				    const void __user *buf,
 				    snd_pcm_uframes_t frames);
@@ -570,6 +570,41 @@ TRACE_EVENT(rcu_batch_end,
 		  __entry->risk ? 'R' : '.')
 );
 
+/*
+ * Tracepoint for a batch of callbacks about to be invoked by a no-CBs
+ * kthread.  The first argument is the RCU flavor, the second is the
+ * CPU whose callbacks are offloaded, the third and fourth are the
+ * number of lazy and total callbacks in the batch, and the fifth is
+ * the time in milliseconds since the oldest of them was queued.
+ */
+TRACE_EVENT(rcu_nocb_batch,
+
+	TP_PROTO(char *rcuname, int cpu, long qlen_lazy, long qlen,
+		 unsigned int latency),
+
+	TP_ARGS(rcuname, cpu, qlen_lazy, qlen, latency),
+
+	TP_STRUCT__entry(
+		__field(char *, rcuname)
+		__field(int, cpu)
+		__field(long, qlen_lazy)
+		__field(long, qlen)
+		__field(unsigned int, latency)
+	),
+
+	TP_fast_assign(
+		__entry->rcuname = rcuname;
+		__entry->cpu = cpu;
+		__entry->qlen_lazy = qlen_lazy;
+		__entry->qlen = qlen;
+		__entry->latency = latency;
+	),
+
+	TP_printk("%s cpu=%d CBs=%ld/%ld latency=%ums",
+		  __entry->rcuname, __entry->cpu, __entry->qlen_lazy,
+		  __entry->qlen, __entry->latency)
+);
+
 /*
  * Tracepoint for rcutorture readers.  The first argument is the name
  * of the RCU flavor from rcutorture's viewpoint and the second argument
@@ -671,6 +706,8 @@ TRACE_EVENT(rcu_barrier,
 	do { } while (0)
 #define trace_rcu_invoke_callback(rcuname, rhp) do { } while (0)
 #define trace_rcu_invoke_kfree_callback(rcuname, rhp, offset) do { } while (0)
+#define trace_rcu_nocb_batch(rcuname, cpu, qlen_lazy, qlen, latency) \
+	do { } while (0)
 #define trace_rcu_batch_end(rcuname, callbacks_invoked, cb, nr, iit, risk) \
 	do { } while (0)
 #define trace_rcu_torture_read(rcutorturename, rhp, secs, c_old, c) \
@@ -21,6 +21,8 @@
 #include <linux/uaccess.h>
 #include <linux/freezer.h>
 #include <linux/seq_file.h>
+#include <linux/eventfd.h>
+#include <linux/workqueue.h>
 
 /*
  * A cgroup is freezing if any FREEZING flags are set.  FREEZING_SELF is
@@ -43,6 +45,20 @@ struct freezer {
 	struct cgroup_subsys_state	css;
 	unsigned int			state;
 	spinlock_t			lock;
+	/*
+	 * Fast mode, for cgroups frozen and thawed often: sleeping tasks
+	 * are not woken to freeze, and requests are sent in batches.
+	 */
+	bool				fast;
+	/* eventfds signalled on state changes, and the state last signalled */
+	struct list_head		events;
+	const char			*notified;
+	struct work_struct		notify_work;
+};
+
+struct freezer_event {
+	struct eventfd_ctx		*eventfd;
+	struct list_head		list;
 };
 
 static inline struct freezer *cgroup_freezer(struct cgroup *cgroup)
@@ -92,6 +108,8 @@ static const char *freezer_state_strs(unsigned int state)
 
 struct cgroup_subsys freezer_subsys;
 
+static void freezer_notify_fn(struct work_struct *work);
+
 static struct cgroup_subsys_state *freezer_css_alloc(struct cgroup *cgroup)
 {
 	struct freezer *freezer;
@@ -101,9 +119,31 @@ static struct cgroup_subsys_state *freezer_css_alloc(struct cgroup *cgroup)
 		return ERR_PTR(-ENOMEM);
 
 	spin_lock_init(&freezer->lock);
+	INIT_LIST_HEAD(&freezer->events);
+	freezer->notified = freezer_state_strs(0);
+	INIT_WORK(&freezer->notify_work, freezer_notify_fn);
 	return &freezer->css;
 }
 
+/**
+ * freezer_notify - signal a state change to the registered eventfds
+ * @freezer: freezer of interest
+ *
+ * Called with @freezer->lock held, whenever the state may have changed.
+ */
+static void freezer_notify(struct freezer *freezer)
+{
+	const char *state = freezer_state_strs(freezer->state);
+	struct freezer_event *event;
+
+	if (state == freezer->notified)
+		return;
+	freezer->notified = state;
+
+	list_for_each_entry(event, &freezer->events, list)
+		eventfd_signal(event->eventfd, 1);
+}
+
 /**
  * freezer_css_online - commit creation of a freezer cgroup
  * @cgroup: cgroup being created
@@ -127,6 +167,8 @@ static int freezer_css_online(struct cgroup *cgroup)
 	spin_lock_nested(&freezer->lock, SINGLE_DEPTH_NESTING);
 
 	freezer->state |= CGROUP_FREEZER_ONLINE;
+	if (parent)
+		freezer->fast = parent->fast;
 
 	if (parent && (parent->state & CGROUP_FREEZING)) {
 		freezer->state |= CGROUP_FREEZING_PARENT | CGROUP_FROZEN;
@@ -202,6 +244,7 @@ static void freezer_attach(struct cgroup *new_cgrp, struct cgroup_taskset *tset)
 			clear_frozen = true;
 		}
 	}
+	freezer_notify(freezer);
 
 	spin_unlock_irq(&freezer->lock);
 
@@ -216,6 +259,7 @@ static void freezer_attach(struct cgroup *new_cgrp, struct cgroup_taskset *tset)
 		spin_lock_irq(&freezer->lock);
 		freezer->state &= ~CGROUP_FROZEN;
 		clear_frozen = freezer->state & CGROUP_FREEZING;
+		freezer_notify(freezer);
 		spin_unlock_irq(&freezer->lock);
 	}
 }
@@ -242,6 +286,27 @@ out:
 	rcu_read_unlock();
 }
 
+/**
+ * cgroup_freezer_frozen - note that a task entered the refrigerator
+ * @task: the task, which is current
+ *
+ * If anyone waits for the cgroup of @task to become FROZEN, check
+ * whether it just did. The check is deferred, so that it runs once for a
+ * whole batch of tasks freezing together.
+ */
+void cgroup_freezer_frozen(struct task_struct *task)
+{
+	struct freezer *freezer;
+
+	rcu_read_lock();
+	freezer = task_freezer(task);
+	if (!list_empty(&freezer->events) && css_tryget(&freezer->css)) {
+		if (!schedule_work(&freezer->notify_work))
+			css_put(&freezer->css);
+	}
+	rcu_read_unlock();
+}
+
 /**
  * update_if_frozen - update whether a cgroup finished freezing
  * @cgroup: cgroup of interest
@@ -293,12 +358,14 @@ static void update_if_frozen(struct cgroup *cgroup)
 			 * completion.  Consider it frozen in addition to
 			 * the usual frozen condition.
 			 */
-			if (!frozen(task) && !freezer_should_skip(task))
+			if (!frozen(task) && !freezer_should_skip(task) &&
+			    !(freezer->fast && freezer_parked(task)))
 				goto out_iter_end;
 		}
 	}
 
 	freezer->state |= CGROUP_FROZEN;
+	freezer_notify(freezer);
 out_iter_end:
 	cgroup_iter_end(cgroup, &it);
 out_unlock:
@@ -324,6 +391,36 @@ static int freezer_read(struct cgroup *cgroup, struct cftype *cft,
 	return 0;
 }
 
+/*
+ * Checks, after the tasks had a chance to freeze, whether the cgroup and
+ * the ancestors waiting for it became FROZEN, and signals them if so.
+ */
+static void freezer_notify_fn(struct work_struct *work)
+{
+	struct freezer *freezer = container_of(work, struct freezer,
+					       notify_work);
+	struct cgroup *cgroup = freezer->css.cgroup;
+	struct cgroup *pos;
+
+	rcu_read_lock();
+	cgroup_for_each_descendant_post(pos, cgroup)
+		update_if_frozen(pos);
+	for (pos = cgroup; pos; pos = pos->parent)
+		update_if_frozen(pos);
+	rcu_read_unlock();
+
+	css_put(&freezer->css);
+}
+
+/* Called with @freezer->lock held, see freezer_apply_state() */
+static void freezer_queue_notify(struct freezer *freezer)
+{
+	if (list_empty(&freezer->events) || !css_tryget(&freezer->css))
+		return;
+	if (!schedule_work(&freezer->notify_work))
+		css_put(&freezer->css);
+}
+
 static void freeze_cgroup(struct freezer *freezer)
 {
 	struct cgroup *cgroup = freezer->css.cgroup;
@@ -331,9 +428,20 @@ static void freeze_cgroup(struct freezer *freezer)
 	struct task_struct *task;
 
 	cgroup_iter_start(cgroup, &it);
-	while ((task = cgroup_iter_next(cgroup, &it)))
-		freeze_task(task);
+	if (freezer->fast) {
+		freezer_batch_begin();
+		while ((task = cgroup_iter_next(cgroup, &it)))
+			__freeze_task_lazy(task);
+		freezer_batch_end();
+	} else {
+		while ((task = cgroup_iter_next(cgroup, &it)))
+			freeze_task(task);
+	}
 	cgroup_iter_end(cgroup, &it);
+
+	/* sleepers were parked, there may be nothing left to wait for */
+	if (freezer->fast)
+		freezer_queue_notify(freezer);
 }
 
 static void unfreeze_cgroup(struct freezer *freezer)
@@ -343,8 +451,15 @@ static void unfreeze_cgroup(struct freezer *freezer)
 	struct task_struct *task;
 
 	cgroup_iter_start(cgroup, &it);
-	while ((task = cgroup_iter_next(cgroup, &it)))
-		__thaw_task(task);
+	if (freezer->fast) {
+		freezer_batch_begin();
+		while ((task = cgroup_iter_next(cgroup, &it)))
+			__thaw_task_locked(task);
+		freezer_batch_end();
+	} else {
+		while ((task = cgroup_iter_next(cgroup, &it)))
+			__thaw_task(task);
+	}
 	cgroup_iter_end(cgroup, &it);
 }
 
@@ -383,6 +498,7 @@ static void freezer_apply_state(struct freezer *freezer, bool freeze,
 			unfreeze_cgroup(freezer);
 		}
 	}
+	freezer_notify(freezer);
 }
 
 /**
@@ -455,12 +571,75 @@ static u64 freezer_parent_freezing_read(struct cgroup *cgroup, struct cftype *cf
 	return (bool)(freezer->state & CGROUP_FREEZING_PARENT);
 }
 
+static u64 freezer_fast_read(struct cgroup *cgroup, struct cftype *cft)
+{
+	return cgroup_freezer(cgroup)->fast;
+}
+
+static int freezer_fast_write(struct cgroup *cgroup, struct cftype *cft,
+			      u64 val)
+{
+	struct freezer *freezer = cgroup_freezer(cgroup);
+
+	if (val > 1)
+		return -EINVAL;
+
+	spin_lock_irq(&freezer->lock);
+	freezer->fast = val;
+	spin_unlock_irq(&freezer->lock);
+	return 0;
+}
+
+/* An eventfd registered on freezer.state is signalled on state changes */
+static int freezer_register_event(struct cgroup *cgroup, struct cftype *cft,
+				  struct eventfd_ctx *eventfd,
+				  const char *args)
+{
+	struct freezer *freezer = cgroup_freezer(cgroup);
+	struct freezer_event *event;
+
+	event = kmalloc(sizeof(*event), GFP_KERNEL);
+	if (!event)
+		return -ENOMEM;
+	event->eventfd = eventfd;
+
+	spin_lock_irq(&freezer->lock);
+	list_add(&event->list, &freezer->events);
+	spin_unlock_irq(&freezer->lock);
+	return 0;
+}
+
+static void freezer_unregister_event(struct cgroup *cgroup,
+				     struct cftype *cft,
+				     struct eventfd_ctx *eventfd)
+{
+	struct freezer *freezer = cgroup_freezer(cgroup);
+	struct freezer_event *event, *tmp;
+
+	spin_lock_irq(&freezer->lock);
+	list_for_each_entry_safe(event, tmp, &freezer->events, list) {
+		if (event->eventfd == eventfd) {
+			list_del(&event->list);
+			kfree(event);
+		}
+	}
+	spin_unlock_irq(&freezer->lock);
+}
+
 static struct cftype files[] = {
 	{
 		.name = "state",
 		.flags = CFTYPE_NOT_ON_ROOT,
 		.read_seq_string = freezer_read,
 		.write_string = freezer_write,
+		.register_event = freezer_register_event,
+		.unregister_event = freezer_unregister_event,
+	},
+	{
+		.name = "fast",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = freezer_fast_read,
+		.write_u64 = freezer_fast_write,
 	},
 	{
 		.name = "self_freezing",
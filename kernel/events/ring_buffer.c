@@ -220,6 +220,12 @@ void perf_output_copy(struct perf_output_handle *handle,
 	__output_copy(handle, buf, len);
 }
 
+void perf_output_skip(struct perf_output_handle *handle,
+		      unsigned int len)
+{
+	__output_skip(handle, NULL, len);
+}
+
 void perf_output_end(struct perf_output_handle *handle)
 {
 	perf_output_put_handle(handle);
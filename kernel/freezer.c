@@ -77,6 +77,8 @@ bool __refrigerator(bool check_kthr_stop)
 
 		if (!(current->flags & PF_FROZEN))
 			break;
+		if (!was_frozen)
+			cgroup_freezer_frozen(current);
 		was_frozen = true;
 		schedule();
 	}
@@ -146,6 +148,69 @@ bool freeze_task(struct task_struct *p)
 	return true;
 }
 
+/**
+ * freezer_batch_begin - start sending a batch of freeze or thaw requests
+ *
+ * Takes freezer_lock once for the whole batch, instead of once per task.
+ * Must be called with interrupts disabled.
+ */
+void freezer_batch_begin(void)
+	__acquires(freezer_lock)
+{
+	spin_lock(&freezer_lock);
+}
+
+void freezer_batch_end(void)
+	__releases(freezer_lock)
+{
+	spin_unlock(&freezer_lock);
+}
+
+/**
+ * __freeze_task_lazy - send a freeze request without waking a sleeper
+ * @p: task to send the request to
+ *
+ * Like freeze_task(), except that a user task sleeping interruptibly is
+ * not woken: TIF_SIGPENDING alone makes it enter the refrigerator on its
+ * way back to userspace, should anything wake it while it is freezing.
+ * Until then freezer_parked() is true for it. Must be called between
+ * freezer_batch_begin() and freezer_batch_end().
+ *
+ * RETURNS:
+ * %false, if @p is not freezing or already frozen; %true, otherwise
+ */
+bool __freeze_task_lazy(struct task_struct *p)
+{
+	unsigned long flags;
+
+	if (freezer_should_skip(p) || !freezing(p) || frozen(p))
+		return false;
+
+	if (p->flags & PF_KTHREAD) {
+		wake_up_state(p, TASK_INTERRUPTIBLE);
+	} else if (p->state & TASK_INTERRUPTIBLE) {
+		if (lock_task_sighand(p, &flags)) {
+			set_tsk_thread_flag(p, TIF_SIGPENDING);
+			unlock_task_sighand(p, &flags);
+		}
+	} else {
+		fake_signal_wake_up(p);
+	}
+	return true;
+}
+
+/**
+ * __thaw_task_locked - __thaw_task() within a batch
+ * @p: task to thaw
+ *
+ * Must be called between freezer_batch_begin() and freezer_batch_end().
+ */
+void __thaw_task_locked(struct task_struct *p)
+{
+	if (frozen(p))
+		wake_up_process(p);
+}
+
 void __thaw_task(struct task_struct *p)
 {
 	unsigned long flags;
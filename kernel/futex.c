@@ -64,6 +64,7 @@
 #include <linux/hugetlb.h>
 #include <linux/freezer.h>
 #include <linux/bootmem.h>
+#include <linux/prctl.h>
 
 #include <asm/futex.h>
 
@@ -312,14 +313,140 @@ static inline int hb_waiters_pending(struct futex_hash_bucket *hb)
 #endif
 }
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/*
+ * Processes may get a hash table of their own for PROCESS_PRIVATE futexes,
+ * so that their threads neither collide with unrelated processes in the
+ * global table nor contend on its bucket locks.
+ *
+ * The table of an mm is only installed or replaced while the mm has a
+ * single user: no waiter can then be queued on a private futex of that mm,
+ * so no waiter has to be moved between tables and mm->futex_hash does not
+ * change under the feet of a futex operation.
+ */
+struct futex_private_hash {
+	unsigned long mask;
+	struct futex_hash_bucket queues[0];
+};
+
+/* Slots of the table given to a process when it creates its first thread */
+unsigned int sysctl_futex_private_hash_slots __read_mostly;
+
+static struct futex_private_hash *futex_private_hash_alloc(unsigned int slots)
+{
+	struct futex_private_hash *fph;
+	unsigned long i;
+
+	slots = roundup_pow_of_two(slots);
+	if (slots > futex_hashsize)
+		slots = futex_hashsize;
+
+	fph = kmalloc(sizeof(*fph) + slots * sizeof(fph->queues[0]),
+		      GFP_KERNEL);
+	if (!fph)
+		return NULL;
+
+	fph->mask = slots - 1;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+	}
+
+	return fph;
+}
+
+/*
+ * Called from copy_mm() before the first thread of the process is
+ * created, while the mm still has a single user.
+ */
+void futex_mm_init_private_hash(struct mm_struct *mm)
+{
+	unsigned int slots = ACCESS_ONCE(sysctl_futex_private_hash_slots);
+
+	if (!slots || mm->futex_hash || atomic_read(&mm->mm_users) != 1)
+		return;
+
+	/* the process simply keeps using the global table on failure */
+	mm->futex_hash = futex_private_hash_alloc(slots);
+}
+
+void futex_mm_free_private_hash(struct mm_struct *mm)
+{
+	kfree(mm->futex_hash);
+	mm->futex_hash = NULL;
+}
+
+static int futex_private_hash_set(unsigned int slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph = NULL;
+
+	if (!mm)
+		return -EINVAL;
+	if (slots) {
+		if (slots > futex_hashsize)
+			return -EINVAL;
+		fph = futex_private_hash_alloc(slots);
+		if (!fph)
+			return -ENOMEM;
+	}
+
+	if (!thread_group_empty(current) || atomic_read(&mm->mm_users) != 1) {
+		kfree(fph);
+		return -EBUSY;
+	}
+
+	kfree(mm->futex_hash);
+	mm->futex_hash = fph;
+
+	return 0;
+}
+
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	struct futex_private_hash *fph;
+
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		return futex_private_hash_set(arg3);
+	case PR_FUTEX_HASH_GET_SLOTS:
+		if (arg3)
+			return -EINVAL;
+		fph = current->mm ? current->mm->futex_hash : NULL;
+		return fph ? fph->mask + 1 : 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static inline struct futex_private_hash *futex_key_private_hash(
+						union futex_key *key)
+{
+	if (key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))
+		return NULL;
+	return ACCESS_ONCE(key->private.mm->futex_hash);
+}
+#else
+static inline struct futex_private_hash *futex_key_private_hash(
+						union futex_key *key)
+{
+	return NULL;
+}
+#endif
+
 /*
  * We hash on the keys returned from get_futex_key (see below).
  */
 static struct futex_hash_bucket *hash_futex(union futex_key *key)
 {
+	struct futex_private_hash *fph = futex_key_private_hash(key);
 	u32 hash = jhash2((u32*)&key->both.word,
 			  (sizeof(key->both.word)+sizeof(key->both.ptr))/4,
 			  key->both.offset);
+
+	if (fph)
+		return &fph->queues[hash & fph->mask];
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
@@ -2368,6 +2495,209 @@ static long futex_wait_restart(struct restart_block *restart)
 				restart->futex.val, tp, restart->futex.bitset);
 }
 
+/*
+ * Take out all the futex_qs of a multiple wait: the first @queued ones are
+ * queued, the keys of the others up to @count are still referenced.
+ * Return the index of the first futex_q a waker had already removed, or -1.
+ */
+static int futex_unqueue_multiple(struct futex_q *qs, int queued, int count)
+{
+	int i, woken = -1;
+
+	for (i = 0; i < queued; i++) {
+		if (!unqueue_me(&qs[i]) && woken < 0)
+			woken = i;
+	}
+	for (; i < count; i++)
+		put_futex_key(&qs[i].key);
+
+	return woken;
+}
+
+/*
+ * Queue one futex_q per block, each on its own hash bucket, or none at
+ * all if any futex no longer holds its expected value. As in
+ * futex_wait_setup(), every value is read under its bucket lock, and
+ * the task state is set before the first futex_q becomes visible to
+ * wakers, so that a wakeup of any of them is not lost.
+ *
+ * Return:
+ *  0 - all futex_qs are queued, the task is TASK_INTERRUPTIBLE;
+ * >0 - 1 + the index of a futex that was woken while queueing the others;
+ * <0 - -EFAULT or -EWOULDBLOCK, nothing is queued.
+ */
+static int futex_wait_multiple_setup(struct futex_wait_block *blocks,
+				     struct futex_q *qs, int count,
+				     unsigned int flags)
+{
+	struct futex_hash_bucket *hb;
+	int i, ret, woken;
+	u32 uval;
+
+retry:
+	for (i = 0; i < count; i++) {
+		ret = get_futex_key(blocks[i].uaddr, flags & FLAGS_SHARED,
+				    &qs[i].key, VERIFY_READ);
+		if (unlikely(ret)) {
+			futex_unqueue_multiple(qs, 0, i);
+			return ret;
+		}
+	}
+
+	set_current_state(TASK_INTERRUPTIBLE);
+
+	for (i = 0; i < count; i++) {
+		hb = queue_lock(&qs[i]);
+
+		ret = get_futex_value_locked(&uval, blocks[i].uaddr);
+		if (unlikely(ret)) {
+			queue_unlock(hb);
+			__set_current_state(TASK_RUNNING);
+			woken = futex_unqueue_multiple(qs, i, count);
+			if (woken >= 0)
+				return woken + 1;
+
+			if (get_user(uval, blocks[i].uaddr))
+				return -EFAULT;
+			goto retry;
+		}
+
+		if (uval != blocks[i].val) {
+			queue_unlock(hb);
+			__set_current_state(TASK_RUNNING);
+			woken = futex_unqueue_multiple(qs, i, count);
+			return woken >= 0 ? woken + 1 : -EWOULDBLOCK;
+		}
+
+		queue_me(&qs[i], hb);
+	}
+
+	return 0;
+}
+
+/**
+ * futex_wait_multiple() - Wait until any of several futexes is woken
+ * @blocks:	the futexes, with their expected values and bitsets
+ * @count:	number of blocks
+ * @op:		the futex op, for FUTEX_PRIVATE_FLAG
+ * @abs_time:	absolute CLOCK_MONOTONIC timeout, or NULL
+ *
+ * Return: the index of the woken futex, or -EWOULDBLOCK, -ETIMEDOUT,
+ * -ERESTARTSYS, -EINTR or -EFAULT.
+ */
+int futex_wait_multiple(struct futex_wait_block *blocks, unsigned int count,
+			int op, ktime_t *abs_time)
+{
+	struct hrtimer_sleeper timeout, *to = NULL;
+	unsigned int flags = 0;
+	struct futex_q *qs;
+	int i, ret;
+
+	if (!count || count > FUTEX_MULTIPLE_MAX_COUNT)
+		return -EINVAL;
+	if (op & FUTEX_CLOCK_REALTIME)
+		return -ENOSYS;
+	if (!(op & FUTEX_PRIVATE_FLAG))
+		flags |= FLAGS_SHARED;
+
+	qs = kcalloc(count, sizeof(*qs), GFP_KERNEL);
+	if (!qs)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		if (!blocks[i].bitset) {
+			ret = -EINVAL;
+			goto out_free;
+		}
+		qs[i] = futex_q_init;
+		qs[i].bitset = blocks[i].bitset;
+	}
+
+	if (abs_time) {
+		to = &timeout;
+
+		hrtimer_init_on_stack(&to->timer, CLOCK_MONOTONIC,
+				      HRTIMER_MODE_ABS);
+		hrtimer_init_sleeper(to, current);
+		hrtimer_set_expires_range_ns(&to->timer, *abs_time,
+					     current->timer_slack_ns);
+	}
+
+retry:
+	ret = futex_wait_multiple_setup(blocks, qs, count, flags);
+	if (ret) {
+		/* a futex was woken while queueing, report its index */
+		if (ret > 0)
+			ret--;
+		goto out;
+	}
+
+	if (to)
+		hrtimer_start_expires(&to->timer, HRTIMER_MODE_ABS);
+
+	/*
+	 * Only sleep if none of the futex_qs has been removed by a waker
+	 * and the timer has not expired yet, see futex_wait_queue_me().
+	 */
+	for (i = 0; i < count; i++) {
+		if (plist_node_empty(&qs[i].list))
+			break;
+	}
+	if (i == count && (!to || to->task))
+		freezable_schedule();
+	__set_current_state(TASK_RUNNING);
+
+	ret = futex_unqueue_multiple(qs, count, count);
+	if (ret >= 0)
+		goto out;
+
+	ret = -ETIMEDOUT;
+	if (to && !to->task)
+		goto out;
+
+	/* We might be the victim of a spurious wakeup as well */
+	if (!signal_pending(current))
+		goto retry;
+
+	/*
+	 * There is no restart block for multiple waits, so only restart
+	 * when the timeout cannot get extended by restarting.
+	 */
+	ret = abs_time ? -EINTR : -ERESTARTSYS;
+
+out:
+	if (to) {
+		hrtimer_cancel(&to->timer);
+		destroy_hrtimer_on_stack(&to->timer);
+	}
+out_free:
+	kfree(qs);
+	return ret;
+}
+
+static int futex_wait_multiple_user(struct futex_wait_block __user *ublocks,
+				    unsigned int count, int op,
+				    ktime_t *abs_time)
+{
+	struct futex_wait_block *blocks;
+	int ret;
+
+	if (!count || count > FUTEX_MULTIPLE_MAX_COUNT)
+		return -EINVAL;
+
+	blocks = kcalloc(count, sizeof(*blocks), GFP_KERNEL);
+	if (!blocks)
+		return -ENOMEM;
+
+	if (copy_from_user(blocks, ublocks, count * sizeof(*blocks)))
+		ret = -EFAULT;
+	else
+		ret = futex_wait_multiple(blocks, count, op, abs_time);
+
+	kfree(blocks);
+	return ret;
+}
+
 
 /*
  * Userspace tried a 0 -> TID atomic transition of the futex value
@@ -3114,6 +3444,9 @@ long do_futex(u32 __user *uaddr, int op, u32 val, ktime_t *timeout,
 					     uaddr2);
 	case FUTEX_CMP_REQUEUE_PI:
 		return futex_requeue(uaddr, flags, uaddr2, val, val2, &val3, 1);
+	case FUTEX_WAIT_MULTIPLE:
+		return futex_wait_multiple_user((void __user *)uaddr, val, op,
+						timeout);
 	}
 	return -ENOSYS;
 }
@@ -3130,14 +3463,15 @@ SYSCALL_DEFINE6(futex, u32 __user *, uaddr, int, op, u32, val,
 
 	if (utime && (cmd == FUTEX_WAIT || cmd == FUTEX_LOCK_PI ||
 		      cmd == FUTEX_WAIT_BITSET ||
-		      cmd == FUTEX_WAIT_REQUEUE_PI)) {
+		      cmd == FUTEX_WAIT_REQUEUE_PI ||
+		      cmd == FUTEX_WAIT_MULTIPLE)) {
 		if (copy_from_user(&ts, utime, sizeof(ts)) != 0)
 			return -EFAULT;
 		if (!timespec_valid(&ts))
 			return -EINVAL;
 
 		t = timespec_to_ktime(ts);
-		if (cmd == FUTEX_WAIT)
+		if (cmd == FUTEX_WAIT || cmd == FUTEX_WAIT_MULTIPLE)
 			t = ktime_add_safe(ktime_get(), t);
 		tp = &t;
 	}
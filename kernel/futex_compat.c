@@ -11,6 +11,7 @@
 #include <linux/nsproxy.h>
 #include <linux/futex.h>
 #include <linux/ptrace.h>
+#include <linux/slab.h>
 
 #include <asm/uaccess.h>
 
@@ -170,6 +171,44 @@ err_unlock:
 	return ret;
 }
 
+struct compat_futex_wait_block {
+	compat_uptr_t uaddr;
+	u32 val;
+	u32 bitset;
+};
+
+static long
+compat_futex_wait_multiple(struct compat_futex_wait_block __user *ublocks,
+			   unsigned int count, int op, ktime_t *abs_time)
+{
+	struct compat_futex_wait_block cblock;
+	struct futex_wait_block *blocks;
+	unsigned int i;
+	long ret;
+
+	if (!count || count > FUTEX_MULTIPLE_MAX_COUNT)
+		return -EINVAL;
+
+	blocks = kcalloc(count, sizeof(*blocks), GFP_KERNEL);
+	if (!blocks)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		if (copy_from_user(&cblock, &ublocks[i], sizeof(cblock))) {
+			ret = -EFAULT;
+			goto out;
+		}
+		blocks[i].uaddr = compat_ptr(cblock.uaddr);
+		blocks[i].val = cblock.val;
+		blocks[i].bitset = cblock.bitset;
+	}
+
+	ret = futex_wait_multiple(blocks, count, op, abs_time);
+out:
+	kfree(blocks);
+	return ret;
+}
+
 asmlinkage long compat_sys_futex(u32 __user *uaddr, int op, u32 val,
 		struct compat_timespec __user *utime, u32 __user *uaddr2,
 		u32 val3)
@@ -181,17 +220,21 @@ asmlinkage long compat_sys_futex(u32 __user *uaddr, int op, u32 val,
 
 	if (utime && (cmd == FUTEX_WAIT || cmd == FUTEX_LOCK_PI ||
 		      cmd == FUTEX_WAIT_BITSET ||
-		      cmd == FUTEX_WAIT_REQUEUE_PI)) {
+		      cmd == FUTEX_WAIT_REQUEUE_PI ||
+		      cmd == FUTEX_WAIT_MULTIPLE)) {
 		if (get_compat_timespec(&ts, utime))
 			return -EFAULT;
 		if (!timespec_valid(&ts))
 			return -EINVAL;
 
 		t = timespec_to_ktime(ts);
-		if (cmd == FUTEX_WAIT)
+		if (cmd == FUTEX_WAIT || cmd == FUTEX_WAIT_MULTIPLE)
 			t = ktime_add_safe(ktime_get(), t);
 		tp = &t;
 	}
+	if (cmd == FUTEX_WAIT_MULTIPLE)
+		return compat_futex_wait_multiple((void __user *)uaddr, val,
+						  op, tp);
 	if (cmd == FUTEX_REQUEUE || cmd == FUTEX_CMP_REQUEUE ||
 	    cmd == FUTEX_CMP_REQUEUE_PI || cmd == FUTEX_WAKE_OP)
 		val2 = (int) (unsigned long) utime;
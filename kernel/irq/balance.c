@@ -0,0 +1,385 @@
+/*
+ * linux/kernel/irq/balance.c
+ *
+ * In-kernel interrupt load balancer.
+ *
+ * The time spent in the handlers of every interrupt, and in hard and
+ * soft interrupt context on every cpu, is measured. Periodically the
+ * heaviest interrupt of the cpu with the most interrupt load that fits
+ * into the imbalance is moved to the online, non-isolated cpu with the
+ * least interrupt load. Interrupts that were moved recently, that cannot
+ * be balanced, or whose affinity was set by a driver or from userspace
+ * are left alone.
+ *
+ * Loads are expressed in microseconds per second of the time that passed
+ * since the previous pass, which may be longer than interval_ms as the
+ * balancing work is deferrable.
+ */
+
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/sched.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+#undef MODULE_PARAM_PREFIX
+#define MODULE_PARAM_PREFIX "irq_balance."
+
+/* balancing interval */
+static unsigned int interval_ms = 1000;
+module_param(interval_ms, uint, 0644);
+
+/* imbalance, in percent of the interval, below which nothing is moved */
+static unsigned int imbalance_pct = 5;
+module_param(imbalance_pct, uint, 0644);
+
+/* an interrupt is not moved again before this has passed */
+static unsigned int cooldown_ms = 10000;
+module_param(cooldown_ms, uint, 0644);
+
+struct static_key irq_balance_key = STATIC_KEY_INIT_FALSE;
+
+/* time spent in interrupt context, written by the local cpu only */
+static DEFINE_PER_CPU(u64, irq_balance_cpu_ns);
+static DEFINE_PER_CPU(u64, irq_balance_cpu_last_ns);
+/* interrupt load of the last interval, in us per second */
+static DEFINE_PER_CPU(u64, irq_balance_cpu_load);
+/* time of the last pass, or of enabling */
+static ktime_t irq_balance_last_pass;
+
+static struct {
+	unsigned long passes;
+	unsigned long moves;
+	unsigned int last_irq;
+	unsigned int last_from;
+	unsigned int last_to;
+	unsigned long last_jiffies;
+} irq_balance_stats;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(irq_balance_work, irq_balance_fn);
+static DEFINE_MUTEX(irq_balance_mutex);
+static bool irq_balance_on;
+
+void __irq_balance_account(struct irq_desc *desc, u64 start)
+{
+	u64 delta = local_clock() - start;
+	int cpu = smp_processor_id();
+
+	/*
+	 * An interrupt only runs on one cpu at a time, so there is no need
+	 * for atomics. A rare torn read by the balancer is harmless.
+	 */
+	desc->balance.ns += delta;
+	desc->balance.cpu = cpu;
+	__this_cpu_add(irq_balance_cpu_ns, delta);
+}
+
+void irq_balance_account_softirq(u64 start)
+{
+	__this_cpu_add(irq_balance_cpu_ns, local_clock() - start);
+}
+
+/* @ns spent in interrupt context out of @elapsed ns, in us per second */
+static inline u64 irq_balance_load(u64 ns, u64 elapsed)
+{
+	return div64_u64(ns * USEC_PER_SEC, elapsed);
+}
+
+/* Called with irq_balance_mutex held */
+static void irq_balance_update_cpus(const struct cpumask *cpus, u64 elapsed)
+{
+	int cpu;
+
+	for_each_cpu(cpu, cpus) {
+		u64 ns = per_cpu(irq_balance_cpu_ns, cpu);
+
+		per_cpu(irq_balance_cpu_load, cpu) = irq_balance_load(ns -
+				per_cpu(irq_balance_cpu_last_ns, cpu), elapsed);
+		per_cpu(irq_balance_cpu_last_ns, cpu) = ns;
+	}
+}
+
+/* Like irq_set_affinity(), without pinning the interrupt */
+static int irq_balance_move(struct irq_desc *desc, int cpu)
+{
+	unsigned long flags;
+	int ret;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	ret = irq_set_affinity_locked(irq_desc_get_irq_data(desc),
+				      cpumask_of(cpu), false);
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+	return ret;
+}
+
+static bool irq_balance_candidate(struct irq_desc *desc, unsigned long now)
+{
+	if (!desc->action || desc->balance.pinned)
+		return false;
+	if (!irqd_can_balance(&desc->irq_data) ||
+	    !irq_can_set_affinity(desc->irq_data.irq))
+		return false;
+	return !desc->balance.moves ||
+		time_after(now, desc->balance.last_move +
+				msecs_to_jiffies(cooldown_ms));
+}
+
+static void irq_balance_pass(void)
+{
+	u64 busiest_load = 0, idlest_load = ULLONG_MAX, imbalance, best_load;
+	struct irq_desc *desc, *best = NULL;
+	int cpu, busiest = -1, idlest = -1;
+	unsigned long now = jiffies;
+	ktime_t pass = ktime_get();
+	cpumask_var_t cpus;
+	unsigned int irq;
+	u64 elapsed;
+
+	elapsed = ktime_to_ns(ktime_sub(pass, irq_balance_last_pass));
+	if (!elapsed)
+		return;
+	if (!alloc_cpumask_var(&cpus, GFP_KERNEL))
+		return;
+	irq_balance_last_pass = pass;
+
+	get_online_cpus();
+	cpumask_andnot(cpus, cpu_online_mask, cpu_isolated_map);
+	irq_balance_update_cpus(cpus, elapsed);
+
+	for_each_cpu(cpu, cpus) {
+		u64 load = per_cpu(irq_balance_cpu_load, cpu);
+
+		if (load >= busiest_load) {
+			busiest_load = load;
+			busiest = cpu;
+		}
+		if (load < idlest_load) {
+			idlest_load = load;
+			idlest = cpu;
+		}
+	}
+
+	irq_lock_sparse();
+	for_each_irq_desc(irq, desc) {
+		u64 ns;
+
+		if (!desc)
+			continue;
+		ns = desc->balance.ns - desc->balance.last_ns;
+		desc->balance.last_ns += ns;
+		desc->balance.load = irq_balance_load(ns, elapsed);
+	}
+
+	irq_balance_stats.passes++;
+	if (busiest < 0 || idlest < 0 || busiest == idlest)
+		goto out;
+
+	/* hysteresis: small imbalances are not worth a migration */
+	imbalance = busiest_load - idlest_load;
+	if (imbalance * 100 <= (u64)USEC_PER_SEC * imbalance_pct)
+		goto out;
+
+	/*
+	 * Pick the heaviest interrupt of the busiest cpu that is lighter
+	 * than the imbalance, so that moving it cannot just swap the roles
+	 * of the two cpus.
+	 */
+	best_load = 0;
+	for_each_irq_desc(irq, desc) {
+		if (!desc || desc->balance.cpu != busiest)
+			continue;
+		if (!irq_balance_candidate(desc, now))
+			continue;
+		if (desc->balance.load > best_load &&
+		    desc->balance.load < imbalance) {
+			best = desc;
+			best_load = desc->balance.load;
+		}
+	}
+	if (!best)
+		goto out;
+
+	irq = best->irq_data.irq;
+	if (irq_balance_move(best, idlest))
+		goto out;
+
+	best->balance.moves++;
+	best->balance.last_move = now;
+	irq_balance_stats.moves++;
+	irq_balance_stats.last_irq = irq;
+	irq_balance_stats.last_from = busiest;
+	irq_balance_stats.last_to = idlest;
+	irq_balance_stats.last_jiffies = now;
+out:
+	irq_unlock_sparse();
+	put_online_cpus();
+	free_cpumask_var(cpus);
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	mutex_lock(&irq_balance_mutex);
+	if (irq_balance_on) {
+		irq_balance_pass();
+		schedule_delayed_work(&irq_balance_work,
+				      msecs_to_jiffies(interval_ms));
+	}
+	mutex_unlock(&irq_balance_mutex);
+}
+
+static void irq_balance_set(bool on)
+{
+	mutex_lock(&irq_balance_mutex);
+	if (on == irq_balance_on) {
+		mutex_unlock(&irq_balance_mutex);
+		return;
+	}
+	irq_balance_on = on;
+	if (on) {
+		irq_balance_last_pass = ktime_get();
+		static_key_slow_inc(&irq_balance_key);
+		schedule_delayed_work(&irq_balance_work,
+				      msecs_to_jiffies(interval_ms));
+	} else {
+		static_key_slow_dec(&irq_balance_key);
+	}
+	mutex_unlock(&irq_balance_mutex);
+
+	if (!on)
+		cancel_delayed_work_sync(&irq_balance_work);
+}
+
+/* off by default: it overrides the placement chosen by the platform */
+static bool enable;
+static bool irq_balance_ready;
+
+static int irq_balance_enable_set(const char *val,
+				  const struct kernel_param *kp)
+{
+	int ret = param_set_bool(val, kp);
+
+	/* on the command line, irq_balance_init() takes care of it */
+	if (!ret && irq_balance_ready)
+		irq_balance_set(enable);
+	return ret;
+}
+
+static struct kernel_param_ops irq_balance_enable_ops = {
+	.set = irq_balance_enable_set,
+	.get = param_get_bool,
+};
+module_param_cb(enable, &irq_balance_enable_ops, &enable, 0644);
+
+void irq_balance_pin(struct irq_desc *desc)
+{
+	desc->balance.pinned = true;
+}
+
+static int irq_balance_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long)m->private);
+
+	seq_printf(m, "pinned %d\n" "cpu %u\n" "load %llu us/s\n"
+		   "moves %u\n",
+		   desc->balance.pinned, desc->balance.cpu,
+		   desc->balance.load, desc->balance.moves);
+	if (desc->balance.moves)
+		seq_printf(m, "last_move %u ms ago\n",
+			   jiffies_to_msecs(jiffies - desc->balance.last_move));
+	else
+		seq_printf(m, "last_move never\n");
+	return 0;
+}
+
+static int irq_balance_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_balance_proc_show, PDE_DATA(inode));
+}
+
+/* Writing 1 keeps the balancer away from the interrupt, 0 releases it */
+static ssize_t irq_balance_proc_write(struct file *file,
+		const char __user *buffer, size_t count, loff_t *pos)
+{
+	struct irq_desc *desc = irq_to_desc((long)PDE_DATA(file_inode(file)));
+	char buf[4] = {};
+	bool pinned;
+
+	if (copy_from_user(buf, buffer, min(count, sizeof(buf) - 1)))
+		return -EFAULT;
+	if (strtobool(buf, &pinned))
+		return -EINVAL;
+
+	desc->balance.pinned = pinned;
+	return count;
+}
+
+static const struct file_operations irq_balance_proc_fops = {
+	.open		= irq_balance_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= irq_balance_proc_write,
+};
+
+void irq_balance_register_proc(unsigned int irq, struct irq_desc *desc)
+{
+	proc_create_data("balance", 0644, desc->dir,
+			 &irq_balance_proc_fops, (void *)(long)irq);
+}
+
+void irq_balance_unregister_proc(struct irq_desc *desc)
+{
+	remove_proc_entry("balance", desc->dir);
+}
+
+static int irq_balance_stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_printf(m, "enabled %d\n" "passes %lu\n" "moves %lu\n",
+		   irq_balance_on, irq_balance_stats.passes,
+		   irq_balance_stats.moves);
+	if (irq_balance_stats.moves)
+		seq_printf(m, "last irq %u cpu%u -> cpu%u %u ms\n",
+			   irq_balance_stats.last_irq,
+			   irq_balance_stats.last_from,
+			   irq_balance_stats.last_to,
+			   jiffies_to_msecs(irq_balance_stats.last_jiffies));
+
+	for_each_online_cpu(cpu)
+		seq_printf(m, "cpu%d %llu us/s%s\n", cpu,
+			   per_cpu(irq_balance_cpu_load, cpu),
+			   cpumask_test_cpu(cpu, cpu_isolated_map) ?
+			   " isolated" : "");
+	return 0;
+}
+
+static int irq_balance_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_balance_stats_show, NULL);
+}
+
+static const struct file_operations irq_balance_stats_fops = {
+	.open		= irq_balance_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init irq_balance_init(void)
+{
+	proc_create("irq/balance_stats", 0444, NULL, &irq_balance_stats_fops);
+
+	irq_balance_ready = true;
+	if (enable)
+		irq_balance_set(true);
+	return 0;
+}
+late_initcall(irq_balance_init);
@@ -135,6 +135,7 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 {
 	irqreturn_t retval = IRQ_NONE;
 	unsigned int flags = 0, irq = desc->irq_data.irq;
+	u64 balance_start = irq_balance_start();
 
 	do {
 		irqreturn_t res;
@@ -173,6 +174,8 @@ handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action)
 		action = action->next;
 	} while (action);
 
+	irq_balance_account(desc, balance_start);
+
 	add_interrupt_randomness(irq, flags);
 
 	if (!noirqdebug)
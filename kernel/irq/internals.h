@@ -6,6 +6,7 @@
  * of this file for your non core code.
  */
 #include <linux/irqdesc.h>
+#include <linux/sched.h>
 
 #ifdef CONFIG_SPARSE_IRQ
 # define IRQ_BITMAP_BITS	(NR_IRQS + 8196)
@@ -87,6 +88,32 @@ extern void init_kstat_irqs(struct irq_desc *desc, int node, int nr);
 irqreturn_t handle_irq_event_percpu(struct irq_desc *desc, struct irqaction *action);
 irqreturn_t handle_irq_event(struct irq_desc *desc);
 
+/* In-kernel irq balancer */
+#ifdef CONFIG_IRQ_BALANCE
+extern void __irq_balance_account(struct irq_desc *desc, u64 start);
+extern void irq_balance_pin(struct irq_desc *desc);
+extern void irq_balance_register_proc(unsigned int irq, struct irq_desc *desc);
+extern void irq_balance_unregister_proc(struct irq_desc *desc);
+
+static inline u64 irq_balance_start(void)
+{
+	return irq_balance_enabled() ? local_clock() : 0;
+}
+
+static inline void irq_balance_account(struct irq_desc *desc, u64 start)
+{
+	if (start)
+		__irq_balance_account(desc, start);
+}
+#else
+static inline u64 irq_balance_start(void) { return 0; }
+static inline void irq_balance_account(struct irq_desc *desc, u64 start) { }
+static inline void irq_balance_pin(struct irq_desc *desc) { }
+static inline void
+irq_balance_register_proc(unsigned int irq, struct irq_desc *desc) { }
+static inline void irq_balance_unregister_proc(struct irq_desc *desc) { }
+#endif
+
 /* Resending of interrupts :*/
 void check_irq_resend(struct irq_desc *desc, unsigned int irq);
 bool irq_wait_for_poll(struct irq_desc *desc);
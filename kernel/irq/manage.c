@@ -198,6 +198,9 @@ int __irq_set_affinity(unsigned int irq, const struct cpumask *mask, bool force)
 
 	raw_spin_lock_irqsave(&desc->lock, flags);
 	ret = irq_set_affinity_locked(irq_desc_get_irq_data(desc), mask, force);
+	/* an affinity chosen by a driver or by userspace is kept */
+	if (!ret)
+		irq_balance_pin(desc);
 	raw_spin_unlock_irqrestore(&desc->lock, flags);
 	return ret;
 }
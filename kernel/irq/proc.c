@@ -405,6 +405,9 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 
 	proc_create_data("node", 0444, desc->dir,
 			 &irq_node_proc_fops, (void *)(long)irq);
+
+	/* create /proc/irq/<irq>/balance */
+	irq_balance_register_proc(irq, desc);
 #endif
 
 	proc_create_data("spurious", 0444, desc->dir,
@@ -429,6 +432,7 @@ void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
 	remove_proc_entry("affinity_hint", desc->dir);
 	remove_proc_entry("smp_affinity_list", desc->dir);
 	remove_proc_entry("node", desc->dir);
+	irq_balance_unregister_proc(desc);
 #endif
 	remove_proc_entry("spurious", desc->dir);
 
@@ -264,11 +264,15 @@ rt_mutex_dequeue_pi(struct task_struct *task, struct rt_mutex_waiter *waiter)
  */
 int rt_mutex_getprio(struct task_struct *task)
 {
+	int prio = task->normal_prio;
+
+	if (unlikely(dl_donated(task)))
+		return MAX_DL_PRIO - 1;
+
 	if (likely(!task_has_pi_waiters(task)))
-		return task->normal_prio;
+		return prio;
 
-	return min(task_top_pi_waiter(task)->prio,
-		   task->normal_prio);
+	return min(task_top_pi_waiter(task)->prio, prio);
 }
 
 struct task_struct *rt_mutex_get_top_task(struct task_struct *task)
@@ -285,6 +289,9 @@ struct task_struct *rt_mutex_get_top_task(struct task_struct *task)
  */
 int rt_mutex_get_effective_prio(struct task_struct *task, int newprio)
 {
+	if (unlikely(dl_donated(task)))
+		return MAX_DL_PRIO - 1;
+
 	if (!task_has_pi_waiters(task))
 		return newprio;
 
@@ -330,6 +330,8 @@ struct rcu_data {
 	int nocb_p_count_lazy;		/*  (approximate). */
 	wait_queue_head_t nocb_wq;	/* For nocb kthreads to sleep on. */
 	struct task_struct *nocb_kthread;
+	unsigned long nocb_first_queued; /* jiffies, first CB of batch. */
+	bool nocb_lazy_wait;		/* Kthread batching lazy CBs. */
 #endif /* #ifdef CONFIG_RCU_NOCB_CPU */
 
 	/* 8) RCU CPU stall data. */
@@ -2020,6 +2020,29 @@ static int __init parse_rcu_nocb_poll(char *arg)
 }
 early_param("rcu_nocb_poll", parse_rcu_nocb_poll);
 
+/*
+ * A batch made up only of lazy callbacks (typically kfree_rcu()) is left
+ * to accumulate for up to rcu_nocb_lazy_delay jiffies before a grace
+ * period is requested for it, unless a non-lazy callback arrives or more
+ * than rcu_nocb_lazy_limit callbacks are queued.  Zero disables this.
+ */
+#define RCU_NOCB_LAZY_DELAY	HZ	/* Roughly one second. */
+#define RCU_NOCB_LAZY_LIMIT	1000
+
+static int rcu_nocb_lazy_delay = RCU_NOCB_LAZY_DELAY;
+module_param(rcu_nocb_lazy_delay, int, 0644);
+static long rcu_nocb_lazy_limit = RCU_NOCB_LAZY_LIMIT;
+module_param(rcu_nocb_lazy_limit, long, 0644);
+
+/* Does the no-CBs queue hold only a modest number of lazy callbacks? */
+static bool rcu_nocb_queue_lazy(struct rcu_data *rdp)
+{
+	long len = atomic_long_read(&rdp->nocb_q_count);
+
+	return len == atomic_long_read(&rdp->nocb_q_count_lazy) &&
+	       len < ACCESS_ONCE(rcu_nocb_lazy_limit);
+}
+
 /*
  * Wake up any no-CBs CPUs' kthreads that were waiting on the just-ended
  * grace period.
@@ -2078,6 +2101,8 @@ static void __call_rcu_nocb_enqueue(struct rcu_data *rdp,
 	ACCESS_ONCE(*old_rhpp) = rhp;
 	atomic_long_add(rhcount, &rdp->nocb_q_count);
 	atomic_long_add(rhcount_lazy, &rdp->nocb_q_count_lazy);
+	if (old_rhpp == &rdp->nocb_head)
+		ACCESS_ONCE(rdp->nocb_first_queued) = jiffies;
 
 	/* If we are not being polled and there is a kthread, awaken it ... */
 	t = ACCESS_ONCE(rdp->nocb_kthread);
@@ -2090,6 +2115,9 @@ static void __call_rcu_nocb_enqueue(struct rcu_data *rdp,
 	} else if (len > rdp->qlen_last_fqs_check + qhimark) {
 		wake_up_process(t); /* ... or if many callbacks queued. */
 		rdp->qlen_last_fqs_check = LONG_MAX / 2;
+	} else if (ACCESS_ONCE(rdp->nocb_lazy_wait) &&
+		   !rcu_nocb_queue_lazy(rdp)) {
+		wake_up(&rdp->nocb_wq); /* ... or to end lazy batching. */
 	}
 	return;
 }
@@ -2190,6 +2218,25 @@ static void rcu_nocb_wait_gp(struct rcu_data *rdp)
 	smp_mb(); /* Ensure that CB invocation happens after GP end. */
 }
 
+/*
+ * Give a lazy-only batch some time to grow, so that a CPU freeing
+ * memory through kfree_rcu() does not cost a grace period per handful
+ * of callbacks.
+ */
+static void rcu_nocb_lazy_batch(struct rcu_data *rdp)
+{
+	int delay = ACCESS_ONCE(rcu_nocb_lazy_delay);
+
+	if (delay <= 0 || !rcu_nocb_queue_lazy(rdp))
+		return;
+	ACCESS_ONCE(rdp->nocb_lazy_wait) = true;
+	smp_mb(); /* Enqueuers must see ->nocb_lazy_wait before we sleep. */
+	wait_event_interruptible_timeout(rdp->nocb_wq,
+					 !rcu_nocb_queue_lazy(rdp), delay);
+	ACCESS_ONCE(rdp->nocb_lazy_wait) = false;
+	flush_signals(current);
+}
+
 /*
  * Per-rcu_data kthread, but only for no-CBs CPUs.  Each kthread invokes
  * callbacks queued by the corresponding no-CBs CPU.
@@ -2197,6 +2244,7 @@ static void rcu_nocb_wait_gp(struct rcu_data *rdp)
 static int rcu_nocb_kthread(void *arg)
 {
 	int c, cl;
+	unsigned long queued;
 	struct rcu_head *list;
 	struct rcu_head *next;
 	struct rcu_head **tail;
@@ -2214,10 +2262,13 @@ static int rcu_nocb_kthread(void *arg)
 			continue;
 		}
 
+		rcu_nocb_lazy_batch(rdp);
+
 		/*
 		 * Extract queued callbacks, update counts, and wait
 		 * for a grace period to elapse.
 		 */
+		queued = ACCESS_ONCE(rdp->nocb_first_queued);
 		ACCESS_ONCE(rdp->nocb_head) = NULL;
 		tail = xchg(&rdp->nocb_tail, &rdp->nocb_head);
 		c = atomic_long_xchg(&rdp->nocb_q_count, 0);
@@ -2227,6 +2278,8 @@ static int rcu_nocb_kthread(void *arg)
 		rcu_nocb_wait_gp(rdp);
 
 		/* Each pass through the following loop invokes a callback. */
+		trace_rcu_nocb_batch(rdp->rsp->name, rdp->cpu, cl, c,
+				     jiffies_to_msecs(jiffies - queued));
 		trace_rcu_batch_start(rdp->rsp->name, cl, c, -1);
 		c = cl = 0;
 		while (list) {
@@ -893,7 +893,8 @@ void resched_task(struct task_struct *p)
 #endif /* CONFIG_SMP */
 
 #if defined(CONFIG_RT_GROUP_SCHED) || (defined(CONFIG_FAIR_GROUP_SCHED) && \
-			(defined(CONFIG_SMP) || defined(CONFIG_CFS_BANDWIDTH)))
+			(defined(CONFIG_SMP) || defined(CONFIG_CFS_BANDWIDTH))) || \
+	defined(CONFIG_UCLAMP_TASK)
 /*
  * Iterate task_group tree rooted at *from, calling @down when first entering a
  * node and @up when leaving it for the final time.
@@ -955,10 +956,250 @@ static void set_load_weight(struct task_struct *p)
 	load->inv_weight = prio_to_wmult[prio];
 }
 
+#ifdef CONFIG_UCLAMP_TASK
+/*
+ * Utilization clamping.
+ *
+ * Each RUNNABLE task is refcounted in the bucket of its rq matching its
+ * effective clamp value, for both the min and the max clamp. The clamp of
+ * the rq is the max clamp among its RUNNABLE tasks: the most boosted task
+ * sets the rq minimum, and the rq is only capped when all its tasks are.
+ * Buckets keep the dequeue side cheap, the max is only recomputed when the
+ * bucket holding it becomes empty.
+ */
+static inline unsigned int uclamp_bucket_id(unsigned int value)
+{
+	return min_t(unsigned int, value / UCLAMP_BUCKET_DELTA,
+		     UCLAMP_BUCKETS - 1);
+}
+
+static unsigned int uclamp_rq_max_value(struct rq *rq, int clamp_id)
+{
+	struct uclamp_bucket *bucket = rq->uclamp[clamp_id].bucket;
+	int bucket_id;
+
+	for (bucket_id = UCLAMP_BUCKETS - 1; bucket_id >= 0; bucket_id--) {
+		if (bucket[bucket_id].tasks)
+			return bucket[bucket_id].value;
+	}
+
+	return uclamp_none(clamp_id);
+}
+
+static void uclamp_rq_inc_id(struct rq *rq, struct task_struct *p,
+			     int clamp_id)
+{
+	struct uclamp_rq *uc_rq = &rq->uclamp[clamp_id];
+	struct uclamp_se *uc_se = &p->uclamp[clamp_id];
+	struct uclamp_bucket *bucket;
+	unsigned int value = uclamp_eff_value(p, clamp_id);
+
+	uc_se->value = value;
+	uc_se->bucket_id = uclamp_bucket_id(value);
+	uc_se->active = 1;
+
+	bucket = &uc_rq->bucket[uc_se->bucket_id];
+	if (!bucket->tasks++ || value > bucket->value)
+		bucket->value = value;
+
+	if (!uc_rq->tasks++ || value > uc_rq->value)
+		uc_rq->value = value;
+}
+
+static void uclamp_rq_dec_id(struct rq *rq, struct task_struct *p,
+			     int clamp_id)
+{
+	struct uclamp_rq *uc_rq = &rq->uclamp[clamp_id];
+	struct uclamp_se *uc_se = &p->uclamp[clamp_id];
+	struct uclamp_bucket *bucket = &uc_rq->bucket[uc_se->bucket_id];
+
+	if (WARN_ON_ONCE(!bucket->tasks || !uc_rq->tasks))
+		return;
+
+	uc_se->active = 0;
+	uc_rq->tasks--;
+	if (--bucket->tasks)
+		return;
+
+	if (uc_se->value >= uc_rq->value)
+		uc_rq->value = uclamp_rq_max_value(rq, clamp_id);
+}
+
+static inline void uclamp_rq_inc(struct rq *rq, struct task_struct *p)
+{
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+		uclamp_rq_inc_id(rq, p, clamp_id);
+}
+
+static inline void uclamp_rq_dec(struct rq *rq, struct task_struct *p)
+{
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		if (p->uclamp[clamp_id].active)
+			uclamp_rq_dec_id(rq, p, clamp_id);
+	}
+}
+
+/* Refcount a RUNNABLE task again after its requested clamps changed */
+static void __uclamp_update_active(struct rq *rq, struct task_struct *p)
+{
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		if (!p->uclamp[clamp_id].active)
+			continue;
+		uclamp_rq_dec_id(rq, p, clamp_id);
+		uclamp_rq_inc_id(rq, p, clamp_id);
+	}
+}
+
+static void uclamp_update_active(struct task_struct *p)
+{
+	unsigned long flags;
+	struct rq *rq;
+
+	rq = task_rq_lock(p, &flags);
+	__uclamp_update_active(rq, p);
+	task_rq_unlock(rq, p, &flags);
+}
+
+static int uclamp_validate(struct task_struct *p,
+			   const struct sched_attr *attr, bool user)
+{
+	unsigned int lo = p->uclamp_req[UCLAMP_MIN].value;
+	unsigned int hi = p->uclamp_req[UCLAMP_MAX].value;
+
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MIN)
+		lo = attr->sched_util_min;
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MAX)
+		hi = attr->sched_util_max;
+
+	if (lo > hi || hi > SCHED_UCLAMP_SCALE)
+		return -EINVAL;
+
+	/* Unprivileged users can't boost a task beyond its current boost */
+	if (user && lo > p->uclamp_req[UCLAMP_MIN].value &&
+	    !capable(CAP_SYS_NICE))
+		return -EPERM;
+
+	return 0;
+}
+
+/* Must hold pi & rq lock. */
+static void __setscheduler_uclamp(struct rq *rq, struct task_struct *p,
+				  const struct sched_attr *attr)
+{
+	if (!(attr->sched_flags & SCHED_FLAG_UTIL_CLAMP))
+		return;
+
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MIN)
+		p->uclamp_req[UCLAMP_MIN].value = attr->sched_util_min;
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MAX)
+		p->uclamp_req[UCLAMP_MAX].value = attr->sched_util_max;
+
+	__uclamp_update_active(rq, p);
+}
+
+static void uclamp_fork(struct task_struct *p)
+{
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		p->uclamp[clamp_id].active = 0;
+		if (p->sched_reset_on_fork)
+			p->uclamp_req[clamp_id].value = uclamp_none(clamp_id);
+	}
+}
+
+static void __init init_uclamp(void)
+{
+	int clamp_id, cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+			memset(&rq->uclamp[clamp_id], 0,
+			       sizeof(struct uclamp_rq));
+			rq->uclamp[clamp_id].value = uclamp_none(clamp_id);
+		}
+	}
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		init_task.uclamp_req[clamp_id].value = uclamp_none(clamp_id);
+		root_task_group.uclamp_req[clamp_id] = uclamp_none(clamp_id);
+		root_task_group.uclamp[clamp_id] = uclamp_none(clamp_id);
+	}
+}
+
+static void init_tg_uclamp(struct task_group *tg)
+{
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		tg->uclamp_req[clamp_id] = uclamp_none(clamp_id);
+		tg->uclamp[clamp_id] = uclamp_none(clamp_id);
+	}
+}
+
+static DEFINE_MUTEX(uclamp_mutex);
+
+/*
+ * A new group requests nothing, so it gets the effective range of its
+ * parent. This runs once the group is linked in, under uclamp_mutex, so
+ * that it cannot miss a concurrent change of the parent.
+ */
+static void online_tg_uclamp(struct task_group *tg)
+{
+	int clamp_id;
+
+	mutex_lock(&uclamp_mutex);
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+		tg->uclamp[clamp_id] = tg->parent->uclamp[clamp_id];
+	mutex_unlock(&uclamp_mutex);
+}
+
+/**
+ * sched_cpu_util_clamp - apply the clamps of the RUNNABLE tasks of a cpu
+ * @cpu: the cpu whose runqueue clamps apply
+ * @util: utilization estimate of @cpu, in [0..@max]
+ * @max: utilization of @cpu fully busy at its highest frequency
+ *
+ * Lets a cpufreq governor bias its frequency selection with the same
+ * aggregated clamps used for task placement.
+ */
+unsigned long sched_cpu_util_clamp(int cpu, unsigned long util,
+				   unsigned long max)
+{
+	return uclamp_rq_util(cpu_rq(cpu), util, max);
+}
+EXPORT_SYMBOL_GPL(sched_cpu_util_clamp);
+#else /* CONFIG_UCLAMP_TASK */
+static inline void uclamp_rq_inc(struct rq *rq, struct task_struct *p) { }
+static inline void uclamp_rq_dec(struct rq *rq, struct task_struct *p) { }
+
+static inline int uclamp_validate(struct task_struct *p,
+				  const struct sched_attr *attr, bool user)
+{
+	return attr->sched_flags & SCHED_FLAG_UTIL_CLAMP ? -EOPNOTSUPP : 0;
+}
+
+static inline void __setscheduler_uclamp(struct rq *rq, struct task_struct *p,
+					 const struct sched_attr *attr) { }
+static inline void uclamp_fork(struct task_struct *p) { }
+static inline void init_uclamp(void) { }
+static inline void init_tg_uclamp(struct task_group *tg) { }
+static inline void online_tg_uclamp(struct task_group *tg) { }
+#endif /* CONFIG_UCLAMP_TASK */
+
 static void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_queued(rq, p);
+	uclamp_rq_inc(rq, p);
 	p->sched_class->enqueue_task(rq, p, flags);
 	trace_sched_enq_deq_task(p, 1, cpumask_bits(&p->cpus_allowed)[0]);
 }
@@ -967,6 +1208,7 @@ static void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	sched_info_dequeued(rq, p);
+	uclamp_rq_dec(rq, p);
 	p->sched_class->dequeue_task(rq, p, flags);
 	trace_sched_enq_deq_task(p, 0, cpumask_bits(&p->cpus_allowed)[0]);
 }
@@ -2654,6 +2896,28 @@ scale_load_to_freq(u64 load, unsigned int src_freq, unsigned int dst_freq)
 	return div64_u64(load * (u64)src_freq, (u64)dst_freq);
 }
 
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+/*
+ * Busy time, in reference to the cpu's max_possible_freq, that the -dl
+ * entities queued on @rq have reserved over @window.
+ */
+static inline u64 dl_rq_busy(struct rq *rq, u64 window)
+{
+	int cpu = cpu_of(rq);
+	u64 busy = (rq->dl.running_bw * window) >> 20;
+
+	busy = div64_u64(busy * max_possible_freq * max_possible_efficiency,
+			 (u64)cpu_max_possible_freq(cpu) * cpu_efficiency(cpu));
+
+	return min(busy, window);
+}
+#else
+static inline u64 dl_rq_busy(struct rq *rq, u64 window)
+{
+	return 0;
+}
+#endif
+
 unsigned long sched_get_busy(int cpu)
 {
 	unsigned long flags;
@@ -2693,6 +2957,9 @@ unsigned long sched_get_busy(int cpu)
 	}
 
 	load = div64_u64(load, NSEC_PER_USEC);
+	load = uclamp_rq_util(rq, load, sched_ravg_window / NSEC_PER_USEC);
+	/* the -dl reservations must be met whatever the clamps say */
+	load = max(load, dl_rq_busy(rq, sched_ravg_window / NSEC_PER_USEC));
 
 	raw_spin_unlock_irqrestore(&rq->lock, flags);
 
@@ -3978,6 +4245,9 @@ static void __sched_fork(struct task_struct *p)
 	RB_CLEAR_NODE(&p->dl.rb_node);
 	init_dl_task_timer(&p->dl);
 	__dl_clear_params(p);
+#ifdef CONFIG_SCHED_DL_INHERIT
+	p->dl_donor.dl_runtime = 0;
+#endif
 
 	INIT_LIST_HEAD(&p->rt.run_list);
 
@@ -4028,6 +4298,7 @@ int sched_fork(struct task_struct *p)
 	int cpu = get_cpu();
 
 	__sched_fork(p);
+	uclamp_fork(p);
 	/*
 	 * We mark the process as running here. This guarantees that
 	 * nobody will actually run it, and a signal or other external
@@ -6192,27 +6463,13 @@ EXPORT_SYMBOL(sleep_on_timeout);
 
 #ifdef CONFIG_RT_MUTEXES
 
-/*
- * rt_mutex_setprio - set the current priority of a task
- * @p: task
- * @prio: prio value (kernel-internal form)
- *
- * This function changes the 'effective' priority of a task. It does
- * not touch ->normal_prio like __setscheduler().
- *
- * Used by the rt_mutex code to implement priority inheritance
- * logic. Call site only calls if the priority of the task changed.
- */
-void rt_mutex_setprio(struct task_struct *p, int prio)
+static void __rt_mutex_setprio(struct rq *rq, struct task_struct *p, int prio)
 {
 	int oldprio, queued, running, enqueue_flag = 0;
-	struct rq *rq;
 	const struct sched_class *prev_class;
 
 	BUG_ON(prio > MAX_PRIO);
 
-	rq = __task_rq_lock(p);
-
 	/*
 	 * Idle task boosting is a nono in general. There is one
 	 * exception, when PREEMPT_RT and NOHZ is active:
@@ -6228,7 +6485,7 @@ void rt_mutex_setprio(struct task_struct *p, int prio)
 	if (unlikely(p == rq->idle)) {
 		WARN_ON(p != rq->curr);
 		WARN_ON(p->pi_blocked_on);
-		goto out_unlock;
+		return;
 	}
 
 	trace_sched_pi_setprio(p, prio);
@@ -6249,11 +6506,14 @@ void rt_mutex_setprio(struct task_struct *p, int prio)
 	 * 2. -dl task is running and holds mutex A
 	 *      --> -dl task blocks on mutex A and could preempt the
 	 *          running task
+	 *
+	 * 3. a task works on behalf of a -dl task that lent it its
+	 *    parameters, see sched_dl_inherit()
 	 */
 	if (dl_prio(prio)) {
-		struct task_struct *pi_task = rt_mutex_get_top_task(p);
+		struct sched_dl_entity *pi_se = dl_pi_entity(p);
 		if (!dl_prio(p->normal_prio) ||
-		    (pi_task && dl_entity_preempt(&pi_task->dl, &p->dl))) {
+		    (pi_se && dl_entity_preempt(pi_se, &p->dl))) {
 			p->dl.dl_boosted = 1;
 			p->dl.dl_throttled = 0;
 			enqueue_flag = ENQUEUE_REPLENISH;
@@ -6280,13 +6540,140 @@ void rt_mutex_setprio(struct task_struct *p, int prio)
 		enqueue_task(rq, p, enqueue_flag);
 
 	check_class_changed(rq, p, prev_class, oldprio);
-out_unlock:
+}
+
+/*
+ * rt_mutex_setprio - set the current priority of a task
+ * @p: task
+ * @prio: prio value (kernel-internal form)
+ *
+ * This function changes the 'effective' priority of a task. It does
+ * not touch ->normal_prio like __setscheduler().
+ *
+ * Used by the rt_mutex code to implement priority inheritance
+ * logic. Call site only calls if the priority of the task changed.
+ */
+void rt_mutex_setprio(struct task_struct *p, int prio)
+{
+	struct rq *rq;
+
+	rq = __task_rq_lock(p);
+	__rt_mutex_setprio(rq, p, prio);
+	preempt_disable(); /* avoid rq from going away on us */
+	__task_rq_unlock(rq);
+
+	balance_callback(rq);
+	preempt_enable();
+}
+
+#ifdef CONFIG_SCHED_DL_INHERIT
+static void dl_donation_fill(struct sched_dl_donation *d,
+			     struct sched_dl_entity *dl_se)
+{
+	d->dl_runtime = dl_se->dl_runtime;
+	d->dl_deadline = dl_se->dl_deadline;
+	d->dl_period = dl_se->dl_period;
+	d->deadline = dl_se->deadline;
+}
+
+/**
+ * sched_dl_donation - get the deadline parameters @p can lend
+ * @p: the task that is about to wait for another one
+ * @d: where to store them
+ *
+ * These are @p's own parameters or the ones lent to it, whichever have
+ * the earlier deadline. Returns false if there are none.
+ */
+bool sched_dl_donation(struct task_struct *p, struct sched_dl_donation *d)
+{
+	struct sched_dl_entity *dl_se;
+	unsigned long flags;
+
+	if (!dl_prio(p->normal_prio) && !dl_donated(p))
+		return false;
+
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+	dl_se = dl_own_entity(p);
+	if (dl_se)
+		dl_donation_fill(d, dl_se);
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+
+	return dl_se != NULL;
+}
+EXPORT_SYMBOL_GPL(sched_dl_donation);
+
+/**
+ * sched_dl_lent - get the deadline parameters lent to @p
+ * @p: the task
+ * @d: where to store them, zeroed if there are none
+ *
+ * For saving them across a nested sched_dl_inherit().
+ */
+bool sched_dl_lent(struct task_struct *p, struct sched_dl_donation *d)
+{
+	unsigned long flags;
+	bool ret;
+
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+	ret = dl_donated(p);
+	if (ret)
+		dl_donation_fill(d, &p->dl_donor);
+	else
+		memset(d, 0, sizeof(*d));
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_dl_lent);
+
+/**
+ * sched_dl_inherit - run @p with lent deadline parameters
+ * @p: the task working on behalf of the lender
+ * @d: parameters from sched_dl_donation(), or NULL to give them back
+ *
+ * Like a -dl pi-waiter, the lender's reservation is used while it
+ * waits: @p is boosted to SCHED_DEADLINE with the lender's runtime,
+ * period and current deadline, and is not subject to admission control
+ * or throttling, until the parameters are given back.
+ */
+void sched_dl_inherit(struct task_struct *p, const struct sched_dl_donation *d)
+{
+	struct sched_dl_entity *dl_se = &p->dl_donor;
+	unsigned long flags;
+	struct rq *rq;
+	int prio;
+
+	if (d && !d->dl_runtime)
+		d = NULL;
+	if (!d && !dl_donated(p))
+		return;
+
+	raw_spin_lock_irqsave(&p->pi_lock, flags);
+	rq = __task_rq_lock(p);
+
+	if (d) {
+		dl_se->dl_runtime = d->dl_runtime;
+		dl_se->dl_deadline = d->dl_deadline;
+		dl_se->dl_period = d->dl_period;
+		dl_se->dl_bw = to_ratio(d->dl_period, d->dl_runtime);
+		dl_se->deadline = d->deadline;
+	} else {
+		dl_se->dl_runtime = 0;
+	}
+
+	prio = rt_mutex_getprio(p);
+	if (p->prio != prio || dl_prio(prio))
+		__rt_mutex_setprio(rq, p, prio);
+
 	preempt_disable(); /* avoid rq from going away on us */
 	__task_rq_unlock(rq);
+	raw_spin_unlock_irqrestore(&p->pi_lock, flags);
 
 	balance_callback(rq);
 	preempt_enable();
 }
+EXPORT_SYMBOL_GPL(sched_dl_inherit);
+#endif /* CONFIG_SCHED_DL_INHERIT */
 #endif
 
 void set_user_nice(struct task_struct *p, long nice)
@@ -6480,7 +6867,7 @@ __setparam_dl(struct task_struct *p, const struct sched_attr *attr)
 	dl_se->dl_runtime = attr->sched_runtime;
 	dl_se->dl_deadline = attr->sched_deadline;
 	dl_se->dl_period = attr->sched_period ?: dl_se->dl_deadline;
-	dl_se->flags = attr->sched_flags;
+	dl_se->flags = attr->sched_flags & ~SCHED_FLAG_UTIL_CLAMP;
 	dl_se->dl_bw = to_ratio(dl_se->dl_period, dl_se->dl_runtime);
 
 	/*
@@ -6632,7 +7019,7 @@ static bool dl_param_changed(struct task_struct *p,
 	if (dl_se->dl_runtime != attr->sched_runtime ||
 		dl_se->dl_deadline != attr->sched_deadline ||
 		dl_se->dl_period != attr->sched_period ||
-		dl_se->flags != attr->sched_flags)
+		dl_se->flags != (attr->sched_flags & ~SCHED_FLAG_UTIL_CLAMP))
 		return true;
 
 	return false;
@@ -6668,7 +7055,8 @@ recheck:
 			return -EINVAL;
 	}
 
-	if (attr->sched_flags & ~(SCHED_FLAG_RESET_ON_FORK))
+	if (attr->sched_flags &
+	    ~(SCHED_FLAG_RESET_ON_FORK | SCHED_FLAG_UTIL_CLAMP))
 		return -EINVAL;
 
 	/*
@@ -6683,6 +7071,10 @@ recheck:
 	    (rt_policy(policy) != (attr->sched_priority != 0)))
 		return -EINVAL;
 
+	retval = uclamp_validate(p, attr, user);
+	if (retval)
+		return retval;
+
 	/*
 	 * Allow unprivileged RT tasks to decrease priority:
 	 */
@@ -6768,6 +7160,7 @@ recheck:
 		if (dl_policy(policy) && dl_param_changed(p, attr))
 			goto change;
 
+		__setscheduler_uclamp(rq, p, attr);
 		task_rq_unlock(rq, p, &flags);
 		return 0;
 	}
@@ -6821,6 +7214,8 @@ change:
 		return -EBUSY;
 	}
 
+	__setscheduler_uclamp(rq, p, attr);
+
 	p->sched_reset_on_fork = reset_on_fork;
 	oldprio = p->prio;
 
@@ -6915,6 +7310,22 @@ int sched_setattr(struct task_struct *p, const struct sched_attr *attr)
 }
 EXPORT_SYMBOL_GPL(sched_setattr);
 
+/**
+ * sched_setattr_nocheck - change the scheduling attributes of a thread from kernelspace.
+ * @p: the task in question.
+ * @attr: structure containing the new policy, priority and clamps.
+ *
+ * Like sched_setattr(), without the permission checks; see
+ * sched_setscheduler_nocheck().
+ *
+ * Return: 0 on success. An error code otherwise.
+ */
+int sched_setattr_nocheck(struct task_struct *p, const struct sched_attr *attr)
+{
+	return __sched_setscheduler(p, attr, false);
+}
+EXPORT_SYMBOL_GPL(sched_setattr_nocheck);
+
 /**
  * sched_setscheduler_nocheck - change the scheduling policy and/or RT priority of a thread from kernelspace.
  * @p: the task in question.
@@ -7014,6 +7425,10 @@ static int sched_copy_attr(struct sched_attr __user *uattr,
 	if (ret)
 		return -EFAULT;
 
+	if ((attr->sched_flags & SCHED_FLAG_UTIL_CLAMP) &&
+	    size < SCHED_ATTR_SIZE_VER1)
+		return -EINVAL;
+
 	/*
 	 * XXX: do we want to be lenient like existing syscalls; or do we want
 	 * to be strict and return an error on out-of-bounds values?
@@ -7235,6 +7650,14 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		attr.sched_nice = TASK_NICE(p);
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* Old user-space does not know about, and can't be handed, clamps */
+	if (size >= SCHED_ATTR_SIZE_VER1) {
+		attr.sched_util_min = p->uclamp_req[UCLAMP_MIN].value;
+		attr.sched_util_max = p->uclamp_req[UCLAMP_MAX].value;
+	}
+#endif
+
 	rcu_read_unlock();
 
 	retval = sched_read_attr(uattr, &attr, size);
@@ -8989,7 +9412,7 @@ cpu_attach_domain(struct sched_domain *sd, struct root_domain *rd, int cpu)
 }
 
 /* cpus with isolated domains */
-static cpumask_var_t cpu_isolated_map;
+cpumask_var_t cpu_isolated_map;
 
 /* Setup the mask of cpus configured for isolated domains */
 static int __init isolated_cpu_setup(char *str)
@@ -10430,6 +10853,7 @@ void __init sched_init(void)
 	idle_thread_set_boot_cpu();
 #endif
 	init_sched_fair_class();
+	init_uclamp();
 
 	scheduler_running = 1;
 }
@@ -10617,6 +11041,8 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!tg)
 		return ERR_PTR(-ENOMEM);
 
+	init_tg_uclamp(tg);
+
 	if (!alloc_fair_sched_group(tg, parent))
 		goto err;
 
@@ -10643,6 +11069,8 @@ void sched_online_group(struct task_group *tg, struct task_group *parent)
 	INIT_LIST_HEAD(&tg->children);
 	list_add_rcu(&tg->siblings, &parent->children);
 	spin_unlock_irqrestore(&task_group_lock, flags);
+
+	online_tg_uclamp(tg);
 }
 
 /* rcu callback to free various structures associated with a task group */
@@ -11516,6 +11944,68 @@ static u64 cpu_rt_period_read_uint(struct cgroup *cgrp, struct cftype *cft)
 }
 #endif /* CONFIG_RT_GROUP_SCHED */
 
+#ifdef CONFIG_UCLAMP_TASK
+static u64 cpu_util_clamp_read_u64(struct cgroup *cgrp, struct cftype *cft)
+{
+	return cgroup_tg(cgrp)->uclamp_req[cft->private];
+}
+
+/*
+ * The effective range of a group is its requested range restricted to the
+ * effective range of its parent, so that no group gives its tasks more,
+ * or less, than its ancestors allow.
+ */
+static int tg_update_uclamp(struct task_group *tg, void *data)
+{
+	struct task_group *parent = tg->parent;
+	struct cgroup *cgrp = tg->css.cgroup;
+	struct cgroup_iter it;
+	struct task_struct *p;
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+		tg->uclamp[clamp_id] = clamp(tg->uclamp_req[clamp_id],
+					     parent->uclamp[UCLAMP_MIN],
+					     parent->uclamp[UCLAMP_MAX]);
+
+	/* Refcount the RUNNABLE tasks of the group with the new range */
+	cgroup_iter_start(cgrp, &it);
+	while ((p = cgroup_iter_next(cgrp, &it)))
+		uclamp_update_active(p);
+	cgroup_iter_end(cgrp, &it);
+	return 0;
+}
+
+static int cpu_util_clamp_write_u64(struct cgroup *cgrp, struct cftype *cft,
+				    u64 value)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	int clamp_id = cft->private;
+	int ret = 0;
+
+	if (tg == &root_task_group)
+		return -EINVAL;
+	if (value > SCHED_UCLAMP_SCALE)
+		return -ERANGE;
+
+	mutex_lock(&uclamp_mutex);
+	if ((clamp_id == UCLAMP_MIN && value > tg->uclamp_req[UCLAMP_MAX]) ||
+	    (clamp_id == UCLAMP_MAX && value < tg->uclamp_req[UCLAMP_MIN])) {
+		ret = -EINVAL;
+		goto out;
+	}
+	tg->uclamp_req[clamp_id] = value;
+
+	/* Propagate to the group and all of its descendants */
+	rcu_read_lock();
+	walk_tg_tree_from(tg, tg_update_uclamp, tg_nop, NULL);
+	rcu_read_unlock();
+out:
+	mutex_unlock(&uclamp_mutex);
+	return ret;
+}
+#endif /* CONFIG_UCLAMP_TASK */
+
 static struct cftype cpu_files[] = {
 	{
 		.name = "notify_on_migrate",
@@ -11529,6 +12019,22 @@ static struct cftype cpu_files[] = {
 		.write_u64 = cpu_upmigrate_discourage_write_u64,
 	},
 #endif
+#ifdef CONFIG_UCLAMP_TASK
+	{
+		.name = "util_min",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.private = UCLAMP_MIN,
+		.read_u64 = cpu_util_clamp_read_u64,
+		.write_u64 = cpu_util_clamp_write_u64,
+	},
+	{
+		.name = "util_max",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.private = UCLAMP_MAX,
+		.read_u64 = cpu_util_clamp_read_u64,
+		.write_u64 = cpu_util_clamp_write_u64,
+	},
+#endif
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
 		.name = "shares",
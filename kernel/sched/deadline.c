@@ -72,6 +72,9 @@ void init_dl_bw(struct dl_bw *dl_b)
 void init_dl_rq(struct dl_rq *dl_rq)
 {
 	dl_rq->rb_root = RB_ROOT;
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+	dl_rq->running_bw = 0;
+#endif
 
 #ifdef CONFIG_SMP
 	/* zero means no -deadline tasks */
@@ -685,6 +688,26 @@ int dl_runtime_exceeded(struct sched_dl_entity *dl_se)
 
 extern bool sched_rt_bandwidth_account(struct rt_rq *rt_rq);
 
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+/*
+ * Runtime is reserved in terms of the most efficient cpu at the highest
+ * possible frequency, charge the time a task ran at the speed it ran at.
+ */
+static inline u64 dl_scale_exec(struct rq *rq, u64 delta)
+{
+	int cpu = cpu_of(rq);
+	unsigned int cur_freq = min(cpu_cur_freq(cpu), max_possible_freq);
+
+	delta = div64_u64(delta * cur_freq, max_possible_freq);
+	return div64_u64(delta * cpu_efficiency(cpu), max_possible_efficiency);
+}
+#else
+static inline u64 dl_scale_exec(struct rq *rq, u64 delta)
+{
+	return delta;
+}
+#endif
+
 /*
  * Update the current task's runtime statistics (provided it is still
  * a -deadline task and has not been removed from the dl_rq).
@@ -721,7 +744,7 @@ static void update_curr_dl(struct rq *rq)
 
 	sched_rt_avg_update(rq, delta_exec);
 
-	dl_se->runtime -= dl_se->dl_yielded ? 0 : delta_exec;
+	dl_se->runtime -= dl_se->dl_yielded ? 0 : dl_scale_exec(rq, delta_exec);
 	if (dl_runtime_exceeded(dl_se)) {
 		dl_se->dl_throttled = 1;
 		__dequeue_task_dl(rq, curr, 0);
@@ -824,6 +847,43 @@ dec_hmp_sched_stats_dl(struct rq *rq, struct task_struct *p) { }
 
 #endif	/* CONFIG_SCHED_HMP */
 
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+
+/*
+ * A boosted entity runs on the bandwidth of its lender or pi-waiter,
+ * which is not queued while it waits.
+ */
+static void inc_dl_running_bw(struct sched_dl_entity *dl_se,
+			      struct dl_rq *dl_rq)
+{
+	struct sched_dl_entity *pi_se = NULL;
+	u64 bw = dl_se->dl_bw;
+
+	if (dl_se->dl_boosted)
+		pi_se = dl_pi_entity(dl_task_of(dl_se));
+	if (pi_se)
+		bw = max(bw, pi_se->dl_bw);
+
+	dl_se->dl_running_bw = bw;
+	dl_rq->running_bw += bw;
+}
+
+static void dec_dl_running_bw(struct sched_dl_entity *dl_se,
+			      struct dl_rq *dl_rq)
+{
+	dl_rq->running_bw -= dl_se->dl_running_bw;
+}
+
+#else	/* CONFIG_SCHED_DL_FREQ_SCALE */
+
+static inline void
+inc_dl_running_bw(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq) { }
+
+static inline void
+dec_dl_running_bw(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq) { }
+
+#endif	/* CONFIG_SCHED_DL_FREQ_SCALE */
+
 static inline
 void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
@@ -834,6 +894,7 @@ void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 	dl_rq->dl_nr_running++;
 	inc_nr_running(rq_of_dl_rq(dl_rq));
 	inc_hmp_sched_stats_dl(rq_of_dl_rq(dl_rq), dl_task_of(dl_se));
+	inc_dl_running_bw(dl_se, dl_rq);
 
 	inc_dl_deadline(dl_rq, deadline);
 	inc_dl_migration(dl_se, dl_rq);
@@ -849,6 +910,7 @@ void dec_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 	dl_rq->dl_nr_running--;
 	dec_nr_running(rq_of_dl_rq(dl_rq));
 	dec_hmp_sched_stats_dl(rq_of_dl_rq(dl_rq), dl_task_of(dl_se));
+	dec_dl_running_bw(dl_se, dl_rq);
 
 	dec_dl_deadline(dl_rq, dl_se->deadline);
 	dec_dl_migration(dl_se, dl_rq);
@@ -930,17 +992,17 @@ static void dequeue_dl_entity(struct sched_dl_entity *dl_se)
 
 static void enqueue_task_dl(struct rq *rq, struct task_struct *p, int flags)
 {
-	struct task_struct *pi_task = rt_mutex_get_top_task(p);
+	struct sched_dl_entity *boost_se = dl_pi_entity(p);
 	struct sched_dl_entity *pi_se = &p->dl;
 
 	/*
 	 * Use the scheduling parameters of the top pi-waiter
-	 * task if we have one and its (absolute) deadline is
-	 * smaller than our one... OTW we keep our runtime and
-	 * deadline.
+	 * task, or the ones lent to us, if we have them and their
+	 * (absolute) deadline is smaller than our one... OTW we
+	 * keep our runtime and deadline.
 	 */
-	if (pi_task && p->dl.dl_boosted && dl_prio(pi_task->normal_prio)) {
-		pi_se = &pi_task->dl;
+	if (boost_se && p->dl.dl_boosted) {
+		pi_se = boost_se;
 	} else if (!dl_prio(p->normal_prio)) {
 		/*
 		 * Special case in which we have a !SCHED_DEADLINE task
@@ -1872,7 +1872,7 @@ static int task_load_will_fit(struct task_struct *p, u64 task_load, int cpu)
 
 static int task_will_fit(struct task_struct *p, int cpu)
 {
-	u64 tload = scale_load_to_cpu(task_load(p), cpu);
+	u64 tload = scale_load_to_cpu(task_placement_load(p), cpu);
 	return task_load_will_fit(p, tload, cpu);
 }
 
@@ -2001,7 +2001,8 @@ static inline unsigned int power_cost_task(struct task_struct *p, int cpu)
 	if (!sysctl_sched_enable_power_aware)
 		return cpu_max_possible_capacity(cpu);
 	else
-		return __power_cost(scale_load_to_cpu(task_load(p), cpu), cpu);
+		return __power_cost(scale_load_to_cpu(task_placement_load(p),
+						      cpu), cpu);
 }
 
 static int best_small_task_cpu(struct task_struct *p, int sync)
@@ -2035,7 +2036,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 				     mostly_idle_cpu_sync(i,
 						  cpu_load_sync(i, sync), sync),
 				     sched_irqload(i),
-				     power_cost(scale_load_to_cpu(task_load(p),
+				     power_cost(scale_load_to_cpu(task_placement_load(p),
 						i), i), cpu_temp(i));
 
 		if (cpu_max_possible_capacity(i) == max_possible_capacity &&
@@ -2077,7 +2078,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 		if (sched_cpu_high_irqload(i))
 			continue;
 
-		tload = scale_load_to_cpu(task_load(p), i);
+		tload = scale_load_to_cpu(task_placement_load(p), i);
 		cpu_load = cpu_load_sync(i, sync);
 		if (!spill_threshold_crossed(tload, cpu_load, rq)) {
 			if (cpu_load < min_load ||
@@ -2095,7 +2096,7 @@ static int best_small_task_cpu(struct task_struct *p, int sync)
 		rq = cpu_rq(i);
 		prev_cpu = (i == task_cpu(p));
 
-		tload = scale_load_to_cpu(task_load(p), i);
+		tload = scale_load_to_cpu(task_placement_load(p), i);
 		cpu_cost = power_cost(tload, i);
 		if (cpu_cost < min_cost ||
 		   (prev_cpu && cpu_cost == min_cost)) {
@@ -2229,7 +2230,8 @@ static int select_packing_target(struct task_struct *p, int best_cpu)
 
 	/* Pick the first lowest power cpu as target */
 	for_each_cpu(i, &search_cpus) {
-		int cost = power_cost(scale_load_to_cpu(task_load(p), i), i);
+		int cost = power_cost(scale_load_to_cpu(task_placement_load(p),
+							i), i);
 
 		if (cost < min_cost && !sched_cpu_high_irqload(i)) {
 			target = i;
@@ -2332,7 +2334,7 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 				     mostly_idle_cpu_sync(i,
 						  cpu_load_sync(i, sync), sync),
 				     sched_irqload(i),
-				     power_cost(scale_load_to_cpu(task_load(p),
+				     power_cost(scale_load_to_cpu(task_placement_load(p),
 						i), i), cpu_temp(i));
 		if (skip_freq_domain(task_cpu(p), i, reason, pref_cluster)) {
 			cpumask_andnot(&search_cpus, &search_cpus,
@@ -2342,7 +2344,7 @@ static int select_best_cpu(struct task_struct *p, int target, int reason,
 
 		cpumask_clear_cpu(i, &search_cpus);
 
-		tload =  scale_load_to_cpu(task_load(p), i);
+		tload =  scale_load_to_cpu(task_placement_load(p), i);
 		if (skip_cpu(trq, rq, i, tload, reason))
 			continue;
 
@@ -3004,7 +3006,7 @@ static int lower_power_cpu_available(struct task_struct *p, int cpu)
 {
 	int i;
 	int lowest_power_cpu = task_cpu(p);
-	int lowest_power = power_cost(scale_load_to_cpu(task_load(p),
+	int lowest_power = power_cost(scale_load_to_cpu(task_placement_load(p),
 					lowest_power_cpu), lowest_power_cpu);
 	struct cpumask search_cpus;
 	struct rq *rq = cpu_rq(cpu);
@@ -3021,7 +3023,8 @@ static int lower_power_cpu_available(struct task_struct *p, int cpu)
 	for_each_cpu(i, &search_cpus) {
 		if (idle_cpu(i)) {
 			int cost =
-			 power_cost(scale_load_to_cpu(task_load(p), i), i);
+			 power_cost(scale_load_to_cpu(task_placement_load(p),
+						      i), i);
 			if (cost < lowest_power) {
 				lowest_power_cpu = i;
 				lowest_power = cost;
@@ -121,6 +121,57 @@ dl_entity_preempt(struct sched_dl_entity *a, struct sched_dl_entity *b)
 	return dl_time_before(a->deadline, b->deadline);
 }
 
+/*
+ * The deadline parameters @p has of its own or has been lent, whichever
+ * have the earlier deadline, or NULL if it has neither.
+ */
+static inline struct sched_dl_entity *dl_own_entity(struct task_struct *p)
+{
+	struct sched_dl_entity *dl_se = NULL;
+
+	if (dl_prio(p->normal_prio))
+		dl_se = &p->dl;
+#ifdef CONFIG_SCHED_DL_INHERIT
+	if (dl_donated(p) &&
+	    (!dl_se || dl_entity_preempt(&p->dl_donor, dl_se)))
+		dl_se = &p->dl_donor;
+#endif
+	return dl_se;
+}
+
+/*
+ * The deadline parameters a boosted @p runs with: those of its top
+ * pi-waiter or those lent to it, whichever has the earlier deadline.
+ *
+ * A pi-waiter which is itself only boosted (a -dl donee blocked on our
+ * lock, or an owner boosted by a waiter of its own) has no parameters
+ * of its own, so the chain is followed to the task the boost came from.
+ * Thus this is never NULL while @p is boosted into the -dl class.
+ */
+static inline struct sched_dl_entity *dl_pi_entity(struct task_struct *p)
+{
+	struct task_struct *pi_task = rt_mutex_get_top_task(p);
+	struct sched_dl_entity *pi_se = NULL, *dl_se;
+	int depth = 0;
+
+#ifdef CONFIG_SCHED_DL_INHERIT
+	if (dl_donated(p))
+		pi_se = &p->dl_donor;
+#endif
+	while (pi_task && dl_prio(pi_task->prio)) {
+		dl_se = dl_own_entity(pi_task);
+		if (dl_se) {
+			if (!pi_se || dl_entity_preempt(dl_se, pi_se))
+				pi_se = dl_se;
+			break;
+		}
+		if (++depth > max_lock_depth)
+			break;
+		pi_task = rt_mutex_get_top_task(pi_task);
+	}
+	return pi_se;
+}
+
 /*
  * This is the priority-queue data structure of the RT scheduling class:
  */
@@ -237,6 +288,12 @@ struct task_group {
 #ifdef CONFIG_SCHED_HMP
 	bool upmigrate_discouraged;
 #endif
+#ifdef CONFIG_UCLAMP_TASK
+	/* range the clamps of the tasks in this group are restricted to */
+	unsigned int uclamp_req[UCLAMP_CNT];
+	/* uclamp_req restricted to the effective range of the parent */
+	unsigned int uclamp[UCLAMP_CNT];
+#endif
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* schedulable entities of this group on each cpu */
@@ -531,6 +588,11 @@ struct dl_rq {
 
 	unsigned long dl_nr_running;
 
+#ifdef CONFIG_SCHED_DL_FREQ_SCALE
+	/* sum of the bandwidths of the queued entities */
+	u64 running_bw;
+#endif
+
 #ifdef CONFIG_SMP
 	/*
 	 * Deadline values of the currently executing and the
@@ -599,6 +661,31 @@ extern struct root_domain def_root_domain;
 
 #endif /* CONFIG_SMP */
 
+#ifdef CONFIG_UCLAMP_TASK
+#define UCLAMP_BUCKETS		CONFIG_UCLAMP_BUCKETS_COUNT
+#define UCLAMP_BUCKET_DELTA	DIV_ROUND_CLOSEST(SCHED_UCLAMP_SCALE, \
+						  UCLAMP_BUCKETS)
+
+/*
+ * Number of RUNNABLE tasks refcounted in a clamp bucket, and the max
+ * clamp value among them.
+ */
+struct uclamp_bucket {
+	unsigned int value;
+	unsigned int tasks;
+};
+
+/*
+ * Per clamp index aggregation of the RUNNABLE tasks of a rq: @value is
+ * the max clamp among them, or the no-clamp value when there are none.
+ */
+struct uclamp_rq {
+	unsigned int value;
+	unsigned int tasks;
+	struct uclamp_bucket bucket[UCLAMP_BUCKETS];
+};
+#endif
+
 /*
  * This is the main, per-CPU runqueue data structure.
  *
@@ -636,6 +723,11 @@ struct rq {
 	struct rt_rq rt;
 	struct dl_rq dl;
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* utilization clamps of the RUNNABLE tasks */
+	struct uclamp_rq uclamp[UCLAMP_CNT];
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this cpu: */
 	struct list_head leaf_cfs_rq_list;
@@ -1348,6 +1440,70 @@ static inline bool task_notify_on_migrate(struct task_struct *p)
 }
 #endif /* CONFIG_CGROUP_SCHED */
 
+#ifdef CONFIG_UCLAMP_TASK
+static inline unsigned int uclamp_none(int clamp_id)
+{
+	return clamp_id == UCLAMP_MIN ? 0 : SCHED_UCLAMP_SCALE;
+}
+
+/* The task request, restricted to the range allowed by its task group */
+static inline unsigned int uclamp_eff_value(struct task_struct *p,
+					    int clamp_id)
+{
+	struct task_group *tg = task_group(p);
+	unsigned int value = p->uclamp_req[clamp_id].value;
+
+	return clamp(value, tg->uclamp[UCLAMP_MIN], tg->uclamp[UCLAMP_MAX]);
+}
+
+/*
+ * Clamp @util, expressed in [0..@max], to [@min_clamp..@max_clamp]
+ * expressed in [0..SCHED_UCLAMP_SCALE]. A boost wins over a cap.
+ */
+static inline u64 __uclamp_util(u64 util, u64 max,
+				unsigned int min_clamp, unsigned int max_clamp)
+{
+	u64 lo = (max * min_clamp) >> SCHED_UCLAMP_SHIFT;
+	u64 hi = (max * max_clamp) >> SCHED_UCLAMP_SHIFT;
+
+	if (lo >= hi)
+		return lo;
+
+	return clamp(util, lo, hi);
+}
+
+static inline u64 uclamp_task_util(struct task_struct *p, u64 util, u64 max)
+{
+	return __uclamp_util(util, max, uclamp_eff_value(p, UCLAMP_MIN),
+			     uclamp_eff_value(p, UCLAMP_MAX));
+}
+
+static inline u64 uclamp_rq_util(struct rq *rq, u64 util, u64 max)
+{
+	return __uclamp_util(util, max,
+			     ACCESS_ONCE(rq->uclamp[UCLAMP_MIN].value),
+			     ACCESS_ONCE(rq->uclamp[UCLAMP_MAX].value));
+}
+#else /* CONFIG_UCLAMP_TASK */
+static inline u64 uclamp_task_util(struct task_struct *p, u64 util, u64 max)
+{
+	return util;
+}
+
+static inline u64 uclamp_rq_util(struct rq *rq, u64 util, u64 max)
+{
+	return util;
+}
+#endif /* CONFIG_UCLAMP_TASK */
+
+#ifdef CONFIG_SCHED_HMP
+/* Task demand as seen by task placement, i.e. with its clamps applied */
+static inline unsigned int task_placement_load(struct task_struct *p)
+{
+	return uclamp_task_util(p, task_load(p), max_task_load());
+}
+#endif
+
 static inline void __set_task_cpu(struct task_struct *p, unsigned int cpu)
 {
 	set_task_rq(p, cpu);
@@ -9,6 +9,7 @@
  */
 
 #include <linux/export.h>
+#include <linux/moduleparam.h>
 #include <linux/kernel_stat.h>
 #include <linux/interrupt.h>
 #include <linux/init.h>
@@ -60,6 +61,107 @@ char *softirq_to_name[NR_SOFTIRQS] = {
 	"TASKLET", "SCHED", "HRTIMER", "RCU"
 };
 
+#ifdef CONFIG_SOFTIRQ_THREADS
+/*
+ * Vectors in softirq_threaded_mask are not run inline on irq exit but by
+ * a thread of their own per cpu, which the scheduler can prioritize and
+ * account like any other task, so that a burst of one vector no longer
+ * delays all the others. Only vectors that are raised from contexts where
+ * waking up a task is safe may be threaded.
+ */
+#define SOFTIRQ_THREADABLE_MASK	((1 << HI_SOFTIRQ) | (1 << NET_TX_SOFTIRQ) | \
+				 (1 << NET_RX_SOFTIRQ) | (1 << BLOCK_SOFTIRQ) | \
+				 (1 << BLOCK_IOPOLL_SOFTIRQ) | \
+				 (1 << TASKLET_SOFTIRQ))
+
+static unsigned int threaded = CONFIG_SOFTIRQ_THREADED_MASK;
+module_param(threaded, uint, 0444);
+
+/*
+ * Inline budget per vector, in us: a vector whose handler ran longer is
+ * not restarted inline but left to its thread or to ksoftirqd.
+ */
+static unsigned int budget_us[NR_SOFTIRQS];
+module_param_array(budget_us, uint, NULL, 0644);
+
+static u32 softirq_threaded_mask __read_mostly;
+static DEFINE_PER_CPU(u32, softirq_thread_pending);
+static DEFINE_PER_CPU(struct task_struct *, softirq_thread[NR_SOFTIRQS]);
+static DEFINE_PER_CPU(u64, softirq_runtime[NR_SOFTIRQS]);
+
+u64 softirq_runtime_cpu(unsigned int nr, int cpu)
+{
+	return per_cpu(softirq_runtime[nr], cpu);
+}
+
+static inline u64 softirq_runtime_start(void)
+{
+	return local_clock();
+}
+
+/* Returns true if the handler of @nr overran its inline budget */
+static inline bool softirq_runtime_account(unsigned int nr, u64 start)
+{
+	unsigned int budget = ACCESS_ONCE(budget_us[nr]);
+	u64 delta = local_clock() - start;
+
+	__this_cpu_add(softirq_runtime[nr], delta);
+	return budget && delta > (u64)budget * NSEC_PER_USEC;
+}
+
+/*
+ * Hand the threaded vectors of @pending over to their threads and return
+ * the vectors left to run inline. Must be called with irqs disabled.
+ */
+static u32 softirq_dispatch_threads(u32 pending)
+{
+	u32 mask = pending & softirq_threaded_mask;
+	struct task_struct *tsk;
+	int nr;
+
+	for (nr = 0; mask; nr++, mask >>= 1) {
+		if (!(mask & 1))
+			continue;
+		/* not spawned yet: run it inline */
+		tsk = __this_cpu_read(softirq_thread[nr]);
+		if (!tsk)
+			continue;
+
+		pending &= ~(1U << nr);
+		__this_cpu_or(softirq_thread_pending, 1U << nr);
+		if (tsk->state != TASK_RUNNING)
+			wake_up_process(tsk);
+	}
+
+	return pending;
+}
+
+static inline u32 softirq_dispatch_mask(void)
+{
+	return softirq_threaded_mask;
+}
+#else
+static inline u64 softirq_runtime_start(void)
+{
+	return 0;
+}
+
+static inline bool softirq_runtime_account(unsigned int nr, u64 start)
+{
+	return false;
+}
+
+static inline u32 softirq_dispatch_threads(u32 pending)
+{
+	return pending;
+}
+
+static inline u32 softirq_dispatch_mask(void)
+{
+	return 0;
+}
+#endif
+
 /*
  * we cannot loop indefinitely here to avoid userspace starvation,
  * but we also don't want to introduce a worst case 1/HZ latency
@@ -215,6 +317,8 @@ asmlinkage void __do_softirq(void)
 	int cpu;
 	unsigned long old_flags = current->flags;
 	int max_restart = MAX_SOFTIRQ_RESTART;
+	u64 balance_start = irq_balance_enabled() ? local_clock() : 0;
+	u32 overrun = 0;
 
 	/*
 	 * Mask out PF_MEMALLOC s current task context is borrowed for the
@@ -234,6 +338,8 @@ restart:
 	/* Reset the pending bitmask before enabling irqs */
 	set_softirq_pending(0);
 
+	pending = softirq_dispatch_threads(pending);
+
 	local_irq_enable();
 
 	h = softirq_vec;
@@ -242,11 +348,15 @@ restart:
 		if (pending & 1) {
 			unsigned int vec_nr = h - softirq_vec;
 			int prev_count = preempt_count();
+			u64 start;
 
 			kstat_incr_softirqs_this_cpu(vec_nr);
 
 			trace_softirq_entry(vec_nr);
+			start = softirq_runtime_start();
 			h->action(h);
+			if (softirq_runtime_account(vec_nr, start))
+				overrun |= 1U << vec_nr;
 			trace_softirq_exit(vec_nr);
 			if (unlikely(prev_count != preempt_count())) {
 				printk(KERN_ERR "huh, entered softirq %u %s %p"
@@ -267,13 +377,21 @@ restart:
 
 	pending = local_softirq_pending();
 	if (pending) {
-		if (time_before(jiffies, end) && !need_resched() &&
+		/*
+		 * A vector that overran its budget is not restarted inline,
+		 * unless it is going to be handed to its thread anyway.
+		 */
+		if (!(pending & overrun & ~softirq_dispatch_mask()) &&
+		    time_before(jiffies, end) && !need_resched() &&
 		    --max_restart)
 			goto restart;
 
 		wakeup_softirqd();
 	}
 
+	if (balance_start)
+		irq_balance_account_softirq(balance_start);
+
 	lockdep_softirq_exit();
 
 	account_irq_exit_time(current);
@@ -652,6 +770,132 @@ static void run_ksoftirqd(unsigned int cpu)
 	local_irq_enable();
 }
 
+#ifdef CONFIG_SOFTIRQ_THREADS
+static const char * const softirq_thread_comm[NR_SOFTIRQS] = {
+	"sirq-hi/%u", "sirq-timer/%u", "sirq-net-tx/%u", "sirq-net-rx/%u",
+	"sirq-block/%u", "sirq-iopoll/%u", "sirq-tasklet/%u", "sirq-sched/%u",
+	"sirq-hrtimer/%u", "sirq-rcu/%u"
+};
+
+static struct smp_hotplug_thread softirq_vec_threads[NR_SOFTIRQS];
+
+#define SOFTIRQ_THREAD_NONE	NR_SOFTIRQS
+
+/*
+ * The vector served by the calling softirq thread, or SOFTIRQ_THREAD_NONE
+ * if it is not known yet: smpboot stores the thread only after it has
+ * been created, and it may get to run before that.
+ */
+static unsigned int softirq_thread_vec(unsigned int cpu)
+{
+	unsigned int nr;
+
+	for (nr = 0; nr < NR_SOFTIRQS; nr++) {
+		if (per_cpu(softirq_thread[nr], cpu) == current)
+			return nr;
+	}
+	return SOFTIRQ_THREAD_NONE;
+}
+
+static int softirq_thread_should_run(unsigned int cpu)
+{
+	unsigned int nr = softirq_thread_vec(cpu);
+
+	if (nr == SOFTIRQ_THREAD_NONE)
+		return 0;
+	return __this_cpu_read(softirq_thread_pending) & (1U << nr);
+}
+
+static void run_softirq_thread(unsigned int cpu)
+{
+	unsigned int nr = softirq_thread_vec(cpu);
+	struct softirq_action *h;
+	u32 pending;
+	u64 start;
+
+	if (nr == SOFTIRQ_THREAD_NONE)
+		return;
+	h = softirq_vec + nr;
+
+	local_irq_disable();
+	if (!(__this_cpu_read(softirq_thread_pending) & (1U << nr))) {
+		local_irq_enable();
+		return;
+	}
+	__this_cpu_and(softirq_thread_pending, ~(1U << nr));
+
+	__local_bh_disable(_RET_IP_, SOFTIRQ_OFFSET);
+	lockdep_softirq_enter();
+	local_irq_enable();
+
+	kstat_incr_softirqs_this_cpu(nr);
+	trace_softirq_entry(nr);
+	start = softirq_runtime_start();
+	h->action(h);
+	softirq_runtime_account(nr, start);
+	trace_softirq_exit(nr);
+	rcu_bh_qs(cpu);
+
+	/*
+	 * Whatever the handler raised, its own vector included, goes to
+	 * the threads directly, the rest to ksoftirqd.
+	 */
+	local_irq_disable();
+	pending = softirq_dispatch_threads(local_softirq_pending());
+	set_softirq_pending(pending);
+	if (pending)
+		wakeup_softirqd();
+	lockdep_softirq_exit();
+	__local_bh_enable(SOFTIRQ_OFFSET);
+	local_irq_enable();
+
+	cond_resched();
+}
+
+#ifdef CONFIG_HOTPLUG_CPU
+static void takeover_softirq_threads(unsigned int cpu)
+{
+	u32 pending = per_cpu(softirq_thread_pending, cpu);
+	unsigned int nr;
+
+	per_cpu(softirq_thread_pending, cpu) = 0;
+
+	local_irq_disable();
+	for (nr = 0; pending; nr++, pending >>= 1) {
+		if (pending & 1)
+			raise_softirq_irqoff(nr);
+	}
+	local_irq_enable();
+}
+#endif
+
+static void __init spawn_softirq_threads(void)
+{
+	struct smp_hotplug_thread *t;
+	unsigned int nr;
+
+	for (nr = 0; nr < NR_SOFTIRQS; nr++) {
+		if (!(threaded & SOFTIRQ_THREADABLE_MASK & (1U << nr)))
+			continue;
+
+		t = &softirq_vec_threads[nr];
+		t->store = &softirq_thread[nr];
+		t->thread_should_run = softirq_thread_should_run;
+		t->thread_fn = run_softirq_thread;
+		t->thread_comm = softirq_thread_comm[nr];
+		if (smpboot_register_percpu_thread(t)) {
+			pr_err("softirq: no threads for %s, running it inline\n",
+			       softirq_to_name[nr]);
+			continue;
+		}
+		softirq_threaded_mask |= 1U << nr;
+	}
+}
+#else
+static inline void takeover_softirq_threads(unsigned int cpu) { }
+static inline void spawn_softirq_threads(void) { }
+#endif
+
 #ifdef CONFIG_HOTPLUG_CPU
 /*
  * tasklet_kill_immediate is called to remove a tasklet which can already be
@@ -720,6 +964,7 @@ static int __cpuinit cpu_callback(struct notifier_block *nfb,
 	case CPU_DEAD:
 	case CPU_DEAD_FROZEN:
 		takeover_tasklets((unsigned long)hcpu);
+		takeover_softirq_threads((unsigned long)hcpu);
 		break;
 #endif /* CONFIG_HOTPLUG_CPU */
 	}
@@ -742,6 +987,7 @@ static __init int spawn_ksoftirqd(void)
 	register_cpu_notifier(&cpu_nfb);
 
 	BUG_ON(smpboot_register_percpu_thread(&softirq_threads));
+	spawn_softirq_threads();
 
 	return 0;
 }
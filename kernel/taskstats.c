@@ -24,9 +24,11 @@
 #include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/cgroupstats.h>
+#include <linux/procstats.h>
 #include <linux/cgroup.h>
 #include <linux/fs.h>
 #include <linux/file.h>
+#include <linux/pid_namespace.h>
 #include <net/genetlink.h>
 #include <linux/atomic.h>
 
@@ -57,6 +59,12 @@ static const struct nla_policy cgroupstats_cmd_get_policy[CGROUPSTATS_CMD_ATTR_M
 	[CGROUPSTATS_CMD_ATTR_FD] = { .type = NLA_U32 },
 };
 
+static const struct nla_policy procstats_cmd_get_policy[PROCSTATS_CMD_ATTR_MAX+1] = {
+	[PROCSTATS_CMD_ATTR_MASK]   = { .type = NLA_U32 },
+	[PROCSTATS_CMD_ATTR_CURSOR] = { .type = NLA_U32 },
+	[PROCSTATS_CMD_ATTR_UID]    = { .type = NLA_U32 },
+};
+
 struct listener {
 	struct list_head list;
 	pid_t pid;
@@ -457,6 +465,169 @@ err:
 	return rc;
 }
 
+/*
+ * Bulk per-process statistics, to replace reading /proc/<pid>/stat,
+ * status and oom_score_adj of every process: only the fields asked for
+ * are collected, and nothing is formatted as text.
+ */
+static void fill_procstats(struct task_struct *tsk, struct pid_namespace *ns,
+			   u32 mask, struct procstats *ps)
+{
+	struct mm_struct *mm;
+	unsigned long flags;
+
+	memset(ps, 0, sizeof(*ps));
+	ps->version = PROCSTATS_VERSION;
+	ps->size = sizeof(*ps);
+	ps->pid = task_tgid_nr_ns(tsk, ns);
+
+	if (mask & PROCSTATS_F_IDS) {
+		rcu_read_lock();
+		if (pid_alive(tsk))
+			ps->ppid = task_tgid_nr_ns(
+				rcu_dereference(tsk->real_parent), ns);
+		ps->uid = __task_cred(tsk)->uid;
+		rcu_read_unlock();
+	}
+	if (mask & PROCSTATS_F_COMM)
+		get_task_comm(ps->comm, tsk);
+	if (mask & PROCSTATS_F_STATE)
+		ps->state = (tsk->state & TASK_REPORT) | tsk->exit_state;
+	if (mask & PROCSTATS_F_SCHED) {
+		ps->nice = task_nice(tsk);
+		ps->policy = tsk->policy;
+		ps->nr_threads = get_nr_threads(tsk);
+	}
+	if (mask & PROCSTATS_F_OOM)
+		ps->oom_score_adj = tsk->signal->oom_score_adj;
+
+	if ((mask & PROCSTATS_F_CPU) && lock_task_sighand(tsk, &flags)) {
+		struct task_struct *t = tsk;
+		cputime_t utime, stime;
+
+		do {
+			ps->min_flt += t->min_flt;
+			ps->maj_flt += t->maj_flt;
+			t = next_thread(t);
+		} while (t != tsk);
+		ps->min_flt += tsk->signal->min_flt;
+		ps->maj_flt += tsk->signal->maj_flt;
+		thread_group_cputime_adjusted(tsk, &utime, &stime);
+		unlock_task_sighand(tsk, &flags);
+
+		ps->utime = cputime_to_usecs(utime);
+		ps->stime = cputime_to_usecs(stime);
+		ps->start_time = timespec_to_ns(&tsk->real_start_time);
+	}
+
+	if (mask & PROCSTATS_F_MEM) {
+		mm = get_task_mm(tsk);
+		if (mm) {
+			ps->vsize = (u64)mm->total_vm << PAGE_SHIFT;
+			ps->rss = (u64)get_mm_rss(mm) << PAGE_SHIFT;
+			ps->swap = (u64)get_mm_counter(mm, MM_SWAPENTS)
+					<< PAGE_SHIFT;
+			mmput(mm);
+		}
+	}
+
+	ps->mask = mask;
+}
+
+/* The leader of the first thread group at or after pid @nr, referenced */
+static struct task_struct *next_procstats_task(struct pid_namespace *ns,
+					       pid_t *nr)
+{
+	struct task_struct *tsk = NULL;
+	struct pid *pid;
+
+	rcu_read_lock();
+	while ((pid = find_ge_pid(*nr, ns))) {
+		*nr = pid_nr_ns(pid, ns);
+		tsk = pid_task(pid, PIDTYPE_PID);
+		if (tsk && has_group_leader_pid(tsk)) {
+			get_task_struct(tsk);
+			break;
+		}
+		tsk = NULL;
+		(*nr)++;
+	}
+	rcu_read_unlock();
+	return tsk;
+}
+
+/*
+ * Dumps fill as many processes as fit in each message. cb->args[0] is
+ * the cursor, the next pid to report; the request is parsed on the first
+ * call into args[1] (mask) and args[2] (uid + 1, or 0 for all uids).
+ */
+static int procstats_user_dump(struct sk_buff *skb,
+			       struct netlink_callback *cb)
+{
+	struct pid_namespace *ns = task_active_pid_ns(current);
+	struct nlattr *attrs[PROCSTATS_CMD_ATTR_MAX + 1];
+	struct task_struct *tsk;
+	struct nlattr *na;
+	void *reply;
+	pid_t nr;
+	u32 mask;
+	int rc, n = 0;
+
+	if (!cb->args[3]) {
+		rc = nlmsg_parse(cb->nlh, GENL_HDRLEN + family.hdrsize, attrs,
+				 PROCSTATS_CMD_ATTR_MAX,
+				 procstats_cmd_get_policy);
+		if (rc < 0)
+			return rc;
+
+		cb->args[0] = 1;
+		cb->args[1] = PROCSTATS_F_ALL;
+		if (attrs[PROCSTATS_CMD_ATTR_CURSOR])
+			cb->args[0] = max_t(u32, 1,
+				nla_get_u32(attrs[PROCSTATS_CMD_ATTR_CURSOR]));
+		if (attrs[PROCSTATS_CMD_ATTR_MASK])
+			cb->args[1] = nla_get_u32(attrs[PROCSTATS_CMD_ATTR_MASK])
+					& PROCSTATS_F_ALL;
+		if (attrs[PROCSTATS_CMD_ATTR_UID])
+			cb->args[2] =
+				nla_get_u32(attrs[PROCSTATS_CMD_ATTR_UID]) + 1;
+		cb->args[3] = 1;
+	}
+	nr = cb->args[0];
+	mask = cb->args[1];
+
+	reply = genlmsg_put(skb, NETLINK_CB(cb->skb).pid, cb->nlh->nlmsg_seq,
+			    &family, NLM_F_MULTI, PROCSTATS_CMD_NEW);
+	if (!reply)
+		return -EMSGSIZE;
+
+	for (; (tsk = next_procstats_task(ns, &nr)); nr++) {
+		if (cb->args[2] &&
+		    task_uid(tsk) != (uid_t)(cb->args[2] - 1)) {
+			put_task_struct(tsk);
+			continue;
+		}
+		na = nla_reserve(skb, PROCSTATS_TYPE_STATS,
+				 sizeof(struct procstats));
+		if (!na) {
+			put_task_struct(tsk);
+			break;
+		}
+		fill_procstats(tsk, ns, mask, nla_data(na));
+		put_task_struct(tsk);
+		n++;
+	}
+	cb->args[0] = nr;
+
+	/* the dump ends with the first message holding no process */
+	if (!tsk && !n) {
+		genlmsg_cancel(skb, reply);
+		return 0;
+	}
+	genlmsg_end(skb, reply);
+	return skb->len;
+}
+
 static int cmd_attr_register_cpumask(struct genl_info *info)
 {
 	cpumask_var_t mask;
@@ -669,6 +840,13 @@ static struct genl_ops cgroupstats_ops = {
 	.policy		= cgroupstats_cmd_get_policy,
 };
 
+static struct genl_ops procstats_ops = {
+	.cmd		= PROCSTATS_CMD_GET,
+	.dumpit		= procstats_user_dump,
+	.policy		= procstats_cmd_get_policy,
+	.flags		= GENL_ADMIN_PERM,
+};
+
 /* Needed early in initialization */
 void __init taskstats_init_early(void)
 {
@@ -697,9 +875,15 @@ static int __init taskstats_init(void)
 	if (rc < 0)
 		goto err_cgroup_ops;
 
+	rc = genl_register_ops(&family, &procstats_ops);
+	if (rc < 0)
+		goto err_procstats_ops;
+
 	family_registered = 1;
 	pr_info("registered taskstats version %d\n", TASKSTATS_GENL_VERSION);
 	return 0;
+err_procstats_ops:
+	genl_unregister_ops(&family, &cgroupstats_ops);
 err_cgroup_ops:
 	genl_unregister_ops(&family, &taskstats_ops);
 err:
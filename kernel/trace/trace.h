@@ -422,6 +422,54 @@ void update_max_tr_single(struct trace_array *tr,
 			  struct task_struct *tsk, int cpu);
 #endif /* CONFIG_TRACER_MAX_TRACE */
 
+enum latency_hist_type {
+	LATENCY_HIST_WAKEUP_CFS,
+	LATENCY_HIST_WAKEUP_RT,
+	LATENCY_HIST_WAKEUP_DL,
+	LATENCY_HIST_IRQSOFF,
+	LATENCY_HIST_PREEMPTOFF,
+	LATENCY_HIST_IRQ_HANDLER,
+	LATENCY_HIST_CPUFREQ,
+	LATENCY_HIST_NR,
+};
+
+#ifdef CONFIG_LATENCY_HIST
+extern struct static_key latency_hist_irqsoff_key;
+extern struct static_key latency_hist_preemptoff_key;
+
+extern void latency_hist_start(int type);
+extern void latency_hist_stop(int type);
+
+static inline void latency_hist_irqsoff_start(void)
+{
+	if (static_key_false(&latency_hist_irqsoff_key))
+		latency_hist_start(LATENCY_HIST_IRQSOFF);
+}
+
+static inline void latency_hist_irqsoff_stop(void)
+{
+	if (static_key_false(&latency_hist_irqsoff_key))
+		latency_hist_stop(LATENCY_HIST_IRQSOFF);
+}
+
+static inline void latency_hist_preemptoff_start(void)
+{
+	if (static_key_false(&latency_hist_preemptoff_key))
+		latency_hist_start(LATENCY_HIST_PREEMPTOFF);
+}
+
+static inline void latency_hist_preemptoff_stop(void)
+{
+	if (static_key_false(&latency_hist_preemptoff_key))
+		latency_hist_stop(LATENCY_HIST_PREEMPTOFF);
+}
+#else
+static inline void latency_hist_irqsoff_start(void) { }
+static inline void latency_hist_irqsoff_stop(void) { }
+static inline void latency_hist_preemptoff_start(void) { }
+static inline void latency_hist_preemptoff_stop(void) { }
+#endif /* CONFIG_LATENCY_HIST */
+
 #ifdef CONFIG_STACKTRACE
 void ftrace_trace_stack(struct ring_buffer *buffer, unsigned long flags,
 			int skip, int pc);
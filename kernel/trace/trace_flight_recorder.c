@@ -0,0 +1,329 @@
+/*
+ * Always-on scheduler/power flight recorder
+ *
+ * Scheduler, power, irq, binder and lowmemorykiller events are logged as
+ * 16 byte binary records into an overwriting per-cpu ring buffer of fixed
+ * size, so that the history that led to a dropped frame can be exported
+ * without having had ftrace enabled beforehand.
+ *
+ * A snapshot swaps the live per-cpu buffers with spare ones of the same
+ * size: recording goes on in the emptied buffers while the frozen history
+ * is read from /dev/flight_recorder, merged across cpus by timestamp.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/ring_buffer.h>
+#include <linux/uaccess.h>
+#include <linux/sched.h>
+#include <linux/flight_recorder.h>
+#include <trace/events/sched.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+
+#undef MODULE_PARAM_PREFIX
+#define MODULE_PARAM_PREFIX "flight_recorder."
+
+static bool enable = true;
+module_param(enable, bool, 0444);
+
+static unsigned long buf_kb = CONFIG_FLIGHT_RECORDER_BUF_KB;
+module_param(buf_kb, ulong, 0444);
+
+/* record as stored in the ring buffer, which provides time and cpu */
+struct flight_rec {
+	u8 type;
+	u8 pad[3];
+	u32 pid;
+	u32 arg0;
+	u32 arg1;
+};
+
+static struct ring_buffer *flight_rec_live;
+static struct ring_buffer *flight_rec_snap;
+static DEFINE_MUTEX(flight_rec_mutex);
+/* records of the snapshot older than this are not returned */
+static u64 flight_rec_cutoff;
+
+struct static_key flight_rec_key = STATIC_KEY_INIT_FALSE;
+EXPORT_SYMBOL_GPL(flight_rec_key);
+
+void __flight_rec_log(u8 type, u32 pid, u32 arg0, u32 arg1)
+{
+	struct ring_buffer_event *event;
+	struct flight_rec *rec;
+
+	event = ring_buffer_lock_reserve(flight_rec_live, sizeof(*rec));
+	if (!event)
+		return;
+
+	rec = ring_buffer_event_data(event);
+	rec->type = type;
+	rec->pid = pid;
+	rec->arg0 = arg0;
+	rec->arg1 = arg1;
+	ring_buffer_unlock_commit(flight_rec_live, event);
+}
+EXPORT_SYMBOL_GPL(__flight_rec_log);
+
+static void probe_switch(void *ignore, struct task_struct *prev,
+			 struct task_struct *next)
+{
+	__flight_rec_log(FLIGHT_REC_SCHED_SWITCH, next->pid, prev->pid,
+			 prev->state);
+}
+
+static void probe_wakeup(void *ignore, struct task_struct *p, int success)
+{
+	if (success)
+		__flight_rec_log(FLIGHT_REC_SCHED_WAKEUP, p->pid,
+				 task_cpu(p), 0);
+}
+
+static void probe_cpu_frequency(void *ignore, unsigned int frequency,
+				unsigned int cpu_id)
+{
+	__flight_rec_log(FLIGHT_REC_CPU_FREQ, 0, frequency, cpu_id);
+}
+
+static void probe_cpu_idle(void *ignore, unsigned int state,
+			   unsigned int cpu_id)
+{
+	if (state == (unsigned int)PWR_EVENT_EXIT)
+		__flight_rec_log(FLIGHT_REC_IDLE_EXIT, 0, 0, cpu_id);
+	else
+		__flight_rec_log(FLIGHT_REC_IDLE_ENTER, 0, state, cpu_id);
+}
+
+static void probe_irq_entry(void *ignore, int irq, struct irqaction *action)
+{
+	__flight_rec_log(FLIGHT_REC_IRQ_ENTER, 0, irq, 0);
+}
+
+static void probe_irq_exit(void *ignore, int irq, struct irqaction *action,
+			   int ret)
+{
+	__flight_rec_log(FLIGHT_REC_IRQ_EXIT, 0, irq, ret);
+}
+
+static int flight_rec_register(void)
+{
+	int ret;
+
+	ret = register_trace_sched_switch(probe_switch, NULL);
+	if (ret)
+		return ret;
+	ret = register_trace_sched_wakeup(probe_wakeup, NULL);
+	if (ret)
+		goto err_wakeup;
+	ret = register_trace_sched_wakeup_new(probe_wakeup, NULL);
+	if (ret)
+		goto err_wakeup_new;
+	ret = register_trace_cpu_frequency(probe_cpu_frequency, NULL);
+	if (ret)
+		goto err_frequency;
+	ret = register_trace_cpu_idle(probe_cpu_idle, NULL);
+	if (ret)
+		goto err_idle;
+	ret = register_trace_irq_handler_entry(probe_irq_entry, NULL);
+	if (ret)
+		goto err_irq_entry;
+	ret = register_trace_irq_handler_exit(probe_irq_exit, NULL);
+	if (ret)
+		goto err_irq_exit;
+
+	return 0;
+
+err_irq_exit:
+	unregister_trace_irq_handler_entry(probe_irq_entry, NULL);
+err_irq_entry:
+	unregister_trace_cpu_idle(probe_cpu_idle, NULL);
+err_idle:
+	unregister_trace_cpu_frequency(probe_cpu_frequency, NULL);
+err_frequency:
+	unregister_trace_sched_wakeup_new(probe_wakeup, NULL);
+err_wakeup_new:
+	unregister_trace_sched_wakeup(probe_wakeup, NULL);
+err_wakeup:
+	unregister_trace_sched_switch(probe_switch, NULL);
+	return ret;
+}
+
+/*
+ * Runs on each cpu with irqs disabled, so that no writer of that cpu is
+ * in the middle of a commit while its buffer is swapped. Should the swap
+ * still fail, that cpu is simply missing from the snapshot.
+ */
+static void flight_rec_swap(void *info)
+{
+	ring_buffer_swap_cpu(flight_rec_snap, flight_rec_live,
+			     smp_processor_id());
+}
+
+static void flight_rec_snapshot(u32 seconds)
+{
+	u64 now;
+	int cpu;
+
+	mutex_lock(&flight_rec_mutex);
+	ring_buffer_reset(flight_rec_snap);
+
+	cpu = get_cpu();
+	now = ring_buffer_time_stamp(flight_rec_live, cpu);
+	ring_buffer_normalize_time_stamp(flight_rec_live, cpu, &now);
+	put_cpu();
+
+	on_each_cpu(flight_rec_swap, NULL, 1);
+
+	flight_rec_cutoff = 0;
+	if (seconds && now > (u64)seconds * NSEC_PER_SEC)
+		flight_rec_cutoff = now - (u64)seconds * NSEC_PER_SEC;
+	mutex_unlock(&flight_rec_mutex);
+}
+
+/* Oldest record of the snapshot across all cpus, or -1 if none is left */
+static int flight_rec_next_cpu(u64 *ts)
+{
+	int cpu, next_cpu = -1;
+	u64 next_ts = 0, cpu_ts;
+
+	for_each_possible_cpu(cpu) {
+		if (!ring_buffer_peek(flight_rec_snap, cpu, &cpu_ts, NULL))
+			continue;
+		if (next_cpu < 0 || cpu_ts < next_ts) {
+			next_cpu = cpu;
+			next_ts = cpu_ts;
+		}
+	}
+
+	*ts = next_ts;
+	return next_cpu;
+}
+
+static ssize_t flight_rec_read(struct file *file, char __user *ubuf,
+			       size_t cnt, loff_t *ppos)
+{
+	struct flight_rec_entry entry;
+	struct ring_buffer_event *event;
+	struct flight_rec *rec;
+	ssize_t ret = 0;
+	u64 ts;
+	int cpu;
+
+	if (cnt < sizeof(entry))
+		return -EINVAL;
+
+	mutex_lock(&flight_rec_mutex);
+	while (cnt - ret >= sizeof(entry)) {
+		cpu = flight_rec_next_cpu(&ts);
+		if (cpu < 0)
+			break;
+
+		event = ring_buffer_consume(flight_rec_snap, cpu, &ts, NULL);
+		if (!event || ts < flight_rec_cutoff)
+			continue;
+
+		rec = ring_buffer_event_data(event);
+		memset(&entry, 0, sizeof(entry));
+		entry.ts = ts;
+		entry.cpu = cpu;
+		entry.type = rec->type;
+		entry.pid = rec->pid;
+		entry.arg0 = rec->arg0;
+		entry.arg1 = rec->arg1;
+
+		if (copy_to_user(ubuf + ret, &entry, sizeof(entry))) {
+			if (!ret)
+				ret = -EFAULT;
+			break;
+		}
+		ret += sizeof(entry);
+
+		if (fatal_signal_pending(current))
+			break;
+	}
+	mutex_unlock(&flight_rec_mutex);
+
+	return ret;
+}
+
+static long flight_rec_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	u32 seconds;
+
+	switch (cmd) {
+	case FLIGHT_REC_IOC_SNAPSHOT:
+		if (get_user(seconds, (u32 __user *)arg))
+			return -EFAULT;
+		flight_rec_snapshot(seconds);
+		return 0;
+	default:
+		return -ENOTTY;
+	}
+}
+
+static const struct file_operations flight_rec_fops = {
+	.owner		= THIS_MODULE,
+	.read		= flight_rec_read,
+	.unlocked_ioctl	= flight_rec_ioctl,
+	.compat_ioctl	= flight_rec_ioctl,
+	.llseek		= noop_llseek,
+};
+
+static struct miscdevice flight_rec_misc = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "flight_recorder",
+	.fops	= &flight_rec_fops,
+};
+
+static int __init flight_rec_init(void)
+{
+	unsigned long size = buf_kb << 10;
+	int ret;
+
+	if (!enable)
+		return 0;
+
+	flight_rec_live = ring_buffer_alloc(size, RB_FL_OVERWRITE);
+	if (!flight_rec_live)
+		return -ENOMEM;
+	flight_rec_snap = ring_buffer_alloc(size, RB_FL_OVERWRITE);
+	if (!flight_rec_snap) {
+		ret = -ENOMEM;
+		goto err_snap;
+	}
+
+	ret = misc_register(&flight_rec_misc);
+	if (ret)
+		goto err_misc;
+
+	ret = flight_rec_register();
+	if (ret)
+		goto err_register;
+
+	static_key_slow_inc(&flight_rec_key);
+	pr_info("flight recorder: %lu kB per cpu\n", buf_kb);
+
+	return 0;
+
+err_register:
+	misc_deregister(&flight_rec_misc);
+err_misc:
+	ring_buffer_free(flight_rec_snap);
+err_snap:
+	ring_buffer_free(flight_rec_live);
+	return ret;
+}
+late_initcall(flight_rec_init);
@@ -0,0 +1,399 @@
+/*
+ * Latency histograms
+ *
+ * Per-cpu log2 histograms, in microseconds, of the wakeup to run latency
+ * of each scheduling class, of irqs-off and preemption-off sections, of
+ * hard irq handlers and of cpu frequency transitions. They are fed by
+ * tracepoint probes, registered only while a histogram is enabled, and by
+ * the irqs-off/preempt-off hooks behind jump labels.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 and
+ * only version 2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
+#include <linux/jump_label.h>
+#include <linux/sched.h>
+#include <linux/sched/deadline.h>
+#include <trace/events/sched.h>
+#include <trace/events/irq.h>
+#include <trace/events/power.h>
+#include "trace.h"
+
+/* bucket i counts latencies in [2^(i-1), 2^i) us, bucket 0 those < 1us */
+#define LATENCY_HIST_BUCKETS	32
+
+struct latency_hist {
+	unsigned long count[LATENCY_HIST_BUCKETS];
+	unsigned long samples;
+	u64 total_us;
+	u64 max_us;
+};
+
+static DEFINE_PER_CPU(struct latency_hist [LATENCY_HIST_NR], latency_hists);
+/* start of the section being measured, 0 when none */
+static DEFINE_PER_CPU(u64 [LATENCY_HIST_NR], latency_hist_ts);
+
+static const char * const latency_hist_names[LATENCY_HIST_NR] = {
+	[LATENCY_HIST_WAKEUP_CFS]	= "wakeup_cfs",
+	[LATENCY_HIST_WAKEUP_RT]	= "wakeup_rt",
+	[LATENCY_HIST_WAKEUP_DL]	= "wakeup_dl",
+	[LATENCY_HIST_IRQSOFF]		= "irqsoff",
+	[LATENCY_HIST_PREEMPTOFF]	= "preemptoff",
+	[LATENCY_HIST_IRQ_HANDLER]	= "irq_handler",
+	[LATENCY_HIST_CPUFREQ]		= "cpufreq_switch",
+};
+
+#define LATENCY_HIST_WAKEUP_MASK	((1UL << LATENCY_HIST_WAKEUP_CFS) | \
+					 (1UL << LATENCY_HIST_WAKEUP_RT) | \
+					 (1UL << LATENCY_HIST_WAKEUP_DL))
+
+static DEFINE_MUTEX(latency_hist_mutex);
+static unsigned long latency_hist_enabled;
+/* wakeups stamped before the wakeup probes were registered are stale */
+static u64 wakeup_enable_ts;
+
+struct static_key latency_hist_irqsoff_key = STATIC_KEY_INIT_FALSE;
+struct static_key latency_hist_preemptoff_key = STATIC_KEY_INIT_FALSE;
+
+static void latency_hist_add(int type, int cpu, u64 delta_ns)
+{
+	struct latency_hist *hist = &per_cpu(latency_hists, cpu)[type];
+	u64 us = div_u64(delta_ns, NSEC_PER_USEC);
+	int bucket = min_t(int, fls64(us), LATENCY_HIST_BUCKETS - 1);
+
+	hist->count[bucket]++;
+	hist->samples++;
+	hist->total_us += us;
+	if (us > hist->max_us)
+		hist->max_us = us;
+}
+
+/* Called with irqs or preemption disabled, see trace_irqsoff.c */
+void latency_hist_start(int type)
+{
+	u64 *ts = &per_cpu(latency_hist_ts, raw_smp_processor_id())[type];
+
+	if (!*ts)
+		*ts = trace_clock_local();
+}
+
+void latency_hist_stop(int type)
+{
+	int cpu = raw_smp_processor_id();
+	u64 *ts = &per_cpu(latency_hist_ts, cpu)[type];
+	u64 start = *ts;
+
+	if (!start)
+		return;
+
+	*ts = 0;
+	latency_hist_add(type, cpu, trace_clock_local() - start);
+}
+
+static void latency_hist_clear_ts(int type)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		per_cpu(latency_hist_ts, cpu)[type] = 0;
+}
+
+static void probe_wakeup(void *ignore, struct task_struct *p, int success)
+{
+	if (success)
+		p->hist_wakeup_ts = local_clock();
+}
+
+static void probe_switch(void *ignore, struct task_struct *prev,
+			 struct task_struct *next)
+{
+	u64 ts = next->hist_wakeup_ts;
+	int type;
+
+	/* a wakeup of a task that was still running is not a latency */
+	prev->hist_wakeup_ts = 0;
+
+	if (!ts)
+		return;
+	next->hist_wakeup_ts = 0;
+	if (ts < wakeup_enable_ts)
+		return;
+
+	if (dl_task(next))
+		type = LATENCY_HIST_WAKEUP_DL;
+	else if (rt_task(next))
+		type = LATENCY_HIST_WAKEUP_RT;
+	else
+		type = LATENCY_HIST_WAKEUP_CFS;
+
+	if (test_bit(type, &latency_hist_enabled))
+		latency_hist_add(type, smp_processor_id(), local_clock() - ts);
+}
+
+static void probe_irq_entry(void *ignore, int irq, struct irqaction *action)
+{
+	latency_hist_start(LATENCY_HIST_IRQ_HANDLER);
+}
+
+static void probe_irq_exit(void *ignore, int irq, struct irqaction *action,
+			   int ret)
+{
+	latency_hist_stop(LATENCY_HIST_IRQ_HANDLER);
+}
+
+static void probe_freq_start(void *ignore, unsigned int start_freq,
+			     unsigned int end_freq, unsigned int cpu)
+{
+	per_cpu(latency_hist_ts, cpu)[LATENCY_HIST_CPUFREQ] = local_clock();
+}
+
+static void probe_freq_end(void *ignore, unsigned int cpu)
+{
+	u64 *ts = &per_cpu(latency_hist_ts, cpu)[LATENCY_HIST_CPUFREQ];
+	u64 start = *ts;
+
+	if (!start)
+		return;
+
+	*ts = 0;
+	latency_hist_add(LATENCY_HIST_CPUFREQ, cpu, local_clock() - start);
+}
+
+static int latency_hist_register(int type)
+{
+	int ret = 0;
+
+	switch (type) {
+	case LATENCY_HIST_WAKEUP_CFS:
+	case LATENCY_HIST_WAKEUP_RT:
+	case LATENCY_HIST_WAKEUP_DL:
+		if (latency_hist_enabled & LATENCY_HIST_WAKEUP_MASK)
+			break;
+		wakeup_enable_ts = local_clock();
+		ret = register_trace_sched_wakeup(probe_wakeup, NULL);
+		if (ret)
+			break;
+		ret = register_trace_sched_wakeup_new(probe_wakeup, NULL);
+		if (ret)
+			goto err_wakeup_new;
+		ret = register_trace_sched_switch(probe_switch, NULL);
+		if (ret)
+			goto err_switch;
+		break;
+	case LATENCY_HIST_IRQSOFF:
+		latency_hist_clear_ts(type);
+		static_key_slow_inc(&latency_hist_irqsoff_key);
+		break;
+	case LATENCY_HIST_PREEMPTOFF:
+		latency_hist_clear_ts(type);
+		static_key_slow_inc(&latency_hist_preemptoff_key);
+		break;
+	case LATENCY_HIST_IRQ_HANDLER:
+		latency_hist_clear_ts(type);
+		ret = register_trace_irq_handler_entry(probe_irq_entry, NULL);
+		if (ret)
+			break;
+		ret = register_trace_irq_handler_exit(probe_irq_exit, NULL);
+		if (ret)
+			unregister_trace_irq_handler_entry(probe_irq_entry,
+							   NULL);
+		break;
+	case LATENCY_HIST_CPUFREQ:
+		latency_hist_clear_ts(type);
+		ret = register_trace_cpu_frequency_switch_start(
+						probe_freq_start, NULL);
+		if (ret)
+			break;
+		ret = register_trace_cpu_frequency_switch_end(probe_freq_end,
+							      NULL);
+		if (ret)
+			unregister_trace_cpu_frequency_switch_start(
+						probe_freq_start, NULL);
+		break;
+	}
+
+	return ret;
+
+err_switch:
+	unregister_trace_sched_wakeup_new(probe_wakeup, NULL);
+err_wakeup_new:
+	unregister_trace_sched_wakeup(probe_wakeup, NULL);
+	return ret;
+}
+
+static void latency_hist_unregister(int type)
+{
+	switch (type) {
+	case LATENCY_HIST_WAKEUP_CFS:
+	case LATENCY_HIST_WAKEUP_RT:
+	case LATENCY_HIST_WAKEUP_DL:
+		if ((latency_hist_enabled & LATENCY_HIST_WAKEUP_MASK) !=
+		    (1UL << type))
+			break;
+		unregister_trace_sched_switch(probe_switch, NULL);
+		unregister_trace_sched_wakeup_new(probe_wakeup, NULL);
+		unregister_trace_sched_wakeup(probe_wakeup, NULL);
+		break;
+	case LATENCY_HIST_IRQSOFF:
+		static_key_slow_dec(&latency_hist_irqsoff_key);
+		break;
+	case LATENCY_HIST_PREEMPTOFF:
+		static_key_slow_dec(&latency_hist_preemptoff_key);
+		break;
+	case LATENCY_HIST_IRQ_HANDLER:
+		unregister_trace_irq_handler_exit(probe_irq_exit, NULL);
+		unregister_trace_irq_handler_entry(probe_irq_entry, NULL);
+		break;
+	case LATENCY_HIST_CPUFREQ:
+		unregister_trace_cpu_frequency_switch_end(probe_freq_end,
+							  NULL);
+		unregister_trace_cpu_frequency_switch_start(probe_freq_start,
+							    NULL);
+		break;
+	}
+}
+
+static int latency_hist_enable_set(void *data, u64 val)
+{
+	int type = (long)data;
+	int ret = 0;
+
+	if (val > 1)
+		return -EINVAL;
+
+	mutex_lock(&latency_hist_mutex);
+	if (val == test_bit(type, &latency_hist_enabled))
+		goto out;
+
+	if (val) {
+		ret = latency_hist_register(type);
+		if (!ret)
+			set_bit(type, &latency_hist_enabled);
+	} else {
+		latency_hist_unregister(type);
+		clear_bit(type, &latency_hist_enabled);
+	}
+out:
+	mutex_unlock(&latency_hist_mutex);
+
+	return ret;
+}
+
+static int latency_hist_enable_get(void *data, u64 *val)
+{
+	*val = test_bit((long)data, &latency_hist_enabled);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(latency_hist_enable_fops, latency_hist_enable_get,
+			latency_hist_enable_set, "%llu\n");
+
+static ssize_t latency_hist_reset_write(struct file *file,
+					const char __user *ubuf,
+					size_t cnt, loff_t *ppos)
+{
+	int type = (long)file->private_data;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(latency_hists, cpu)[type], 0,
+		       sizeof(struct latency_hist));
+
+	return cnt;
+}
+
+static const struct file_operations latency_hist_reset_fops = {
+	.open		= simple_open,
+	.write		= latency_hist_reset_write,
+	.llseek		= noop_llseek,
+};
+
+static int latency_hist_show(struct seq_file *m, void *v)
+{
+	long id = (long)m->private;
+	int type = id % LATENCY_HIST_NR;
+	int cpu = id / LATENCY_HIST_NR;
+	struct latency_hist *hist = &per_cpu(latency_hists, cpu)[type];
+	unsigned long samples = hist->samples;
+	u64 avg = samples ? div_u64(hist->total_us, samples) : 0;
+	int i;
+
+	seq_printf(m, "#Samples: %lu\n", samples);
+	seq_printf(m, "#Avg latency: %llu us\n", (unsigned long long)avg);
+	seq_printf(m, "#Max latency: %llu us\n",
+		   (unsigned long long)hist->max_us);
+	seq_printf(m, "#usecs<\tsamples\n");
+
+	for (i = 0; i < LATENCY_HIST_BUCKETS - 1; i++)
+		seq_printf(m, "%llu\t%lu\n", 1ULL << i, hist->count[i]);
+	seq_printf(m, "inf\t%lu\n", hist->count[i]);
+
+	return 0;
+}
+
+static int latency_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, latency_hist_show, inode->i_private);
+}
+
+static const struct file_operations latency_hist_fops = {
+	.open		= latency_hist_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init latency_hist_init(void)
+{
+	struct dentry *d_tracer = tracing_init_dentry();
+	struct dentry *d_hist, *d;
+	char name[16];
+	long type;
+	int cpu;
+
+	if (!d_tracer)
+		return 0;
+
+	d_hist = debugfs_create_dir("latency_hist", d_tracer);
+	if (!d_hist)
+		return 0;
+
+	for (type = 0; type < LATENCY_HIST_NR; type++) {
+		if (type == LATENCY_HIST_IRQSOFF &&
+		    !IS_ENABLED(CONFIG_IRQSOFF_TRACER))
+			continue;
+		if (type == LATENCY_HIST_PREEMPTOFF &&
+		    !IS_ENABLED(CONFIG_PREEMPT_TRACER))
+			continue;
+
+		d = debugfs_create_dir(latency_hist_names[type], d_hist);
+		if (!d)
+			continue;
+
+		debugfs_create_file("enable", S_IRUGO | S_IWUSR, d,
+				    (void *)type, &latency_hist_enable_fops);
+		debugfs_create_file("reset", S_IWUSR, d, (void *)type,
+				    &latency_hist_reset_fops);
+		for_each_possible_cpu(cpu) {
+			snprintf(name, sizeof(name), "CPU%d", cpu);
+			debugfs_create_file(name, S_IRUGO, d,
+				(void *)(cpu * LATENCY_HIST_NR + type),
+				&latency_hist_fops);
+		}
+	}
+
+	return 0;
+}
+late_initcall(latency_hist_init);
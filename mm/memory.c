@@ -61,6 +61,7 @@
 #include <linux/migrate.h>
 #include <linux/string.h>
 #include <linux/bug.h>
+#include <linux/vmacache.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -876,6 +877,8 @@ copy_one_pte(struct mm_struct *dst_mm, struct mm_struct *src_mm,
 					spin_unlock(&mmlist_lock);
 				}
 				rss[MM_SWAPENTS]++;
+				if (is_compressed_swap_entry(entry))
+					rss[MM_SWAPENTS_COMPR]++;
 			} else if (is_migration_entry(entry)) {
 				page = migration_entry_to_page(entry);
 
@@ -1212,9 +1215,11 @@ again:
 		} else {
 			swp_entry_t entry = pte_to_swp_entry(ptent);
 
-			if (!non_swap_entry(entry))
+			if (!non_swap_entry(entry)) {
 				rss[MM_SWAPENTS]--;
-			else if (is_migration_entry(entry)) {
+				if (is_compressed_swap_entry(entry))
+					rss[MM_SWAPENTS_COMPR]--;
+			} else if (is_migration_entry(entry)) {
 				struct page *page;
 
 				page = migration_entry_to_page(entry);
@@ -3200,6 +3205,8 @@ static int do_swap_page(struct mm_struct *mm, struct vm_area_struct *vma,
 
 	inc_mm_counter_fast(mm, MM_ANONPAGES);
 	dec_mm_counter_fast(mm, MM_SWAPENTS);
+	if (is_compressed_swap_entry(entry))
+		dec_mm_counter_fast(mm, MM_SWAPENTS_COMPR);
 	pte = mk_pte(page, vma->vm_page_prot);
 	if ((flags & FAULT_FLAG_WRITE) && reuse_swap_page(page)) {
 		pte = maybe_mkwrite(pte_mkdirty(pte), vma);
@@ -3969,6 +3976,279 @@ int handle_mm_fault(struct mm_struct *mm, struct vm_area_struct *vma,
 	return ret;
 }
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+/*
+ * Speculative page faults: faults on a not yet populated pte of private
+ * anonymous memory, and read faults on page cache files whose page is
+ * cached, are handled without mmap_sem.  The VMA is found in the
+ * per-thread vmacache, validated with vma->vm_sequence and revalidated
+ * under the pte lock before the new pte is installed.  Anything unusual
+ * falls back to the regular path by returning VM_FAULT_RETRY.
+ *
+ * mm->mm_spf_inflight keeps page tables and VMAs alive for the short,
+ * non-sleeping window in which they are dereferenced: writers call
+ * spf_sync_mm() after invalidating the vmacache and bumping the VMA
+ * sequence, and before freeing either.  A waiting writer adds
+ * SPF_SYNC_BIAS to the count, which makes new speculative faults fall
+ * back, so that a stream of them cannot keep it spinning.
+ */
+#define SPF_SYNC_BIAS	(1 << 24)
+
+static inline bool spf_enter(struct mm_struct *mm)
+{
+	preempt_disable();
+	/* fully ordered, against the bias of a writer as well */
+	if (likely(atomic_inc_return(&mm->mm_spf_inflight) < SPF_SYNC_BIAS))
+		return true;
+	atomic_dec(&mm->mm_spf_inflight);
+	preempt_enable();
+	return false;
+}
+
+static inline void spf_exit(struct mm_struct *mm)
+{
+	smp_mb__before_atomic_dec();
+	atomic_dec(&mm->mm_spf_inflight);
+	preempt_enable();
+}
+
+/* Called with mmap_sem held for write, so writers do not nest */
+void spf_sync_mm(struct mm_struct *mm)
+{
+	atomic_add_return(SPF_SYNC_BIAS, &mm->mm_spf_inflight);
+	while (atomic_read(&mm->mm_spf_inflight) != SPF_SYNC_BIAS)
+		cpu_relax();
+	smp_mb();
+	atomic_sub(SPF_SYNC_BIAS, &mm->mm_spf_inflight);
+}
+
+static struct vm_area_struct *spf_find_vma(struct mm_struct *mm,
+		unsigned long address, unsigned int flags, unsigned int *seq)
+{
+	struct vm_area_struct *vma;
+	unsigned long mask;
+
+	vma = vmacache_find_speculative(mm, address);
+	if (!vma)
+		return NULL;
+
+	/* Do not wait for a writer to finish: just fall back */
+	*seq = ACCESS_ONCE(vma->vm_sequence.sequence);
+	smp_rmb();
+	if (*seq & 1)
+		return NULL;
+
+	if (address < vma->vm_start || address >= vma->vm_end)
+		return NULL;
+	/* No stack guard games, and nothing that needs mlocking */
+	if (vma->vm_flags & (VM_HUGETLB | VM_PFNMAP | VM_MIXEDMAP |
+			     VM_GROWSDOWN | VM_GROWSUP | VM_LOCKED))
+		return NULL;
+	if (!vma->vm_ops) {
+		/* Private anonymous memory */
+		if (!vma->anon_vma || (vma->vm_flags & VM_SHARED))
+			return NULL;
+	} else {
+		/*
+		 * Page cache files, for read faults only: write faults need
+		 * ->page_mkwrite or a COW, and misses need ->fault to sleep.
+		 */
+		if (vma->vm_ops->fault != filemap_fault || !vma->vm_file ||
+		    (vma->vm_flags & VM_NONLINEAR) ||
+		    (flags & FAULT_FLAG_WRITE))
+			return NULL;
+	}
+
+	mask = (flags & FAULT_FLAG_WRITE) ? VM_WRITE :
+					    VM_READ | VM_WRITE | VM_EXEC;
+	if (!(vma->vm_flags & mask))
+		return NULL;
+
+	return vma;
+}
+
+static pmd_t *spf_find_pmd(struct mm_struct *mm, unsigned long address)
+{
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd, pmdval;
+
+	pgd = pgd_offset(mm, address);
+	if (pgd_none_or_clear_bad(pgd))
+		return NULL;
+	pud = pud_offset(pgd, address);
+	if (pud_none_or_clear_bad(pud))
+		return NULL;
+	pmd = pmd_offset(pud, address);
+	pmdval = *pmd;
+	barrier();
+	if (pmd_none(pmdval) || pmd_trans_huge(pmdval) ||
+	    pmd_numa(pmdval) || pmd_bad(pmdval))
+		return NULL;
+	return pmd;
+}
+
+/*
+ * Whether the fault can be completed speculatively, as far as can be told
+ * without the pte lock: checked before allocating a page for it, so that
+ * faults which fall back do not allocate and free one for nothing.
+ */
+static bool spf_may_handle(struct mm_struct *mm, unsigned long address,
+			   unsigned int flags)
+{
+	unsigned int seq;
+	pmd_t *pmd = NULL;
+	pte_t *pte;
+	bool ret = false;
+
+	if (!spf_enter(mm))
+		return false;
+	if (spf_find_vma(mm, address, flags, &seq))
+		pmd = spf_find_pmd(mm, address);
+	if (pmd) {
+		pte = pte_offset_map(pmd, address);
+		ret = pte_none(*pte);
+		pte_unmap(pte);
+	}
+	spf_exit(mm);
+
+	return ret;
+}
+
+/*
+ * The page cache page of a read fault on a file, locked and with a
+ * reference, if it is cached, uptodate and not a readahead marker; the
+ * lock keeps truncation away until the pte is installed, as in
+ * __do_fault().
+ */
+static struct page *spf_file_page(struct vm_area_struct *vma,
+				  unsigned long address)
+{
+	struct address_space *mapping = vma->vm_file->f_mapping;
+	struct page *page;
+	pgoff_t pgoff, size;
+
+	pgoff = ((address - vma->vm_start) >> PAGE_SHIFT) + vma->vm_pgoff;
+	size = (i_size_read(mapping->host) + PAGE_CACHE_SIZE - 1) >>
+		PAGE_CACHE_SHIFT;
+	if (pgoff >= size)
+		return NULL;
+
+	page = find_get_page(mapping, pgoff);
+	if (!page)
+		return NULL;
+	if (!trylock_page(page)) {
+		page_cache_release(page);
+		return NULL;
+	}
+	/* ->fault starts the async readahead a marked page asks for */
+	if (page->mapping != mapping || !PageUptodate(page) ||
+	    PageReadahead(page)) {
+		unlock_page(page);
+		page_cache_release(page);
+		return NULL;
+	}
+	return page;
+}
+
+int handle_speculative_fault(struct mm_struct *mm, unsigned long address,
+			     unsigned int flags)
+{
+	struct vm_area_struct *vma;
+	struct page *page = NULL;
+	bool file = false;
+	unsigned int seq;
+	spinlock_t *ptl;
+	pmd_t *pmd;
+	pte_t *pte, entry;
+
+	address &= PAGE_MASK;
+
+	/*
+	 * Nothing may sleep once we are inflight: allocate up front, once
+	 * the fault is known to be one we can complete. Everything is
+	 * checked again after, the VMA may have changed in between.
+	 */
+	if (flags & FAULT_FLAG_WRITE) {
+		if (!spf_may_handle(mm, address, flags))
+			goto out_fallback;
+		page = alloc_zeroed_user_highpage_movable(NULL, address);
+		if (!page)
+			goto out_fallback;
+		__SetPageUptodate(page);
+		if (mem_cgroup_newpage_charge(page, mm, GFP_KERNEL)) {
+			page_cache_release(page);
+			page = NULL;
+			goto out_fallback;
+		}
+	}
+
+	if (!spf_enter(mm))
+		goto out_release;
+	vma = spf_find_vma(mm, address, flags, &seq);
+	if (!vma)
+		goto fallback;
+	pmd = spf_find_pmd(mm, address);
+	if (!pmd)
+		goto fallback;
+
+	if (vma->vm_ops) {
+		/* read fault on a file, no page was allocated */
+		page = spf_file_page(vma, address);
+		if (!page)
+			goto fallback;
+		file = true;
+		entry = mk_pte(page, vma->vm_page_prot);
+	} else if (page) {
+		entry = mk_pte(page, vma->vm_page_prot);
+		if (vma->vm_flags & VM_WRITE)
+			entry = pte_mkwrite(pte_mkdirty(entry));
+	} else {
+		entry = pte_mkspecial(pfn_pte(my_zero_pfn(address),
+					      vma->vm_page_prot));
+	}
+
+	pte = pte_offset_map_lock(mm, pmd, address, &ptl);
+	if (read_seqcount_retry(&vma->vm_sequence, seq) || !pte_none(*pte)) {
+		pte_unmap_unlock(pte, ptl);
+		goto fallback;
+	}
+	if (file) {
+		inc_mm_counter_fast(mm, MM_FILEPAGES);
+		page_add_file_rmap(page);
+	} else if (page) {
+		inc_mm_counter_fast(mm, MM_ANONPAGES);
+		page_add_new_anon_rmap(page, vma, address);
+	}
+	set_pte_at(mm, address, pte, entry);
+	/* No need to invalidate - it was non-present before */
+	update_mmu_cache(vma, address, pte);
+	pte_unmap_unlock(pte, ptl);
+	if (file)
+		unlock_page(page);
+	spf_exit(mm);
+
+	count_vm_event(PGFAULT);
+	mem_cgroup_count_vm_event(mm, PGFAULT);
+	count_vm_event(SPF_SUCCESS);
+	return 0;
+
+fallback:
+	spf_exit(mm);
+out_release:
+	if (file) {
+		unlock_page(page);
+		page_cache_release(page);
+	} else if (page) {
+		mem_cgroup_uncharge_page(page);
+		page_cache_release(page);
+	}
+out_fallback:
+	count_vm_event(SPF_FALLBACK);
+	return VM_FAULT_RETRY;
+}
+#endif /* CONFIG_SPECULATIVE_PAGE_FAULT */
+
 #ifndef __PAGETABLE_PUD_FOLDED
 /*
  * Allocate page upper directory.
@@ -34,6 +34,7 @@
 #include <linux/frontswap.h>
 #include <linux/swapfile.h>
 #include <linux/export.h>
+#include <linux/math64.h>
 
 #include <asm/pgtable.h>
 #include <asm/tlbflush.h>
@@ -53,6 +54,20 @@ long total_swap_pages;
 static int least_priority;
 static atomic_t highest_priority_index = ATOMIC_INIT(-1);
 
+/*
+ * Mapped swap references and the number of slots holding at least one,
+ * so that a swap PSS can be estimated from MM_SWAPENTS without walking
+ * page tables.  Compressed backends (zram) report the pages they store
+ * and their compressed size through swap_compr_account().
+ */
+static atomic_long_t nr_swap_refs;
+static atomic_long_t nr_swap_mapped;
+static atomic_long_t nr_swap_compr_pages;
+static atomic_long_t swap_compr_bytes;
+
+/* bitmap of the swap types whose device stores pages compressed */
+unsigned int swap_compressed_types;
+
 static const char Bad_file[] = "Bad swap file entry ";
 static const char Unused_file[] = "Unused swap file entry ";
 static const char Bad_offset[] = "Bad swap offset entry ";
@@ -613,6 +628,10 @@ checks:
 		si->highest_bit = 0;
 	}
 	si->swap_map[offset] = usage;
+	if (!(usage & SWAP_HAS_CACHE)) {
+		atomic_long_inc(&nr_swap_refs);
+		atomic_long_inc(&nr_swap_mapped);
+	}
 	inc_cluster_info_page(si, si->cluster_info, offset);
 	si->cluster_next = offset + 1;
 	si->flags -= SWP_SCANNING;
@@ -837,6 +856,9 @@ static unsigned char swap_entry_free(struct swap_info_struct *p,
 				count = SWAP_MAP_MAX;
 		} else
 			count--;
+		atomic_long_dec(&nr_swap_refs);
+		if (!count)
+			atomic_long_dec(&nr_swap_mapped);
 	}
 
 	if (!count)
@@ -1190,6 +1212,8 @@ static int unuse_pte(struct vm_area_struct *vma, pmd_t *pmd,
 	}
 
 	dec_mm_counter(vma->vm_mm, MM_SWAPENTS);
+	if (is_compressed_swap_entry(entry))
+		dec_mm_counter(vma->vm_mm, MM_SWAPENTS_COMPR);
 	inc_mm_counter(vma->vm_mm, MM_ANONPAGES);
 	get_page(page);
 	set_pte_at(vma->vm_mm, addr, pte,
@@ -1975,6 +1999,7 @@ SYSCALL_DEFINE1(swapoff, const char __user *, specialfile)
 	cluster_info = p->cluster_info;
 	p->cluster_info = NULL;
 	p->flags = 0;
+	swap_compressed_types &= ~(1U << p->type);
 	frontswap_map = frontswap_map_get(p);
 	frontswap_map_set(p, NULL);
 	spin_unlock(&p->lock);
@@ -2559,6 +2584,10 @@ SYSCALL_DEFINE2(swapon, const char __user *, specialfile, int, swap_flags)
 
 	if (p->bdev && blk_queue_fast(bdev_get_queue(p->bdev)))
 		p->flags |= SWP_FAST;
+	if (p->bdev && blk_queue_compressed(bdev_get_queue(p->bdev))) {
+		p->flags |= SWP_COMPRESSED;
+		swap_compressed_types |= 1U << p->type;
+	}
 
 	mutex_lock(&swapon_mutex);
 	prio = -1;
@@ -2694,6 +2723,7 @@ static int __swap_duplicate(swp_entry_t entry, unsigned char usage)
 			err = -ENOENT;
 
 	} else if (count || has_cache) {
+		unsigned char old_count = count;
 
 		if ((count & ~COUNT_CONTINUED) < SWAP_MAP_MAX)
 			count += usage;
@@ -2703,6 +2733,12 @@ static int __swap_duplicate(swp_entry_t entry, unsigned char usage)
 			count = COUNT_CONTINUED;
 		else
 			err = -ENOMEM;
+
+		if (!err && usage == 1) {
+			atomic_long_inc(&nr_swap_refs);
+			if (!old_count)
+				atomic_long_inc(&nr_swap_mapped);
+		}
 	} else
 		err = -ENOENT;			/* unused swap entry */
 
@@ -2718,6 +2754,45 @@ bad_file:
 	goto out;
 }
 
+/*
+ * Estimate the proportional share of @swapents mapped swap entries,
+ * assuming they are shared as much as the average swap slot.
+ */
+unsigned long swap_pss_estimate(unsigned long swapents)
+{
+	long refs = atomic_long_read(&nr_swap_refs);
+	long mapped = atomic_long_read(&nr_swap_mapped);
+
+	if (refs <= 0 || mapped <= 0 || mapped >= refs)
+		return swapents;
+	return div64_u64((u64)swapents * mapped, refs);
+}
+
+/*
+ * Estimate the compressed size in bytes of @pages swapped out pages,
+ * using the average ratio reported by compressed swap backends.
+ */
+unsigned long swap_compr_estimate(unsigned long pages)
+{
+	long stored = atomic_long_read(&nr_swap_compr_pages);
+	long bytes = atomic_long_read(&swap_compr_bytes);
+
+	if (stored <= 0 || bytes <= 0)
+		return 0;
+	return div64_u64((u64)pages * bytes, stored);
+}
+
+/*
+ * Called by compressed swap backends whenever they store (positive
+ * @pages) or drop (negative @pages) pages of @bytes compressed size.
+ */
+void swap_compr_account(long pages, long bytes)
+{
+	atomic_long_add(pages, &nr_swap_compr_pages);
+	atomic_long_add(bytes, &swap_compr_bytes);
+}
+EXPORT_SYMBOL_GPL(swap_compr_account);
+
 /*
  * Help swapoff by noting that swap entry belongs to shmem/tmpfs
  * (in which case its reference count is never incremented).
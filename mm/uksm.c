@@ -69,6 +69,10 @@
 #include <linux/gcd.h>
 #include <linux/freezer.h>
 #include <linux/sradix-tree.h>
+#include <linux/smpboot.h>
+#include <linux/tick.h>
+#include <linux/kernel_stat.h>
+#include <linux/cpufreq.h>
 
 #include <asm/tlbflush.h>
 #include "internal.h"
@@ -566,6 +570,21 @@ struct list_head vma_slot_dedup = LIST_HEAD_INIT(vma_slot_dedup);
 /* How many times the ksmd has slept since startup */
 static unsigned long long uksm_sleep_times;
 
+/* Pages merged since startup, including those mapped to the zero page */
+static u64 uksm_pages_merged;
+
+/*
+ * With idle scanning, per-cpu workers scan with the idle time of their
+ * cpus instead of the fixed budget of the cpu governor presets.
+ */
+static unsigned int uksm_idle_scan;
+
+/* Percentage of a cpu's idle time its worker may spend scanning */
+static unsigned int uksm_idle_budget = 50;
+
+/* A cpu running above this percentage of its max frequency is left alone */
+static unsigned int uksm_idle_freq_pct = 60;
+
 #define UKSM_RUN_STOP	0
 #define UKSM_RUN_MERGE	1
 static unsigned int uksm_run = 0;
@@ -1828,6 +1847,9 @@ static int try_to_merge_two_pages(struct rmap_item *rmap_item,
 	saved_mapping = page->mapping;
 	set_page_stable_node(page, NULL);
 	mark_page_accessed(page);
+	/* not to be discarded as a clean MADV_FREE page, see ksm.c */
+	if (!PageDirty(page))
+		SetPageDirty(page);
 	unlock_page(page);
 
 	if (!trylock_page(tree_page))
@@ -2523,6 +2545,7 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 
 	BUG_ON(!stable_node);
 	rmap_item->address |= STABLE_FLAG;
+	uksm_pages_merged++;
 
 	if (hlist_empty(&stable_node->hlist)) {
 		uksm_pages_shared++;
@@ -3257,6 +3280,7 @@ static struct rmap_item *get_next_rmap_item(struct vma_slot *slot, u32 *hash)
 	if (find_zero_page_hash(hash_strength, *hash)) {
 		if (!cmp_and_merge_zero_page(slot->vma, page)) {
 			slot->pages_merged++;
+			uksm_pages_merged++;
 			__inc_zone_page_state(page, NR_UKSM_ZERO_PAGES);
 			dec_mm_counter(slot->mm, MM_ANONPAGES);
 
@@ -4246,6 +4270,27 @@ static void uksm_calc_scan_pages(void)
 	}
 }
 
+/*
+ * Idle scanning: the quota is whatever the worker's idle time pays for,
+ * handed out to the rungs from the richest down, at most one pass over
+ * each.
+ */
+static void uksm_calc_budget_pages(unsigned long budget)
+{
+	struct scan_rung *ladder = uksm_scan_ladder;
+	unsigned long pagecnt;
+	int i;
+
+	for (i = SCAN_LADDER_SIZE - 1; i >= 0; i--) {
+		pagecnt = min(rung_get_pages(&ladder[i]), budget);
+		ladder[i].pages_to_scan = pagecnt;
+		if (pagecnt) {
+			budget -= pagecnt;
+			uksm_calc_rung_step(&ladder[i]);
+		}
+	}
+}
+
 #define __round_mask(x, y) ((__typeof__(x))((y)-1))
 #define round_up(x, y) ((((x)-1) | __round_mask(x, y))+1)
 
@@ -4394,10 +4439,12 @@ static inline int hash_round_finished(void)
 
 /**
  * uksm_do_scan()  - the main worker function.
+ *
+ * Returns the number of pages scanned.
  */
-static void uksm_do_scan(void)
+static unsigned long uksm_do_scan(void)
 	__attribute__((hot));
-static void uksm_do_scan(void)
+static unsigned long uksm_do_scan(void)
 {
 	struct vma_slot *slot, *iter;
 	struct mm_struct *busy_mm;
@@ -4515,7 +4562,7 @@ rm_slot:
 		}
 
 		if (unlikely(freezing(current)))
-			return;
+			return vpages;
 	}
 	end_time = task_sched_runtime(current);
 	end_wall = ktime_get();
@@ -4582,7 +4629,7 @@ rm_slot:
 
 	uksm_calc_scan_pages();
 
-	return;
+	return vpages;
 }
 
 static int ksmd_should_run(void)
@@ -4590,6 +4637,146 @@ static int ksmd_should_run(void)
 	return uksm_run & UKSM_RUN_MERGE;
 }
 
+struct uksm_worker {
+	/* idle time of the cpu at the last dispatch */
+	u64 last_idle_us;
+	/* idle time earned and not spent yet */
+	unsigned long budget_us;
+	/* pages the worker was told to scan, 0 once it is done */
+	unsigned long grant;
+	/* statistics */
+	unsigned long runs;
+	u64 pages_scanned;
+	u64 pages_merged;
+	u64 cpu_ns;
+};
+
+static DEFINE_PER_CPU(struct uksm_worker, uksm_workers);
+static DEFINE_PER_CPU(struct task_struct *, uksm_worker_task);
+static bool uksm_workers_ready;
+
+/* Idle time of the cpu since boot, in us */
+static u64 uksm_cpu_idle_us(int cpu)
+{
+	u64 idle = get_cpu_idle_time_us(cpu, NULL);
+
+	if (idle == -1ULL)
+		idle = cputime_to_usecs(kcpustat_cpu(cpu).cpustat[CPUTIME_IDLE]);
+	return idle;
+}
+
+static bool uksm_cpu_low_freq(int cpu)
+{
+	unsigned int cur, max;
+
+	if (uksm_idle_freq_pct >= 100)
+		return true;
+
+	cur = cpufreq_quick_get(cpu);
+	max = cpufreq_quick_get_max(cpu);
+	return !max || cur * 100 <= max * uksm_idle_freq_pct;
+}
+
+static int uksm_worker_should_run(unsigned int cpu)
+{
+	return ACCESS_ONCE(per_cpu(uksm_workers, cpu).grant) != 0;
+}
+
+static void uksm_worker_setup(unsigned int cpu)
+{
+	set_user_nice(current, 19);
+}
+
+/*
+ * Scans the pages granted to the worker. The scan state is shared, so
+ * the workers take turns under uksm_thread_mutex, each on its own cpu.
+ * The grant is scanned in batches of about a millisecond of cpu time,
+ * dropping the mutex in between, so that the other workers, the sysfs
+ * writers and memory hotplug wait for a batch rather than a whole grant.
+ */
+static void uksm_worker_fn(unsigned int cpu)
+{
+	struct uksm_worker *w = &per_cpu(uksm_workers, cpu);
+	unsigned long left = ACCESS_ONCE(w->grant);
+	u64 runtime = task_sched_runtime(current);
+	unsigned long batch, scanned;
+	u64 merged;
+
+	w->runs++;
+	while (left) {
+		mutex_lock(&uksm_thread_mutex);
+		if (!ksmd_should_run() || !uksm_idle_scan) {
+			mutex_unlock(&uksm_thread_mutex);
+			break;
+		}
+		merged = uksm_pages_merged;
+		batch = min(left, uksm_ema_task_pages);
+		uksm_calc_budget_pages(batch);
+		scanned = uksm_do_scan();
+		w->pages_scanned += scanned;
+		w->pages_merged += uksm_pages_merged - merged;
+		mutex_unlock(&uksm_thread_mutex);
+
+		/* nothing left to scan in this round */
+		if (!scanned)
+			break;
+		left -= batch;
+		cond_resched();
+	}
+
+	w->cpu_ns += task_sched_runtime(current) - runtime;
+	ACCESS_ONCE(w->grant) = 0;
+}
+
+static struct smp_hotplug_thread uksm_worker_threads = {
+	.store			= &uksm_worker_task,
+	.thread_should_run	= uksm_worker_should_run,
+	.thread_fn		= uksm_worker_fn,
+	.setup			= uksm_worker_setup,
+	.thread_comm		= "uksmd/%u",
+};
+
+/*
+ * Credits every online cpu with the idle time it had since the last call
+ * and sends the workers of cpus at low frequency off to spend it. Idle
+ * time that is not spent is kept for up to two intervals.
+ */
+static void uksm_idle_dispatch(void)
+{
+	unsigned long interval_us = jiffies_to_usecs(uksm_sleep_jiffies);
+	unsigned long cap = 2 * interval_us * uksm_idle_budget / 100;
+	struct uksm_worker *w;
+	unsigned long pages;
+	u64 idle, delta;
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		w = &per_cpu(uksm_workers, cpu);
+		idle = uksm_cpu_idle_us(cpu);
+		delta = idle > w->last_idle_us ? idle - w->last_idle_us : 0;
+		/* a cpu that just came online has no history */
+		if (!w->last_idle_us)
+			delta = 0;
+		w->last_idle_us = idle;
+		w->budget_us = min_t(u64, w->budget_us +
+				     div_u64(delta * uksm_idle_budget, 100), cap);
+
+		if (ACCESS_ONCE(w->grant) || !uksm_cpu_low_freq(cpu))
+			continue;
+
+		/* uksm_ema_task_pages is in pages per ms of cpu time */
+		pages = w->budget_us * uksm_ema_task_pages / 1000;
+		if (pages < RUNG_SAMPLED_MIN * SCAN_LADDER_SIZE)
+			continue;
+
+		w->budget_us = 0;
+		ACCESS_ONCE(w->grant) = pages;
+		wake_up_process(per_cpu(uksm_worker_task, cpu));
+	}
+	put_online_cpus();
+}
+
 static int uksm_scan_thread(void *nothing)
 {
 	long timeout = 60 * HZ;
@@ -4611,8 +4798,13 @@ static int uksm_scan_thread(void *nothing)
 		}
 
 		if (likely(ksmd_should_run())) {
-			uksm_do_scan();
-			mutex_unlock(&uksm_thread_mutex);
+			if (uksm_idle_scan && uksm_workers_ready) {
+				mutex_unlock(&uksm_thread_mutex);
+				uksm_idle_dispatch();
+			} else {
+				uksm_do_scan();
+				mutex_unlock(&uksm_thread_mutex);
+			}
 			timeout = uksm_sleep_jiffies - jiffies % uksm_sleep_jiffies;
 			uksm_sleep_times++;
 		} else {
@@ -5385,6 +5577,99 @@ static ssize_t sleep_times_show(struct kobject *kobj,
 }
 UKSM_ATTR_RO(sleep_times);
 
+static ssize_t idle_scan_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", uksm_idle_scan);
+}
+
+static ssize_t idle_scan_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	int err;
+	unsigned long flags;
+
+	err = strict_strtoul(buf, 10, &flags);
+	if (err || flags > 1)
+		return -EINVAL;
+	if (flags && !uksm_workers_ready)
+		return -ENODEV;
+
+	uksm_idle_scan = flags;
+
+	return count;
+}
+UKSM_ATTR(idle_scan);
+
+static ssize_t idle_budget_show(struct kobject *kobj,
+				struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", uksm_idle_budget);
+}
+
+static ssize_t idle_budget_store(struct kobject *kobj,
+				 struct kobj_attribute *attr,
+				 const char *buf, size_t count)
+{
+	int err;
+	unsigned long pct;
+
+	err = strict_strtoul(buf, 10, &pct);
+	if (err || !pct || pct > 100)
+		return -EINVAL;
+
+	uksm_idle_budget = pct;
+
+	return count;
+}
+UKSM_ATTR(idle_budget);
+
+static ssize_t idle_freq_pct_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", uksm_idle_freq_pct);
+}
+
+static ssize_t idle_freq_pct_store(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   const char *buf, size_t count)
+{
+	int err;
+	unsigned long pct;
+
+	err = strict_strtoul(buf, 10, &pct);
+	if (err || !pct || pct > 100)
+		return -EINVAL;
+
+	uksm_idle_freq_pct = pct;
+
+	return count;
+}
+UKSM_ATTR(idle_freq_pct);
+
+static ssize_t worker_stats_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	struct uksm_worker *w;
+	u64 cpu_ms, rate;
+	int cpu, n = 0;
+
+	for_each_possible_cpu(cpu) {
+		w = &per_cpu(uksm_workers, cpu);
+		cpu_ms = div_u64(w->cpu_ns, NSEC_PER_MSEC);
+		/* pages merged per second of cpu time */
+		rate = cpu_ms ? div64_u64(w->pages_merged * 1000, cpu_ms) : 0;
+		n += scnprintf(buf + n, PAGE_SIZE - n,
+			       "cpu%d runs %lu scanned %llu merged %llu "
+			       "cpu_ms %llu merge_rate %llu\n", cpu, w->runs,
+			       w->pages_scanned, w->pages_merged, cpu_ms, rate);
+	}
+
+	return n;
+}
+UKSM_ATTR_RO(worker_stats);
+
 
 static struct attribute *uksm_attrs[] = {
 	&max_cpu_percentage_attr.attr,
@@ -5399,6 +5684,10 @@ static struct attribute *uksm_attrs[] = {
 	&pages_scanned_attr.attr,
 	&hash_strength_attr.attr,
 	&sleep_times_attr.attr,
+	&idle_scan_attr.attr,
+	&idle_budget_attr.attr,
+	&idle_freq_pct_attr.attr,
+	&worker_stats_attr.attr,
 	&thrash_threshold_attr.attr,
 	&abundant_threshold_attr.attr,
 	&cpu_ratios_attr.attr,
@@ -5728,6 +6017,12 @@ static int __init uksm_init(void)
 		goto out_free;
 	}
 
+	/* without them, scanning just stays with uksmd */
+	if (smpboot_register_percpu_thread(&uksm_worker_threads))
+		printk(KERN_ERR "uksm: creating per-cpu workers failed\n");
+	else
+		uksm_workers_ready = true;
+
 #ifdef CONFIG_SYSFS
 	err = sysfs_create_group(mm_kobj, &uksm_attr_group);
 	if (err) {
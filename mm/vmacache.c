@@ -102,6 +102,32 @@ struct vm_area_struct *vmacache_find(struct mm_struct *mm, unsigned long addr)
 	return NULL;
 }
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+/*
+ * Lookup for speculative page faults, done without mmap_sem: the cache
+ * is never modified and a stale seqnum simply misses.  The caller must
+ * validate the result against vma->vm_sequence.
+ */
+struct vm_area_struct *vmacache_find_speculative(struct mm_struct *mm,
+						 unsigned long addr)
+{
+	int i;
+
+	if (!vmacache_valid_mm(mm) ||
+	    ACCESS_ONCE(mm->vmacache_seqnum) != current->vmacache_seqnum)
+		return NULL;
+
+	for (i = 0; i < VMACACHE_SIZE; i++) {
+		struct vm_area_struct *vma = ACCESS_ONCE(current->vmacache[i]);
+
+		if (vma && vma->vm_start <= addr && vma->vm_end > addr)
+			return vma;
+	}
+
+	return NULL;
+}
+#endif
+
 #ifndef CONFIG_MMU
 struct vm_area_struct *vmacache_find_exact(struct mm_struct *mm,
 					   unsigned long start,
@@ -778,7 +778,7 @@ static void page_check_dirty_writeback(struct page *page,
 	 * Anonymous pages are not handled by flushers and must be written
 	 * from reclaim context. Do not stall reclaim based on them
 	 */
-	if (!page_is_file_cache(page)) {
+	if (!page_is_file_cache(page) || PageAnon(page)) {
 		*dirty = false;
 		*writeback = false;
 		return;
@@ -797,6 +797,21 @@ static void page_check_dirty_writeback(struct page *page,
 		mapping->a_ops->is_dirty_writeback(page, dirty, writeback);
 }
 
+/*
+ * A page freed with MADV_FREE was written to again: from now on it is an
+ * ordinary anonymous page. Pages isolated from a single zone's lru are
+ * accounted in bulk by the caller, otherwise the isolation counters are
+ * updated here.
+ */
+static void page_lazyfree_reused(struct page *page, struct zone *zone)
+{
+	SetPageSwapBacked(page);
+	if (!zone) {
+		dec_zone_page_state(page, NR_ISOLATED_FILE);
+		inc_zone_page_state(page, NR_ISOLATED_ANON);
+	}
+}
+
 /*
  * shrink_page_list() returns the number of reclaimed pages
  */
@@ -829,7 +844,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		struct page *page;
 		int may_enter_fs;
 		enum page_references references = PAGEREF_RECLAIM;
-		bool dirty, writeback;
+		bool dirty, writeback, lazyfree;
 
 		cond_resched();
 
@@ -963,9 +978,11 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 
 		/*
 		 * Anonymous process memory has backing store?
-		 * Try to allocate it some swap space here.
+		 * Try to allocate it some swap space here. Pages freed
+		 * with MADV_FREE need none, they are discarded if clean.
 		 */
-		if (PageAnon(page) && !PageSwapCache(page)) {
+		lazyfree = PageAnon(page) && !PageSwapBacked(page);
+		if (PageAnon(page) && !lazyfree && !PageSwapCache(page)) {
 			if (!(sc->gfp_mask & __GFP_IO))
 				goto keep_locked;
 			if (!add_to_swap(page, page_list))
@@ -980,10 +997,15 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		 * The page is mapped into the page tables of one or more
 		 * processes. Try to unmap it here.
 		 */
-		if (page_mapped(page) && mapping) {
+		if (page_mapped(page) && (mapping || lazyfree)) {
 			switch (try_to_unmap(page,
 					ttu_flags, sc->target_vma)) {
 			case SWAP_FAIL:
+				if (lazyfree) {
+					if (!PageDirty(page))
+						goto keep_locked;
+					page_lazyfree_reused(page, zone);
+				}
 				goto activate_locked;
 			case SWAP_AGAIN:
 				goto keep_locked;
@@ -1090,7 +1112,16 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			}
 		}
 
-		if (!mapping || !__remove_mapping(mapping, page))
+		if (lazyfree) {
+			/* like __remove_mapping(), for a page without one */
+			if (page_mapped(page) || !page_freeze_refs(page, 1))
+				goto keep_locked;
+			if (PageDirty(page)) {
+				page_unfreeze_refs(page, 1);
+				goto keep_locked;
+			}
+			count_vm_event(PGLAZYFREED);
+		} else if (!mapping || !__remove_mapping(mapping, page))
 			goto keep_locked;
 
 		/*
@@ -1168,7 +1199,7 @@ unsigned long reclaim_clean_pages_from_list(struct zone *zone,
 
 	list_for_each_entry_safe(page, next, page_list, lru) {
 		if (page_is_file_cache(page) && !PageDirty(page) &&
-		    !isolated_balloon_page(page)) {
+		    !PageAnon(page) && !isolated_balloon_page(page)) {
 			ClearPageActive(page);
 			list_move(&page->lru, &clean_pages);
 		}
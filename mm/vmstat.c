@@ -760,6 +760,7 @@ const char * const vmstat_text[] = {
 	"pgfree",
 	"pgactivate",
 	"pgdeactivate",
+	"pglazyfree",
 
 	"pgfault",
 	"pgmajfault",
@@ -786,6 +787,7 @@ const char * const vmstat_text[] = {
 
 	"drop_pagecache",
 	"drop_slab",
+	"pglazyfreed",
 
 #ifdef CONFIG_NUMA_BALANCING
 	"numa_pte_updates",
@@ -818,6 +820,7 @@ const char * const vmstat_text[] = {
 	"unevictable_pgs_munlocked",
 	"unevictable_pgs_cleared",
 	"unevictable_pgs_stranded",
+	"unevictable_pgs_mlockfreed",
 
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	"thp_fault_alloc",
@@ -828,6 +831,10 @@ const char * const vmstat_text[] = {
 	"thp_zero_page_alloc",
 	"thp_zero_page_alloc_failed",
 #endif
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	"spf_success",
+	"spf_fallback",
+#endif
 
 #endif /* CONFIG_VM_EVENTS_COUNTERS */
 };
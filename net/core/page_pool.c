@@ -0,0 +1,366 @@
+/*
+ * net/core/page_pool.c	Recycling of network receive pages
+ *
+ *		This program is free software; you can redistribute it and/or
+ *		modify it under the terms of the GNU General Public License
+ *		as published by the Free Software Foundation; either version
+ *		2 of the License, or (at your option) any later version.
+ *
+ * A pool keeps pages in two places: a small cache that only its owner
+ * touches, from its NAPI poll and without locking, and a ring that
+ * skb frees from any context put pages back into. The owner refills
+ * its cache from the ring a batch at a time, and goes to the page
+ * allocator only when both are empty.
+ *
+ * The pool does not track the pages it hands out: a page is recycled
+ * when the last reference to it is dropped by an skb marked for
+ * recycling. Any other holder of a page makes it leave the pool, and it
+ * is freed like any other page when its last reference goes.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/err.h>
+#include <linux/mm.h>
+#include <linux/ethtool.h>
+#include <net/page_pool.h>
+
+#define PAGE_POOL_CACHE_SIZE	64
+#define PAGE_POOL_CACHE_REFILL	(PAGE_POOL_CACHE_SIZE / 4)
+
+struct page_pool {
+	struct page_pool_params	p;
+
+	/* only touched from the napi context of the owner */
+	unsigned int		cache_count;
+	struct page		*cache[PAGE_POOL_CACHE_SIZE];
+	u64			alloc_fast;
+	u64			alloc_refill;
+	u64			alloc_slow;
+	u64			alloc_failed;
+
+	/* pages recycled on skb free, from any context */
+	spinlock_t		ring_lock ____cacheline_aligned_in_smp;
+	struct page		**ring;
+	unsigned int		ring_head;
+	unsigned int		ring_count;
+	bool			dead;
+	u64			recycled;
+	u64			recycle_full;
+
+	atomic_long_t		released;
+	/* the owner, and each page the pool took from the page allocator */
+	atomic_t		users;
+};
+
+static const char page_pool_stat_names[][ETH_GSTRING_LEN] = {
+	"rx_pp_alloc_fast",
+	"rx_pp_alloc_refill",
+	"rx_pp_alloc_slow",
+	"rx_pp_alloc_failed",
+	"rx_pp_recycled",
+	"rx_pp_recycle_full",
+	"rx_pp_released",
+};
+
+struct page_pool *page_pool_create(const struct page_pool_params *params)
+{
+	struct page_pool *pool;
+
+	if (!params->pool_size)
+		return ERR_PTR(-EINVAL);
+	if (params->flags & PP_FLAG_DMA_MAP) {
+		/* the mapping is kept in page->private */
+		if (sizeof(dma_addr_t) > sizeof(unsigned long) || !params->dev)
+			return ERR_PTR(-EINVAL);
+	}
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return ERR_PTR(-ENOMEM);
+
+	pool->ring = kcalloc(params->pool_size, sizeof(*pool->ring),
+			     GFP_KERNEL);
+	if (!pool->ring) {
+		kfree(pool);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	pool->p = *params;
+	spin_lock_init(&pool->ring_lock);
+	atomic_long_set(&pool->released, 0);
+	atomic_set(&pool->users, 1);
+
+	return pool;
+}
+EXPORT_SYMBOL(page_pool_create);
+
+static void page_pool_put(struct page_pool *pool)
+{
+	if (atomic_dec_and_test(&pool->users)) {
+		kfree(pool->ring);
+		kfree(pool);
+	}
+}
+
+/* Whoever clears the magic of a page takes it out of the pool. */
+static bool page_pool_claim(struct page *page)
+{
+	return cmpxchg(&page->lru.next, PAGE_POOL_MAGIC, NULL) ==
+		PAGE_POOL_MAGIC;
+}
+
+/* The page leaves the pool, the caller still holds a reference to it. */
+static void __page_pool_release(struct page_pool *pool, struct page *page)
+{
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		dma_unmap_page(pool->p.dev, page_pool_get_dma_addr(page),
+			       PAGE_SIZE << pool->p.order, pool->p.dma_dir);
+		page->private = 0;
+	}
+	page->lru.next = NULL;
+	page->lru.prev = NULL;
+
+	atomic_long_inc(&pool->released);
+	page_pool_put(pool);
+}
+
+/**
+ *	page_pool_release_page - take a page out of its pool
+ *	@pool: pool the page was allocated from
+ *	@page: page to take out
+ *
+ *	The page is unmapped and becomes an ordinary page. The caller
+ *	keeps its reference to it, and frees it as it wishes.
+ */
+void page_pool_release_page(struct page_pool *pool, struct page *page)
+{
+	if (page_pool_claim(page))
+		__page_pool_release(pool, page);
+}
+EXPORT_SYMBOL(page_pool_release_page);
+
+static struct page *page_pool_alloc_slow(struct page_pool *pool, gfp_t gfp)
+{
+	struct page *page;
+	dma_addr_t dma;
+
+	if (pool->p.order)
+		gfp |= __GFP_COMP;
+	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
+	if (!page) {
+		pool->alloc_failed++;
+		return NULL;
+	}
+
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		dma = dma_map_page(pool->p.dev, page, 0,
+				   PAGE_SIZE << pool->p.order, pool->p.dma_dir);
+		if (dma_mapping_error(pool->p.dev, dma)) {
+			__free_pages(page, pool->p.order);
+			pool->alloc_failed++;
+			return NULL;
+		}
+		page->private = dma;
+	}
+
+	atomic_inc(&pool->users);
+	page->lru.prev = (struct list_head *)pool;
+	page->lru.next = PAGE_POOL_MAGIC;
+	pool->alloc_slow++;
+
+	return page;
+}
+
+/* Moves a batch of recycled pages into the cache of the owner. */
+static bool page_pool_refill(struct page_pool *pool)
+{
+	unsigned long flags;
+	unsigned int n;
+
+	if (!ACCESS_ONCE(pool->ring_count))
+		return false;
+
+	spin_lock_irqsave(&pool->ring_lock, flags);
+	n = min_t(unsigned int, pool->ring_count, PAGE_POOL_CACHE_REFILL);
+	pool->ring_count -= n;
+	while (n--) {
+		pool->cache[pool->cache_count++] = pool->ring[pool->ring_head];
+		if (++pool->ring_head == pool->p.pool_size)
+			pool->ring_head = 0;
+	}
+	spin_unlock_irqrestore(&pool->ring_lock, flags);
+
+	pool->alloc_refill++;
+	return pool->cache_count != 0;
+}
+
+/**
+ *	page_pool_alloc_pages - allocate a page from a pool
+ *	@pool: pool to allocate from
+ *	@gfp: allocation mask, used when the pool has no page to recycle
+ *
+ *	Must be called from the napi context of the owner of the pool.
+ */
+struct page *page_pool_alloc_pages(struct page_pool *pool, gfp_t gfp)
+{
+	if (likely(pool->cache_count)) {
+		pool->alloc_fast++;
+		return pool->cache[--pool->cache_count];
+	}
+
+	if (page_pool_refill(pool))
+		return pool->cache[--pool->cache_count];
+
+	return page_pool_alloc_slow(pool, gfp);
+}
+EXPORT_SYMBOL(page_pool_alloc_pages);
+
+/* The caller holds the last reference to the page. */
+static bool page_pool_recycle(struct page_pool *pool, struct page *page)
+{
+	unsigned long flags;
+	unsigned int tail;
+	bool ret = false;
+
+	spin_lock_irqsave(&pool->ring_lock, flags);
+	if (!pool->dead && !page->pfmemalloc) {
+		if (pool->ring_count < pool->p.pool_size) {
+			tail = pool->ring_head + pool->ring_count;
+			if (tail >= pool->p.pool_size)
+				tail -= pool->p.pool_size;
+			pool->ring[tail] = page;
+			pool->ring_count++;
+			pool->recycled++;
+			ret = true;
+		} else
+			pool->recycle_full++;
+	}
+	spin_unlock_irqrestore(&pool->ring_lock, flags);
+
+	if (!ret)
+		__page_pool_release(pool, page);
+	return ret;
+}
+
+/**
+ *	page_pool_recycle_direct - give an unused page back to its pool
+ *	@pool: pool the page was allocated from
+ *	@page: page, the caller holding the only reference to it
+ *
+ *	Must be called from the napi context of the owner of the pool.
+ */
+void page_pool_recycle_direct(struct page_pool *pool, struct page *page)
+{
+	if (pool->cache_count < PAGE_POOL_CACHE_SIZE && !page->pfmemalloc) {
+		pool->cache[pool->cache_count++] = page;
+		return;
+	}
+	if (!page_pool_recycle(pool, page))
+		__free_pages(page, pool->p.order);
+}
+EXPORT_SYMBOL(page_pool_recycle_direct);
+
+/**
+ *	page_pool_put_page - drop a reference to a page of an skb
+ *	@page: page of an skb marked for recycling
+ *
+ *	Returns true if the page was a pool page, the reference dropped
+ *	was the last one and the page went back to its pool. Otherwise
+ *	the caller drops the reference with put_page() as usual.
+ */
+bool page_pool_put_page(struct page *page)
+{
+	struct page_pool *pool;
+
+	if (page_count(page) == 1) {
+		/*
+		 * Pairs with the put_page() of whoever dropped the other
+		 * references, after taking the page out of the pool.
+		 */
+		smp_rmb();
+		if (!page_is_pool(page))
+			return false;
+		pool = (struct page_pool *)page->lru.prev;
+		return page_pool_recycle(pool, page);
+	}
+
+	/* still in use elsewhere, it leaves the pool */
+	if (page_pool_claim(page)) {
+		pool = (struct page_pool *)page->lru.prev;
+		__page_pool_release(pool, page);
+	}
+	return false;
+}
+EXPORT_SYMBOL(page_pool_put_page);
+
+static void page_pool_free_page(struct page_pool *pool, struct page *page)
+{
+	__page_pool_release(pool, page);
+	__free_pages(page, pool->p.order);
+}
+
+/**
+ *	page_pool_destroy - release a pool
+ *	@pool: pool to release
+ *
+ *	Called by the owner once its napi is disabled for good. Pages still
+ *	in skbs keep the pool around until they are freed, they are not
+ *	recycled anymore.
+ */
+void page_pool_destroy(struct page_pool *pool)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->ring_lock, flags);
+	pool->dead = true;
+	spin_unlock_irqrestore(&pool->ring_lock, flags);
+
+	while (pool->ring_count) {
+		page_pool_free_page(pool, pool->ring[pool->ring_head]);
+		if (++pool->ring_head == pool->p.pool_size)
+			pool->ring_head = 0;
+		pool->ring_count--;
+	}
+	while (pool->cache_count)
+		page_pool_free_page(pool, pool->cache[--pool->cache_count]);
+
+	page_pool_put(pool);
+}
+EXPORT_SYMBOL(page_pool_destroy);
+
+void page_pool_get_stats(struct page_pool *pool, struct page_pool_stats *stats)
+{
+	stats->alloc_fast = pool->alloc_fast;
+	stats->alloc_refill = pool->alloc_refill;
+	stats->alloc_slow = pool->alloc_slow;
+	stats->alloc_failed = pool->alloc_failed;
+	stats->recycled = pool->recycled;
+	stats->recycle_full = pool->recycle_full;
+	stats->released = atomic_long_read(&pool->released);
+}
+EXPORT_SYMBOL(page_pool_get_stats);
+
+int page_pool_ethtool_stats_get_count(void)
+{
+	return ARRAY_SIZE(page_pool_stat_names);
+}
+EXPORT_SYMBOL(page_pool_ethtool_stats_get_count);
+
+u8 *page_pool_ethtool_stats_get_strings(u8 *data)
+{
+	memcpy(data, page_pool_stat_names, sizeof(page_pool_stat_names));
+	return data + sizeof(page_pool_stat_names);
+}
+EXPORT_SYMBOL(page_pool_ethtool_stats_get_strings);
+
+u64 *page_pool_ethtool_stats_get(u64 *data, struct page_pool_stats *stats)
+{
+	BUILD_BUG_ON(sizeof(*stats) !=
+		     ARRAY_SIZE(page_pool_stat_names) * sizeof(u64));
+
+	memcpy(data, stats, sizeof(*stats));
+	return data + ARRAY_SIZE(page_pool_stat_names);
+}
+EXPORT_SYMBOL(page_pool_ethtool_stats_get);
@@ -498,9 +498,12 @@ static void skb_clone_fraglist(struct sk_buff *skb)
 
 static void skb_free_head(struct sk_buff *skb)
 {
-	if (skb->head_frag)
-		put_page(virt_to_head_page(skb->head));
-	else
+	if (skb->head_frag) {
+		struct page *page = virt_to_head_page(skb->head);
+
+		if (!skb->pp_recycle || !page_pool_put_page(page))
+			put_page(page);
+	} else
 		kfree(skb->head);
 }
 
@@ -799,6 +802,7 @@ static struct sk_buff *__skb_clone(struct sk_buff *n, struct sk_buff *skb)
 	C(end);
 	C(head);
 	C(head_frag);
+	C(pp_recycle);
 	C(data);
 	C(truesize);
 	atomic_set(&n->users, 1);
@@ -3003,6 +3007,10 @@ int skb_gro_receive(struct sk_buff **head, struct sk_buff *skb)
 	if (p->len + len >= 65536)
 		return -E2BIG;
 
+	/* pool pages must not move to an skb that does not recycle them */
+	if (p->pp_recycle != skb->pp_recycle)
+		return -E2BIG;
+
 	if (pinfo->frag_list)
 		goto merge;
 	else if (headlen <= offset) {
@@ -3502,6 +3510,9 @@ bool skb_try_coalesce(struct sk_buff *to, struct sk_buff *from,
 	if (skb_has_frag_list(to) || skb_has_frag_list(from))
 		return false;
 
+	if (to->pp_recycle != from->pp_recycle)
+		return false;
+
 	if (skb_headlen(from) != 0) {
 		struct page *page;
 		unsigned int offset;
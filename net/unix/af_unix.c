@@ -470,11 +470,72 @@ static void unix_dgram_disconnected(struct sock *sk, struct sock *other)
 	}
 }
 
+/*
+ * Small datagrams are sent back and forth at high rates, an input event
+ * and its acknowledgment for instance. Instead of freeing a consumed skb,
+ * the receiver gives it back to the socket which sent it, whose next
+ * send reuses it. Only one skb is kept per socket.
+ */
+#define UNIX_SKB_CACHE_SIZE	SKB_DATA_ALIGN(1024 + NET_SKB_PAD)
+
+static void unix_destruct_scm(struct sk_buff *skb);
+
+static bool unix_skb_cache_put(struct sk_buff *skb)
+{
+	struct sock *owner = skb->sk;
+	struct unix_sock *u;
+
+	if (!owner || skb->destructor != unix_destruct_scm ||
+	    skb_end_offset(skb) > UNIX_SKB_CACHE_SIZE ||
+	    !skb_is_recycleable(skb, 0))
+		return false;
+
+	u = unix_sk(owner);
+	if (u->skb_cache || sock_flag(owner, SOCK_DEAD))
+		return false;
+
+	/*
+	 * The skb keeps the owner allocated, not alive: take a reference
+	 * before the destructor of the skb drops its charge.
+	 */
+	if (!atomic_inc_not_zero(&owner->sk_refcnt))
+		return false;
+
+	skb_recycle(skb);
+	if (cmpxchg(&u->skb_cache, NULL, skb) != NULL)
+		__kfree_skb(skb);
+
+	sock_put(owner);
+	return true;
+}
+
+static struct sk_buff *unix_alloc_send_skb(struct sock *sk, size_t len,
+					   int noblock, int *err)
+{
+	struct unix_sock *u = unix_sk(sk);
+	struct sk_buff *skb;
+
+	/* sock_alloc_send_skb() reports errors and waits for sndbuf */
+	if (u->skb_cache && !sk->sk_err &&
+	    !(sk->sk_shutdown & SEND_SHUTDOWN) &&
+	    atomic_read(&sk->sk_wmem_alloc) < sk->sk_sndbuf) {
+		skb = xchg(&u->skb_cache, NULL);
+		if (skb && skb_tailroom(skb) >= len) {
+			skb_set_owner_w(skb, sk);
+			return skb;
+		}
+		kfree_skb(skb);
+	}
+
+	return sock_alloc_send_skb(sk, len, noblock, err);
+}
+
 static void unix_sock_destructor(struct sock *sk)
 {
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge(&sk->sk_receive_queue);
+	kfree_skb(xchg(&u->skb_cache, NULL));
 
 	WARN_ON(atomic_read(&sk->sk_wmem_alloc));
 	WARN_ON(!sk_unhashed(sk));
@@ -539,6 +600,8 @@ static void unix_release_sock(struct sock *sk, int embrion)
 		unix_peer(sk) = NULL;
 	}
 
+	kfree_skb(xchg(&u->skb_cache, NULL));
+
 	/* Try to flush out this socket. Throw out buffers at least */
 
 	while ((skb = skb_dequeue(&sk->sk_receive_queue)) != NULL) {
@@ -1632,7 +1695,7 @@ static int unix_dgram_sendmsg(struct kiocb *kiocb, struct socket *sock,
 	if (len > sk->sk_sndbuf - 32)
 		goto out;
 
-	skb = sock_alloc_send_skb(sk, len, msg->msg_flags&MSG_DONTWAIT, &err);
+	skb = unix_alloc_send_skb(sk, len, msg->msg_flags&MSG_DONTWAIT, &err);
 	if (skb == NULL)
 		goto out;
 
@@ -1978,7 +2041,13 @@ static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 		goto out_unlock;
 	}
 
-	wake_up_interruptible_sync_poll(&u->peer_wait,
+	/*
+	 * Senders only wait for a full queue to drain, so only wake them
+	 * once it has room: a receiver emptying its queue in a batch, with
+	 * recvmmsg(), does not wake anyone for every message.
+	 */
+	if (!unix_recvq_full(sk) && wq_has_sleeper(&u->peer_wq))
+		wake_up_interruptible_sync_poll(&u->peer_wait,
 					POLLOUT | POLLWRNORM | POLLWRBAND);
 
 	if (msg->msg_name)
@@ -2032,7 +2101,8 @@ static int unix_dgram_recvmsg(struct kiocb *iocb, struct socket *sock,
 	scm_recv(sock, msg, siocb->scm, flags);
 
 out_free:
-	skb_free_datagram(sk, skb);
+	if (!unix_skb_cache_put(skb))
+		skb_free_datagram(sk, skb);
 out_unlock:
 	mutex_unlock(&u->readlock);
 out:
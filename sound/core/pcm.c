@@ -470,6 +470,66 @@ static void snd_pcm_substream_proc_status_read(struct snd_info_entry *entry,
 	mutex_unlock(&substream->pcm->open_mutex);
 }
 
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+static void snd_pcm_latency_hist_print(struct snd_info_buffer *buffer,
+				       const char *name, const char *unit,
+				       unsigned int *hist)
+{
+	int i;
+
+	snd_iprintf(buffer, "%s (%s, log2 buckets):\n", name, unit);
+	for (i = 0; i < SNDRV_PCM_LAT_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		if (i == SNDRV_PCM_LAT_BUCKETS - 1)
+			snd_iprintf(buffer, "  >= %-8lu: %u\n",
+				    1UL << (i - 1), hist[i]);
+		else
+			snd_iprintf(buffer, "  < %-9lu: %u\n",
+				    1UL << i, hist[i]);
+	}
+}
+
+static void snd_pcm_substream_proc_latency_read(struct snd_info_entry *entry,
+						struct snd_info_buffer *buffer)
+{
+	struct snd_pcm_substream *substream = entry->private_data;
+	struct snd_pcm_latency_stats *stats = &substream->lat_stats;
+	struct snd_pcm_runtime *runtime;
+
+	mutex_lock(&substream->pcm->open_mutex);
+	runtime = substream->runtime;
+	if (runtime)
+		snd_iprintf(buffer, "rate: %u period_size: %lu periods: %u\n",
+			    runtime->rate, runtime->period_size,
+			    runtime->periods);
+	mutex_unlock(&substream->pcm->open_mutex);
+
+	snd_iprintf(buffer, "period_irqs : %u\n", stats->periods);
+	snd_iprintf(buffer, "wakeups     : %u\n", stats->wakeups);
+	snd_iprintf(buffer, "xruns       : %u\n", stats->xruns);
+	snd_iprintf(buffer, "wakeup_max  : %lu us\n", stats->wakeup_max);
+	snd_iprintf(buffer, "jitter_max  : %lu frames\n", stats->jitter_max);
+	snd_iprintf(buffer, "update_max  : %lu ns\n", stats->update_max);
+	snd_pcm_latency_hist_print(buffer, "wakeup", "us", stats->wakeup_hist);
+	snd_pcm_latency_hist_print(buffer, "hw_ptr jitter", "frames",
+				   stats->jitter_hist);
+	snd_pcm_latency_hist_print(buffer, "hw_ptr update", "ns",
+				   stats->update_hist);
+}
+
+static void snd_pcm_substream_proc_latency_write(struct snd_info_entry *entry,
+						 struct snd_info_buffer *buffer)
+{
+	struct snd_pcm_substream *substream = entry->private_data;
+	char line[64];
+
+	if (!snd_info_get_line(buffer, line, sizeof(line)) &&
+	    !simple_strtoul(line, NULL, 10))
+		snd_pcm_latency_reset(substream);
+}
+#endif
+
 #ifdef CONFIG_SND_PCM_XRUN_DEBUG
 static void snd_pcm_xrun_debug_read(struct snd_info_entry *entry,
 				    struct snd_info_buffer *buffer)
@@ -602,6 +662,20 @@ static int snd_pcm_substream_proc_init(struct snd_pcm_substream *substream)
 	}
 	substream->proc_status_entry = entry;
 
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+	if ((entry = snd_info_create_card_entry(card, "latency", substream->proc_root)) != NULL) {
+		entry->c.text.read = snd_pcm_substream_proc_latency_read;
+		entry->c.text.write = snd_pcm_substream_proc_latency_write;
+		entry->mode |= S_IWUSR;
+		entry->private_data = substream;
+		if (snd_info_register(entry) < 0) {
+			snd_info_free_entry(entry);
+			entry = NULL;
+		}
+	}
+	substream->proc_latency_entry = entry;
+#endif
+
 	return 0;
 }
 
@@ -615,6 +689,10 @@ static int snd_pcm_substream_proc_done(struct snd_pcm_substream *substream)
 	substream->proc_sw_params_entry = NULL;
 	snd_info_free_entry(substream->proc_status_entry);
 	substream->proc_status_entry = NULL;
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+	snd_info_free_entry(substream->proc_latency_entry);
+	substream->proc_latency_entry = NULL;
+#endif
 	snd_info_free_entry(substream->proc_root);
 	substream->proc_root = NULL;
 	return 0;
@@ -1028,6 +1106,10 @@ int snd_pcm_attach_substream(struct snd_pcm *pcm, int stream,
 	substream->ref_count = 1;
 	substream->f_flags = file->f_flags;
 	substream->pid = get_pid(task_pid(current));
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+	/* a stale period timestamp would show up as a huge wakeup latency */
+	substream->lat_stats.wakeup_pending = 0;
+#endif
 	pstr->substream_opened++;
 	*rsubstream = substream;
 	return 0;
@@ -164,10 +164,95 @@ EXPORT_SYMBOL(snd_pcm_debug_name);
 			dump_stack();				\
 	} while (0)
 
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+/*
+ * Latency statistics; all updates are done under the stream lock.
+ * Bucket n of each histogram counts values in [2^(n-1), 2^n).
+ */
+static inline unsigned int snd_pcm_lat_bucket(unsigned long val)
+{
+	return min_t(unsigned int, fls_long(val), SNDRV_PCM_LAT_BUCKETS - 1);
+}
+
+/*
+ * Only a period interrupt that woke a task sleeping on the stream, in
+ * poll() or in a blocking read/write, starts a wakeup measurement.
+ */
+static void snd_pcm_latency_period(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct snd_pcm_latency_stats *stats = &substream->lat_stats;
+	snd_pcm_uframes_t avail;
+
+	stats->periods++;
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		avail = snd_pcm_playback_avail(runtime);
+	else
+		avail = snd_pcm_capture_avail(runtime);
+	stats->wakeup_pending = avail >= runtime->control->avail_min &&
+				(waitqueue_active(&runtime->sleep) ||
+				 waitqueue_active(&runtime->tsleep));
+	if (stats->wakeup_pending)
+		stats->period_tstamp = ktime_get();
+}
+
+static void snd_pcm_latency_jitter(struct snd_pcm_substream *substream,
+				   snd_pcm_uframes_t new_hw_ptr)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct snd_pcm_latency_stats *stats = &substream->lat_stats;
+	snd_pcm_sframes_t diff;
+
+	diff = new_hw_ptr - (runtime->hw_ptr_interrupt + runtime->period_size);
+	if (diff < -(snd_pcm_sframes_t)(runtime->boundary / 2))
+		diff += runtime->boundary;
+	else if (diff > (snd_pcm_sframes_t)(runtime->boundary / 2))
+		diff -= runtime->boundary;
+	if (diff < 0)
+		diff = -diff;
+	stats->jitter_hist[snd_pcm_lat_bucket(diff)]++;
+	if (diff > stats->jitter_max)
+		stats->jitter_max = diff;
+}
+
+/*
+ * Called when the application returns from a sleep on the stream;
+ * accounts the time elapsed since the period interrupt that woke it.
+ */
+void snd_pcm_latency_wakeup(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_latency_stats *stats = &substream->lat_stats;
+	unsigned long usecs;
+
+	if (!stats->wakeup_pending)
+		return;
+	stats->wakeup_pending = 0;
+	usecs = ktime_to_us(ktime_sub(ktime_get(), stats->period_tstamp));
+	stats->wakeup_hist[snd_pcm_lat_bucket(usecs)]++;
+	if (usecs > stats->wakeup_max)
+		stats->wakeup_max = usecs;
+	stats->wakeups++;
+}
+
+void snd_pcm_latency_reset(struct snd_pcm_substream *substream)
+{
+	snd_pcm_stream_lock_irq(substream);
+	memset(&substream->lat_stats, 0, sizeof(substream->lat_stats));
+	snd_pcm_stream_unlock_irq(substream);
+}
+
+#define snd_pcm_latency_xrun(substream)	((substream)->lat_stats.xruns++)
+#else
+#define snd_pcm_latency_period(substream)	do { } while (0)
+#define snd_pcm_latency_jitter(substream, ptr)	do { } while (0)
+#define snd_pcm_latency_xrun(substream)	do { } while (0)
+#endif
+
 static void xrun(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 
+	snd_pcm_latency_xrun(substream);
 	if (runtime->tstamp_mode == SNDRV_PCM_TSTAMP_ENABLE)
 		snd_pcm_gettime(runtime, (struct timespec *)&runtime->status->tstamp);
 	snd_pcm_stop(substream, SNDRV_PCM_STATE_XRUN);
@@ -306,8 +391,8 @@ int snd_pcm_update_state(struct snd_pcm_substream *substream,
 	return 0;
 }
 
-static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
-				  unsigned int in_interrupt)
+static int __snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
+				    unsigned int in_interrupt)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	snd_pcm_uframes_t pos;
@@ -366,6 +451,8 @@ static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
 	delta = new_hw_ptr - old_hw_ptr;
 	if (delta < 0)
 		delta += runtime->boundary;
+	if (in_interrupt)
+		snd_pcm_latency_jitter(substream, new_hw_ptr);
 	if (xrun_debug(substream, in_interrupt ?
 			XRUN_DEBUG_PERIODUPDATE : XRUN_DEBUG_HWPTRUPDATE)) {
 		char name[16];
@@ -500,6 +587,30 @@ static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
 	return snd_pcm_update_state(substream, runtime);
 }
 
+#ifdef CONFIG_SND_PCM_LATENCY_STATS
+static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
+				  unsigned int in_interrupt)
+{
+	struct snd_pcm_latency_stats *stats = &substream->lat_stats;
+	ktime_t start = ktime_get();
+	unsigned long nsecs;
+	int err;
+
+	err = __snd_pcm_update_hw_ptr0(substream, in_interrupt);
+	nsecs = ktime_to_ns(ktime_sub(ktime_get(), start));
+	stats->update_hist[snd_pcm_lat_bucket(nsecs)]++;
+	if (nsecs > stats->update_max)
+		stats->update_max = nsecs;
+	return err;
+}
+#else
+static inline int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
+					 unsigned int in_interrupt)
+{
+	return __snd_pcm_update_hw_ptr0(substream, in_interrupt);
+}
+#endif
+
 /* CAUTION: call it with irq disabled */
 int snd_pcm_update_hw_ptr(struct snd_pcm_substream *substream)
 {
@@ -1774,6 +1885,7 @@ void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
 	if (!snd_pcm_running(substream) ||
 	    snd_pcm_update_hw_ptr0(substream, 1) < 0)
 		goto _end;
+	snd_pcm_latency_period(substream);
 
 	if (substream->timer_running)
 		snd_timer_interrupt(substream->timer, 1);
@@ -1848,6 +1960,7 @@ static int wait_for_avail(struct snd_pcm_substream *substream,
 		tout = schedule_timeout(wait_time);
 
 		snd_pcm_stream_lock_irq(substream);
+		snd_pcm_latency_wakeup(substream);
 		set_current_state(TASK_INTERRUPTIBLE);
 		switch (runtime->status->state) {
 		case SNDRV_PCM_STATE_SUSPENDED:
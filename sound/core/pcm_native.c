@@ -3008,6 +3008,7 @@ static unsigned int snd_pcm_playback_poll(struct file *file, poll_table * wait)
 	case SNDRV_PCM_STATE_PREPARED:
 	case SNDRV_PCM_STATE_PAUSED:
 		if (avail >= runtime->control->avail_min) {
+			snd_pcm_latency_wakeup(substream);
 			mask = POLLOUT | POLLWRNORM;
 			break;
 		}
@@ -3047,6 +3048,7 @@ static unsigned int snd_pcm_capture_poll(struct file *file, poll_table * wait)
 	case SNDRV_PCM_STATE_PREPARED:
 	case SNDRV_PCM_STATE_PAUSED:
 		if (avail >= runtime->control->avail_min) {
+			snd_pcm_latency_wakeup(substream);
 			mask = POLLIN | POLLRDNORM;
 			break;
 		}
@@ -3,8 +3,25 @@
 
 extern int bench_sched_messaging(int argc, const char **argv, const char *prefix);
 extern int bench_sched_pipe(int argc, const char **argv, const char *prefix);
+extern int bench_sched_deadline(int argc, const char **argv,
+				const char *prefix);
+extern int bench_sched_binder(int argc, const char **argv, const char *prefix);
+extern int bench_sched_freezer(int argc, const char **argv, const char *prefix);
+extern int bench_sched_unix(int argc, const char **argv, const char *prefix);
 extern int bench_mem_memcpy(int argc, const char **argv, const char *prefix __used);
 extern int bench_mem_memset(int argc, const char **argv, const char *prefix);
+extern int bench_mem_madvise(int argc, const char **argv, const char *prefix);
+extern int bench_mem_footprint(int argc, const char **argv,
+			       const char *prefix);
+extern int bench_mem_fault(int argc, const char **argv, const char *prefix);
+extern int bench_mem_charge(int argc, const char **argv, const char *prefix);
+extern int bench_fs_inotify(int argc, const char **argv, const char *prefix);
+extern int bench_fs_aio(int argc, const char **argv, const char *prefix);
+extern int bench_sound_pcm(int argc, const char **argv, const char *prefix);
+extern int bench_futex_hash(int argc, const char **argv, const char *prefix);
+extern int bench_futex_wake(int argc, const char **argv, const char *prefix);
+extern int bench_futex_wait_multiple(int argc, const char **argv,
+				     const char *prefix);
 
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
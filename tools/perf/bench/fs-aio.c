@@ -0,0 +1,256 @@
+/*
+ * fs-aio.c
+ *
+ * aio: Native aio on buffered files, the way fio's libaio engine does it
+ *
+ * Random reads of a file whose data is cached, random reads of a file
+ * whose data is not, and random writes each followed by an fdatasync,
+ * all of them with a number of requests in flight through io_submit().
+ * Without O_DIRECT these used to block in io_submit() until done; the
+ * time spent there tells whether the kernel ran them in the background.
+ * Point -d at directories on ext4 and f2fs loop devices to compare them.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <linux/aio_abi.h>
+
+static const char	*dir		= ".";
+static unsigned int	size_mb		= 64;
+static unsigned int	block_size	= 4096;
+static unsigned int	depth		= 32;
+static unsigned int	nr_ios		= 16384;
+
+static const struct option options[] = {
+	OPT_STRING('d', "directory", &dir, "path",
+		   "Specify directory of the test file"),
+	OPT_UINTEGER('s', "size", &size_mb,
+		     "Specify size of the test file in MB"),
+	OPT_UINTEGER('b', "block", &block_size,
+		     "Specify size of each i/o in bytes"),
+	OPT_UINTEGER('q', "depth", &depth,
+		     "Specify number of i/os in flight"),
+	OPT_UINTEGER('n', "ios", &nr_ios,
+		     "Specify number of i/os"),
+	OPT_END()
+};
+
+static const char * const bench_fs_aio_usage[] = {
+	"perf bench fs aio <options>",
+	NULL
+};
+
+enum {
+	MODE_READ_CACHED,
+	MODE_READ_COLD,
+	MODE_WRITE_SYNC,
+	NR_MODES,
+};
+
+static const char * const mode_names[] = {
+	"randread cached",
+	"randread cold",
+	"randwrite+sync",
+};
+
+struct result {
+	double secs;
+	double submit;		/* spent in io_submit() [sec] */
+	bool unsupported;
+};
+
+static double now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* returns false if the kernel refuses the opcode */
+static bool submit_wait(aio_context_t ctx, struct iocb **cbp, long nr,
+			struct io_event *evs, struct result *r)
+{
+	long got = 0, i, n;
+	double start;
+
+	start = now();
+	n = syscall(__NR_io_submit, ctx, nr, cbp);
+	r->submit += now() - start;
+	if (n != nr) {
+		if (n < 0 && errno == EINVAL)
+			return false;
+		die("io_submit");
+	}
+
+	while (got < nr) {
+		n = syscall(__NR_io_getevents, ctx, 1, nr - got, evs, NULL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			die("io_getevents");
+		}
+		for (i = 0; i < n; i++)
+			if ((long long)evs[i].res < 0) {
+				errno = -(long long)evs[i].res;
+				die("aio");
+			}
+		got += n;
+	}
+	return true;
+}
+
+static void prepare(int fd, int mode, char *buf)
+{
+	unsigned long long off, size = (unsigned long long)size_mb << 20;
+
+	switch (mode) {
+	case MODE_READ_CACHED:
+		for (off = 0; off < size; off += block_size)
+			if (pread(fd, buf, block_size, off) < 0)
+				die("pread");
+		break;
+	case MODE_READ_COLD:
+		if (fsync(fd) ||
+		    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED))
+			die("drop cache");
+		break;
+	default:
+		break;
+	}
+}
+
+static void run(int fd, int mode, struct result *r)
+{
+	unsigned long long blocks;
+	unsigned int done, i, n;
+	aio_context_t ctx = 0;
+	struct io_event *evs;
+	struct iocb *cbs, **cbp, sync_cb, *sync_cbp = &sync_cb;
+	char *bufs;
+	double start;
+
+	memset(r, 0, sizeof(*r));
+	blocks = ((unsigned long long)size_mb << 20) / block_size;
+
+	cbs = calloc(depth, sizeof(*cbs));
+	cbp = calloc(depth, sizeof(*cbp));
+	evs = calloc(depth, sizeof(*evs));
+	if (!cbs || !cbp || !evs ||
+	    posix_memalign((void **)&bufs, block_size,
+			   (size_t)depth * block_size))
+		die("calloc");
+	memset(bufs, 0x5a, (size_t)depth * block_size);
+
+	prepare(fd, mode, bufs);
+	if (syscall(__NR_io_setup, depth + 1, &ctx))
+		die("io_setup");
+	srand(1);
+
+	memset(&sync_cb, 0, sizeof(sync_cb));
+	sync_cb.aio_fildes = fd;
+	sync_cb.aio_lio_opcode = IOCB_CMD_FDSYNC;
+
+	start = now();
+	for (done = 0; done < nr_ios; done += n) {
+		n = min(depth, nr_ios - done);
+		for (i = 0; i < n; i++) {
+			memset(&cbs[i], 0, sizeof(cbs[i]));
+			cbs[i].aio_fildes = fd;
+			cbs[i].aio_lio_opcode = mode == MODE_WRITE_SYNC ?
+						IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+			cbs[i].aio_buf = (unsigned long)(bufs + i * block_size);
+			cbs[i].aio_nbytes = block_size;
+			cbs[i].aio_offset = (rand() % blocks) * block_size;
+			cbp[i] = &cbs[i];
+		}
+		if (!submit_wait(ctx, cbp, n, evs, r))
+			die("io_submit");
+		if (mode == MODE_WRITE_SYNC &&
+		    !submit_wait(ctx, &sync_cbp, 1, evs, r)) {
+			r->unsupported = true;
+			break;
+		}
+	}
+	r->secs = now() - start;
+
+	syscall(__NR_io_destroy, ctx);
+	free(bufs);
+	free(evs);
+	free(cbp);
+	free(cbs);
+}
+
+int bench_fs_aio(int argc, const char **argv, const char *prefix __used)
+{
+	unsigned long long off, size;
+	struct result r;
+	char path[PATH_MAX];
+	char *buf;
+	int fd, mode;
+
+	argc = parse_options(argc, argv, options, bench_fs_aio_usage, 0);
+	size = (unsigned long long)size_mb << 20;
+	if (!depth || !nr_ios || !block_size || size < block_size)
+		usage_with_options(bench_fs_aio_usage, options);
+
+	snprintf(path, sizeof(path), "%s/perf-bench-aio-%d", dir, getpid());
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0)
+		die("open");
+
+	buf = malloc(1 << 20);
+	if (!buf)
+		die("malloc");
+	memset(buf, 0xa5, 1 << 20);
+	for (off = 0; off < size; off += 1 << 20)
+		if (pwrite(fd, buf, min(size - off, 1ULL << 20), off) < 0)
+			die("pwrite");
+	free(buf);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u i/os of %u bytes, %u in flight, on a %u MB file "
+		       "in %s\n\n", nr_ios, block_size, depth, size_mb, dir);
+
+	for (mode = 0; mode < NR_MODES; mode++) {
+		run(fd, mode, &r);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			if (r.unsupported) {
+				printf(" %16s: fdatasync not supported\n",
+				       mode_names[mode]);
+				break;
+			}
+			printf(" %16s: %.3lf sec, %.0lf iops, "
+			       "%.3lf usecs in io_submit per i/o\n",
+			       mode_names[mode], r.secs, nr_ios / r.secs,
+			       r.submit * 1e6 / nr_ios);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("\"%s\" %lf %lf\n", mode_names[mode], r.secs,
+			       r.unsupported ? 0 : r.submit);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	close(fd);
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * fs-inotify.c
+ *
+ * inotify: Cost of watching a file flooded with writes
+ *
+ * A writer thread issues many small writes to a file while a listener
+ * thread watches it for IN_MODIFY, like a media scanner or file observer
+ * watching a download. The listener's cpu time and the number of read()
+ * calls it needed tell how often it was woken for events, with and
+ * without IN_COALESCE on the watch.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#ifndef IN_COALESCE
+#define IN_COALESCE	0x08000000
+#endif
+
+static const char	*dir		= ".";
+static unsigned int	nr_writes	= 100000;
+static unsigned int	write_size	= 512;
+
+static const struct option options[] = {
+	OPT_STRING('d', "directory", &dir, "path",
+		   "Specify directory of the flooded file"),
+	OPT_UINTEGER('n', "writes", &nr_writes,
+		     "Specify number of writes"),
+	OPT_UINTEGER('s', "size", &write_size,
+		     "Specify size of each write in bytes"),
+	OPT_END()
+};
+
+static const char * const bench_fs_inotify_usage[] = {
+	"perf bench fs inotify <options>",
+	NULL
+};
+
+struct listener {
+	int fd;
+	unsigned long long reads;
+	unsigned long long events;
+	double cpu;		/* user + system [sec] */
+};
+
+static double timeval_secs(struct timeval *tv)
+{
+	return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static void *listener_fn(void *arg)
+{
+	struct listener *l = arg;
+	struct inotify_event *ev;
+	struct rusage ru;
+	char buf[16384];
+	bool done = false;
+	ssize_t len, off;
+
+	while (!done) {
+		len = read(l->fd, buf, sizeof(buf));
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			die("read inotify");
+		}
+		l->reads++;
+		for (off = 0; off < len; off += sizeof(*ev) + ev->len) {
+			ev = (struct inotify_event *)(buf + off);
+			l->events++;
+			if (ev->mask & IN_CLOSE_WRITE)
+				done = true;
+		}
+	}
+
+	getrusage(RUSAGE_THREAD, &ru);
+	l->cpu = timeval_secs(&ru.ru_utime) + timeval_secs(&ru.ru_stime);
+	return NULL;
+}
+
+static void run(const char *path, u_int32_t flags, struct listener *l,
+		double *secs)
+{
+	struct timeval start, end, diff;
+	pthread_t thread;
+	unsigned int i;
+	char *buf;
+	int fd;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0)
+		die("open");
+
+	memset(l, 0, sizeof(*l));
+	l->fd = inotify_init();
+	if (l->fd < 0)
+		die("inotify_init");
+	if (inotify_add_watch(l->fd, path,
+			      IN_MODIFY | IN_CLOSE_WRITE | flags) < 0)
+		die("inotify_add_watch");
+	if (pthread_create(&thread, NULL, listener_fn, l))
+		die("pthread_create");
+
+	buf = calloc(1, write_size);
+	if (!buf)
+		die("calloc");
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < nr_writes; i++)
+		if (pwrite(fd, buf, write_size, 0) < 0)
+			die("pwrite");
+	close(fd);
+	pthread_join(thread, NULL);
+	gettimeofday(&end, NULL);
+
+	timersub(&end, &start, &diff);
+	*secs = timeval_secs(&diff);
+
+	close(l->fd);
+	free(buf);
+}
+
+int bench_fs_inotify(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	static const struct {
+		const char *name;
+		u_int32_t flags;
+	} modes[] = {
+		{ "normal", 0 },
+		{ "coalesce", IN_COALESCE },
+	};
+	struct listener l;
+	char path[PATH_MAX];
+	unsigned int i;
+	double secs;
+
+	argc = parse_options(argc, argv, options, bench_fs_inotify_usage, 0);
+	if (!nr_writes || !write_size)
+		usage_with_options(bench_fs_inotify_usage, options);
+
+	snprintf(path, sizeof(path), "%s/perf-bench-inotify-%d", dir,
+		 getpid());
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u writes of %u bytes to a watched file\n\n",
+		       nr_writes, write_size);
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++) {
+		run(path, modes[i].flags, &l, &secs);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %8s: %.3lf sec, listener %.3lf cpu sec, "
+			       "%llu reads, %llu events\n", modes[i].name,
+			       secs, l.cpu, l.reads, l.events);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf %lf %llu\n", modes[i].name, secs,
+			       l.cpu, l.reads);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ *
+ * futex-hash.c
+ *
+ * hash: Benchmark for futex hash bucket contention
+ *
+ * Every thread issues FUTEX_WAKE on futexes of its own which have no
+ * waiters, so that only the hashing and the bucket locks are measured.
+ * Run it next to another busy process to see the collisions in the
+ * global hash, and with --slots to compare with a private hash.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+static unsigned int nthreads;
+static unsigned int nfutexes = 1024;
+static unsigned int nsecs = 10;
+static unsigned int slots;
+static bool fshared = false;
+
+static volatile int done;
+static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct worker {
+	pthread_t thread;
+	u_int32_t *futex;
+	unsigned long ops;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify amount of threads (default: online cpus)"),
+	OPT_UINTEGER('f', "futexes", &nfutexes,
+		     "Specify amount of futexes per thread"),
+	OPT_UINTEGER('r', "runtime", &nsecs,
+		     "Specify runtime (in seconds)"),
+	OPT_UINTEGER('H', "slots", &slots,
+		     "Use a private futex hash of this many slots"),
+	OPT_BOOLEAN('S', "shared", &fshared,
+		    "Use shared futexes instead of private ones"),
+	OPT_END()
+};
+
+static const char * const bench_futex_hash_usage[] = {
+	"perf bench futex hash <options>",
+	NULL
+};
+
+static void *worker_fn(void *arg)
+{
+	struct worker *w = arg;
+	int opflags = fshared ? 0 : FUTEX_PRIVATE_FLAG;
+	unsigned int i;
+
+	/* wait for all threads to be created */
+	pthread_mutex_lock(&start_mutex);
+	pthread_mutex_unlock(&start_mutex);
+
+	while (!done) {
+		for (i = 0; i < nfutexes; i++)
+			futex_wake(&w->futex[i], 1, opflags);
+		w->ops += nfutexes;
+	}
+
+	return NULL;
+}
+
+static void alarm_handler(int sig __used)
+{
+	done = 1;
+}
+
+int bench_futex_hash(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	struct worker *workers;
+	struct timeval start, stop, diff;
+	unsigned long long total = 0;
+	double secs;
+	unsigned int i;
+	int hash_slots;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_hash_usage, 0);
+
+	if (!nthreads)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!nfutexes)
+		nfutexes = 1;
+
+	hash_slots = futex_set_private_hash(slots);
+	if (hash_slots < 0 && slots) {
+		fprintf(stderr, "Cannot set up a private futex hash: %s\n",
+			strerror(errno));
+		exit(1);
+	}
+
+	workers = calloc(nthreads, sizeof(*workers));
+	if (!workers)
+		die("calloc");
+
+	signal(SIGALRM, alarm_handler);
+
+	pthread_mutex_lock(&start_mutex);
+	for (i = 0; i < nthreads; i++) {
+		workers[i].futex = calloc(nfutexes, sizeof(u_int32_t));
+		if (!workers[i].futex)
+			die("calloc");
+		if (pthread_create(&workers[i].thread, NULL, worker_fn,
+				   &workers[i]))
+			die("pthread_create");
+	}
+
+	gettimeofday(&start, NULL);
+	alarm(nsecs);
+	pthread_mutex_unlock(&start_mutex);
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		total += workers[i].ops;
+	}
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+	secs = diff.tv_sec + (double)diff.tv_usec / 1000000;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u threads operating on %u %s futexes each, "
+		       "%s hash", nthreads, nfutexes,
+		       fshared ? "shared" : "private",
+		       hash_slots > 0 ? "private" : "global");
+		if (hash_slots > 0)
+			printf(" of %d slots", hash_slots);
+		printf("\n\n");
+
+		for (i = 0; i < nthreads; i++)
+			printf(" thread %3u: %14.0f ops/sec\n", i,
+			       workers[i].ops / secs);
+		printf("\n %14.0f ops/sec in total\n", total / secs);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.0f\n", total / secs);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	for (i = 0; i < nthreads; i++)
+		free(workers[i].futex);
+	free(workers);
+
+	return 0;
+}
@@ -0,0 +1,247 @@
+/*
+ *
+ * futex-wait-multiple.c
+ *
+ * wait-multiple: Benchmark for waiting on any of several events
+ *
+ * A waiter thread sleeps on a set of events and a waker thread signals
+ * one of them at a time, waiting for the waiter to acknowledge it before
+ * signalling the next. The events are either futexes waited on with
+ * FUTEX_WAIT_MULTIPLE or eventfds waited on with epoll.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+static unsigned int nevents = 16;
+static unsigned int loops = 100000;
+static bool use_epoll = false;
+
+static u_int32_t *events;
+static int *efds;
+static int epfd;
+/* number of events handled by the waiter */
+static u_int32_t acked;
+
+static const struct option options[] = {
+	OPT_UINTEGER('e', "events", &nevents,
+		     "Specify number of events to wait on"),
+	OPT_UINTEGER('l', "loop", &loops,
+		     "Specify number of events to signal"),
+	OPT_BOOLEAN('E', "epoll", &use_epoll,
+		    "Use eventfds and epoll instead of FUTEX_WAIT_MULTIPLE"),
+	OPT_END()
+};
+
+static const char * const bench_futex_wait_multiple_usage[] = {
+	"perf bench futex wait-multiple <options>",
+	NULL
+};
+
+static void ack(void)
+{
+	__sync_fetch_and_add(&acked, 1);
+	futex_wake(&acked, 1, FUTEX_PRIVATE_FLAG);
+}
+
+static void wait_ack(u_int32_t count)
+{
+	u_int32_t cur;
+
+	while ((cur = __sync_fetch_and_add(&acked, 0)) != count)
+		futex_wait(&acked, cur, FUTEX_PRIVATE_FLAG);
+}
+
+static void *futex_waiter(void *arg __used)
+{
+	struct futex_wait_block *blocks;
+	unsigned int i, handled = 0;
+
+	blocks = calloc(nevents, sizeof(*blocks));
+	if (!blocks)
+		die("calloc");
+	for (i = 0; i < nevents; i++) {
+		blocks[i].uaddr = &events[i];
+		blocks[i].val = 0;
+		blocks[i].bitset = FUTEX_BITSET_MATCH_ANY;
+	}
+
+	while (handled < loops) {
+		if (futex_wait_multiple(blocks, nevents,
+					FUTEX_PRIVATE_FLAG) < 0 &&
+		    errno != EWOULDBLOCK && errno != EAGAIN &&
+		    errno != EINTR)
+			die("FUTEX_WAIT_MULTIPLE: %s", strerror(errno));
+
+		for (i = 0; i < nevents; i++) {
+			if (__sync_lock_test_and_set(&events[i], 0)) {
+				handled++;
+				ack();
+			}
+		}
+	}
+
+	free(blocks);
+	return NULL;
+}
+
+static void *epoll_waiter(void *arg __used)
+{
+	struct epoll_event ev[8];
+	unsigned int handled = 0;
+	u_int64_t cnt;
+	int i, n;
+
+	while (handled < loops) {
+		n = epoll_wait(epfd, ev, 8, -1);
+		if (n < 0 && errno != EINTR)
+			die("epoll_wait: %s", strerror(errno));
+
+		for (i = 0; i < n; i++) {
+			if (read(efds[ev[i].data.u32], &cnt, sizeof(cnt)) < 0)
+				continue;
+			handled++;
+			ack();
+		}
+	}
+
+	return NULL;
+}
+
+static void signal_event(unsigned int i)
+{
+	u_int64_t one = 1;
+
+	if (use_epoll) {
+		if (write(efds[i], &one, sizeof(one)) < 0)
+			die("write: %s", strerror(errno));
+	} else {
+		__sync_lock_test_and_set(&events[i], 1);
+		futex_wake(&events[i], 1, FUTEX_PRIVATE_FLAG);
+	}
+}
+
+static void setup_epoll(void)
+{
+	struct epoll_event ev;
+	unsigned int i;
+
+	epfd = epoll_create1(0);
+	if (epfd < 0)
+		die("epoll_create1: %s", strerror(errno));
+
+	efds = calloc(nevents, sizeof(*efds));
+	if (!efds)
+		die("calloc");
+	for (i = 0; i < nevents; i++) {
+		efds[i] = eventfd(0, 0);
+		if (efds[i] < 0)
+			die("eventfd: %s", strerror(errno));
+		ev.events = EPOLLIN;
+		ev.data.u32 = i;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, efds[i], &ev))
+			die("epoll_ctl: %s", strerror(errno));
+	}
+}
+
+int bench_futex_wait_multiple(int argc, const char **argv,
+			      const char *prefix __used)
+{
+	struct timeval start, stop, diff;
+	unsigned long long result_usec;
+	pthread_t waiter;
+	unsigned int i;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_wait_multiple_usage, 0);
+
+	if (!nevents)
+		nevents = 1;
+
+	if (use_epoll) {
+		setup_epoll();
+	} else {
+		if (nevents > 128) {
+			fprintf(stderr, "FUTEX_WAIT_MULTIPLE takes at most "
+				"128 futexes\n");
+			exit(1);
+		}
+		events = calloc(nevents, sizeof(*events));
+		if (!events)
+			die("calloc");
+	}
+
+	if (pthread_create(&waiter, NULL,
+			   use_epoll ? epoll_waiter : futex_waiter, NULL))
+		die("pthread_create");
+
+	gettimeofday(&start, NULL);
+
+	for (i = 0; i < loops; i++) {
+		signal_event(i % nevents);
+		wait_ack(i + 1);
+	}
+
+	pthread_join(waiter, NULL);
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+
+	result_usec = diff.tv_sec * 1000000;
+	result_usec += diff.tv_usec;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u events signalled out of %u, waited on with %s\n\n",
+		       loops, nevents,
+		       use_epoll ? "eventfd and epoll" : "FUTEX_WAIT_MULTIPLE");
+
+		printf(" %14s: %lu.%03lu [sec]\n\n", "Total time",
+		       diff.tv_sec,
+		       (unsigned long) (diff.tv_usec/1000));
+
+		printf(" %14lf usecs/op\n",
+		       (double)result_usec / (double)loops);
+		printf(" %14d ops/sec\n",
+		       (int)((double)loops /
+			     ((double)result_usec / (double)1000000)));
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%lu.%03lu\n",
+		       diff.tv_sec,
+		       (unsigned long) (diff.tv_usec / 1000));
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	if (use_epoll) {
+		for (i = 0; i < nevents; i++)
+			close(efds[i]);
+		close(epfd);
+		free(efds);
+	} else {
+		free(events);
+	}
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ *
+ * futex-wake.c
+ *
+ * wake: Benchmark for futex wait/wake throughput
+ *
+ * Pairs of threads hand a token back and forth through a futex of
+ * their own, each hand-off being a FUTEX_WAKE answered by a FUTEX_WAIT
+ * returning, so that every pair hits the hash on both sides.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+#include "futex.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+static unsigned int npairs;
+static unsigned int loops = 100000;
+static unsigned int slots;
+static bool fshared = false;
+
+struct pair {
+	pthread_t thread[2];
+	/* whose turn it is, 0 or 1 */
+	u_int32_t turn __attribute__((aligned(64)));
+};
+
+struct side {
+	struct pair *pair;
+	u_int32_t me;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('p', "pairs", &npairs,
+		     "Specify amount of thread pairs (default: online cpus / 2)"),
+	OPT_UINTEGER('l', "loop", &loops,
+		     "Specify number of hand-offs per pair"),
+	OPT_UINTEGER('H', "slots", &slots,
+		     "Use a private futex hash of this many slots"),
+	OPT_BOOLEAN('S', "shared", &fshared,
+		    "Use shared futexes instead of private ones"),
+	OPT_END()
+};
+
+static const char * const bench_futex_wake_usage[] = {
+	"perf bench futex wake <options>",
+	NULL
+};
+
+static void *side_fn(void *arg)
+{
+	struct side *s = arg;
+	u_int32_t *turn = &s->pair->turn;
+	int opflags = fshared ? 0 : FUTEX_PRIVATE_FLAG;
+	unsigned int i;
+
+	for (i = 0; i < loops; i++) {
+		while (__sync_fetch_and_add(turn, 0) != s->me)
+			futex_wait(turn, !s->me, opflags);
+		__sync_lock_test_and_set(turn, !s->me);
+		futex_wake(turn, 1, opflags);
+	}
+
+	return NULL;
+}
+
+int bench_futex_wake(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	struct pair *pairs;
+	struct side *sides;
+	struct timeval start, stop, diff;
+	unsigned long long result_usec, ops;
+	unsigned int i, j;
+	int hash_slots;
+
+	argc = parse_options(argc, argv, options,
+			     bench_futex_wake_usage, 0);
+
+	if (!npairs)
+		npairs = sysconf(_SC_NPROCESSORS_ONLN) / 2;
+	if (!npairs)
+		npairs = 1;
+
+	hash_slots = futex_set_private_hash(slots);
+	if (hash_slots < 0 && slots) {
+		fprintf(stderr, "Cannot set up a private futex hash: %s\n",
+			strerror(errno));
+		exit(1);
+	}
+
+	if (posix_memalign((void **)&pairs, 64, npairs * sizeof(*pairs)))
+		die("posix_memalign");
+	memset(pairs, 0, npairs * sizeof(*pairs));
+	sides = calloc(npairs * 2, sizeof(*sides));
+	if (!sides)
+		die("calloc");
+
+	gettimeofday(&start, NULL);
+
+	for (i = 0; i < npairs; i++) {
+		for (j = 0; j < 2; j++) {
+			sides[2 * i + j].pair = &pairs[i];
+			sides[2 * i + j].me = j;
+			if (pthread_create(&pairs[i].thread[j], NULL, side_fn,
+					   &sides[2 * i + j]))
+				die("pthread_create");
+		}
+	}
+
+	for (i = 0; i < npairs; i++)
+		for (j = 0; j < 2; j++)
+			pthread_join(pairs[i].thread[j], NULL);
+
+	gettimeofday(&stop, NULL);
+	timersub(&stop, &start, &diff);
+
+	result_usec = diff.tv_sec * 1000000;
+	result_usec += diff.tv_usec;
+	ops = (unsigned long long)npairs * loops * 2;
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u thread pairs doing %u hand-offs each "
+		       "through %s futexes, %s hash", npairs, loops,
+		       fshared ? "shared" : "private",
+		       hash_slots > 0 ? "private" : "global");
+		if (hash_slots > 0)
+			printf(" of %d slots", hash_slots);
+		printf("\n\n");
+
+		printf(" %14s: %lu.%03lu [sec]\n\n", "Total time",
+		       diff.tv_sec,
+		       (unsigned long) (diff.tv_usec/1000));
+
+		printf(" %14lf usecs/op\n",
+		       (double)result_usec / (double)ops);
+		printf(" %14d ops/sec\n",
+		       (int)((double)ops /
+			     ((double)result_usec / (double)1000000)));
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%lu.%03lu\n",
+		       diff.tv_sec,
+		       (unsigned long) (diff.tv_usec / 1000));
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(sides);
+	free(pairs);
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ *
+ * futex.h
+ *
+ * Glue between the futex benchmarks and the futex syscall
+ *
+ */
+
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/prctl.h>
+#include <linux/futex.h>
+
+#ifndef PR_FUTEX_HASH
+#define PR_FUTEX_HASH			78
+# define PR_FUTEX_HASH_SET_SLOTS	1
+# define PR_FUTEX_HASH_GET_SLOTS	2
+#endif
+
+#ifndef FUTEX_WAIT_MULTIPLE
+#define FUTEX_WAIT_MULTIPLE		31
+
+struct futex_wait_block {
+	u_int32_t *uaddr;
+	u_int32_t val;
+	u_int32_t bitset;
+};
+#endif
+
+static inline int
+futex_syscall(u_int32_t *uaddr, int op, u_int32_t val,
+	      struct timespec *timeout, u_int32_t *uaddr2, int val3)
+{
+	return syscall(__NR_futex, uaddr, op, val, timeout, uaddr2, val3);
+}
+
+static inline int
+futex_wait(u_int32_t *uaddr, u_int32_t val, int opflags)
+{
+	return futex_syscall(uaddr, FUTEX_WAIT | opflags, val, NULL, NULL, 0);
+}
+
+static inline int
+futex_wake(u_int32_t *uaddr, int nr_wake, int opflags)
+{
+	return futex_syscall(uaddr, FUTEX_WAKE | opflags, nr_wake,
+			     NULL, NULL, 0);
+}
+
+/* Returns the index of the woken futex */
+static inline int
+futex_wait_multiple(struct futex_wait_block *blocks, int count, int opflags)
+{
+	return futex_syscall((u_int32_t *)blocks, FUTEX_WAIT_MULTIPLE | opflags,
+			     count, NULL, NULL, 0);
+}
+
+/*
+ * Give the process a private futex hash of @slots buckets, which has to
+ * happen before any thread is created. Returns the resulting number of
+ * slots, 0 when the global hash is used.
+ */
+static inline int futex_set_private_hash(unsigned int slots)
+{
+	if (slots && prctl(PR_FUTEX_HASH, PR_FUTEX_HASH_SET_SLOTS,
+			   slots, 0, 0) < 0)
+		return -1;
+	return prctl(PR_FUTEX_HASH, PR_FUTEX_HASH_GET_SLOTS, 0, 0, 0);
+}
+
+#endif /* _FUTEX_H */
@@ -0,0 +1,209 @@
+/*
+ * mem-charge.c
+ *
+ * charge: Page fault throughput of processes in many memory cgroups
+ *
+ * Forks a number of processes which map anonymous memory, fault it in and
+ * unmap it again, all on the same cpu, the way apps interleave on a phone.
+ * Every new page is charged to the memory cgroup of its process, and
+ * uncharged when it is unmapped. This is run once with all processes in
+ * the current cgroup, and once with every process in a memory cgroup of
+ * its own, created below the given memory cgroup mount point, so that
+ * the cost of switching between groups in the charge path is shown.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static unsigned int	nr_procs	= 8;
+static unsigned int	size_kb		= 1024;
+static unsigned int	loops		= 1000;
+static unsigned int	cpu;
+static const char	*memcg_root	= "/dev/memcg";
+
+static const struct option options[] = {
+	OPT_UINTEGER('p', "procs", &nr_procs,
+		     "Specify number of processes"),
+	OPT_UINTEGER('s', "size", &size_kb,
+		     "Specify size faulted in by each process per loop in kB"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of loops of each process"),
+	OPT_UINTEGER('C', "cpu", &cpu,
+		     "Specify cpu all processes run on"),
+	OPT_STRING('m', "memcg", &memcg_root, "path",
+		   "Specify mount point of the memory cgroup hierarchy"),
+	OPT_END()
+};
+
+static const char * const bench_mem_charge_usage[] = {
+	"perf bench mem charge <options>",
+	NULL
+};
+
+static void memcg_path(char *buf, size_t len, unsigned int i)
+{
+	snprintf(buf, len, "%s/perf-bench-charge-%u", memcg_root, i);
+}
+
+/* moves the calling process into a new memory cgroup of its own */
+static void memcg_enter(unsigned int i)
+{
+	char path[PATH_MAX], pid[16];
+	int fd, len;
+
+	memcg_path(path, sizeof(path), i);
+	if (mkdir(path, 0700) && errno != EEXIST)
+		die("mkdir %s", path);
+	strncat(path, "/tasks", sizeof(path) - strlen(path) - 1);
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		die("open %s", path);
+	len = snprintf(pid, sizeof(pid), "%d", getpid());
+	if (write(fd, pid, len) != len)
+		die("write %s", path);
+	close(fd);
+}
+
+static void child(int ready, int start, unsigned int i, bool own_memcg)
+{
+	size_t size = (size_t)size_kb << 10;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	cpu_set_t mask;
+	unsigned int l;
+	size_t off;
+	char *p, c;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	if (sched_setaffinity(0, sizeof(mask), &mask))
+		die("sched_setaffinity");
+	if (own_memcg)
+		memcg_enter(i);
+
+	/* ready, then start together when the parent closes the pipe */
+	if (write(ready, "", 1) != 1)
+		die("write");
+	if (read(start, &c, 1) < 0)
+		die("read");
+
+	for (l = 0; l < loops; l++) {
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			die("mmap");
+		for (off = 0; off < size; off += page_size)
+			p[off] = 1;
+		munmap(p, size);
+	}
+	exit(0);
+}
+
+static double run(bool own_memcg)
+{
+	struct timeval start, end, diff;
+	char path[PATH_MAX];
+	unsigned int i;
+	pid_t *pids;
+	int ready[2], start_fds[2];
+	char c;
+
+	pids = calloc(nr_procs, sizeof(*pids));
+	if (!pids)
+		die("calloc");
+	if (pipe(ready) || pipe(start_fds))
+		die("pipe");
+
+	for (i = 0; i < nr_procs; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0)
+			die("fork");
+		if (!pids[i]) {
+			close(start_fds[1]);
+			child(ready[1], start_fds[0], i, own_memcg);
+		}
+	}
+	close(start_fds[0]);
+	for (i = 0; i < nr_procs; i++)
+		if (read(ready[0], &c, 1) != 1)
+			die("read");
+
+	gettimeofday(&start, NULL);
+	close(start_fds[1]);
+	for (i = 0; i < nr_procs; i++)
+		waitpid(pids[i], NULL, 0);
+	gettimeofday(&end, NULL);
+
+	close(ready[0]);
+	close(ready[1]);
+	if (own_memcg) {
+		for (i = 0; i < nr_procs; i++) {
+			memcg_path(path, sizeof(path), i);
+			rmdir(path);
+		}
+	}
+	free(pids);
+
+	timersub(&end, &start, &diff);
+	return diff.tv_sec + diff.tv_usec / 1e6;
+}
+
+int bench_mem_charge(int argc, const char **argv, const char *prefix __used)
+{
+	static const char * const modes[] = { "shared", "per-proc" };
+	unsigned long long faults;
+	struct stat st;
+	double secs;
+	int mode, nr_modes = 2;
+
+	argc = parse_options(argc, argv, options, bench_mem_charge_usage, 0);
+	if (!nr_procs || !size_kb || !loops)
+		usage_with_options(bench_mem_charge_usage, options);
+
+	if (stat(memcg_root, &st) || !S_ISDIR(st.st_mode)) {
+		fprintf(stderr, "No memory cgroups at %s, "
+			"running in the current cgroup only\n", memcg_root);
+		nr_modes = 1;
+	}
+
+	faults = (unsigned long long)nr_procs * loops *
+		 (((size_t)size_kb << 10) / sysconf(_SC_PAGESIZE));
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u processes on cpu %u faulting %u kB %u times "
+		       "each\n\n", nr_procs, cpu, size_kb, loops);
+
+	for (mode = 0; mode < nr_modes; mode++) {
+		secs = run(mode);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %8s memcg: %.3lf sec, %.0lf faults/sec\n",
+			       modes[mode], secs, faults / secs);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf\n", modes[mode], secs);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	return 0;
+}
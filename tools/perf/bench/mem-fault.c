@@ -0,0 +1,246 @@
+/*
+ * mem-fault.c
+ *
+ * fault: Page fault throughput next to threads changing the address space
+ *
+ * Every thread maps a region of its own, touches each of its pages and
+ * unmaps it again, on private anonymous memory (write faults) and on a
+ * file in the page cache (read faults). Meanwhile other threads of the
+ * same process keep calling mmap, mprotect and munmap, which take
+ * mmap_sem for write and stall faults handled under mmap_sem. The
+ * spf_success and spf_fallback counters of /proc/vmstat show how many
+ * of the faults took the speculative path, where it is built in.
+ *
+ * The file should be on a disk filesystem: tmpfs pages are not faulted
+ * in speculatively.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+static unsigned int	nthreads;
+static unsigned int	nstress		= 1;
+static unsigned int	size_mb		= 16;
+static unsigned int	loops		= 8;
+static const char	*file_name	= "perf-bench-fault.tmp";
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify number of faulting threads"),
+	OPT_UINTEGER('m', "mmap-threads", &nstress,
+		     "Specify number of mmap/mprotect/munmap threads"),
+	OPT_UINTEGER('s', "size", &size_mb,
+		     "Specify size of the region of each thread in MB"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of times each region is faulted in"),
+	OPT_STRING('f', "file", &file_name, "path",
+		   "Specify scratch file for the file-backed faults"),
+	OPT_END()
+};
+
+static const char * const bench_mem_fault_usage[] = {
+	"perf bench mem fault <options>",
+	NULL
+};
+
+static volatile int done;
+static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t page_size;
+static int file_fd = -1;
+
+static void *fault_fn(void *arg)
+{
+	size_t size = (size_t)size_mb << 20;
+	off_t off = (off_t)(unsigned long)arg * size;
+	volatile char *p;
+	unsigned int l;
+	size_t i;
+
+	pthread_mutex_lock(&start_mutex);
+	pthread_mutex_unlock(&start_mutex);
+
+	for (l = 0; l < loops; l++) {
+		if (file_fd < 0)
+			p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		else
+			p = mmap(NULL, size, PROT_READ, MAP_PRIVATE,
+				 file_fd, off);
+		if (p == MAP_FAILED)
+			die("mmap");
+		for (i = 0; i < size; i += page_size) {
+			if (file_fd < 0)
+				p[i] = 1;
+			else
+				(void)p[i];
+		}
+		munmap((void *)p, size);
+	}
+
+	return NULL;
+}
+
+static void *stress_fn(void *arg __used)
+{
+	char *p;
+
+	pthread_mutex_lock(&start_mutex);
+	pthread_mutex_unlock(&start_mutex);
+
+	while (!done) {
+		p = mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			die("mmap");
+		mprotect(p, page_size, PROT_READ);
+		munmap(p, page_size);
+	}
+
+	return NULL;
+}
+
+static void read_vmstat(unsigned long long *success,
+			unsigned long long *fallback)
+{
+	char name[64];
+	unsigned long long val;
+	FILE *f;
+
+	*success = *fallback = 0;
+	f = fopen("/proc/vmstat", "r");
+	if (!f)
+		return;
+	while (fscanf(f, "%63s %llu", name, &val) == 2) {
+		if (!strcmp(name, "spf_success"))
+			*success = val;
+		else if (!strcmp(name, "spf_fallback"))
+			*fallback = val;
+	}
+	fclose(f);
+}
+
+static void create_file(void)
+{
+	size_t len = (size_t)size_mb << 20;
+	unsigned int i;
+	char *buf;
+
+	file_fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (file_fd < 0)
+		die("open");
+	unlink(file_name);
+
+	/* written, so that every page is in the page cache and uptodate */
+	buf = malloc(len);
+	if (!buf)
+		die("malloc");
+	memset(buf, 1, len);
+	for (i = 0; i < nthreads; i++)
+		if (write(file_fd, buf, len) != (ssize_t)len)
+			die("write");
+	free(buf);
+}
+
+static double run(unsigned long long *success, unsigned long long *fallback)
+{
+	pthread_t *threads;
+	struct timeval start, end, diff;
+	unsigned long long s0, f0;
+	unsigned int i;
+
+	threads = calloc(nthreads + nstress, sizeof(*threads));
+	if (!threads)
+		die("calloc");
+
+	done = 0;
+	pthread_mutex_lock(&start_mutex);
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&threads[i], NULL, fault_fn,
+				   (void *)(unsigned long)i))
+			die("pthread_create");
+	for (i = 0; i < nstress; i++)
+		if (pthread_create(&threads[nthreads + i], NULL, stress_fn,
+				   NULL))
+			die("pthread_create");
+
+	read_vmstat(&s0, &f0);
+	gettimeofday(&start, NULL);
+	pthread_mutex_unlock(&start_mutex);
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	gettimeofday(&end, NULL);
+	read_vmstat(success, fallback);
+	*success -= s0;
+	*fallback -= f0;
+
+	done = 1;
+	for (i = 0; i < nstress; i++)
+		pthread_join(threads[nthreads + i], NULL);
+	free(threads);
+
+	timersub(&end, &start, &diff);
+	return diff.tv_sec + diff.tv_usec / 1e6;
+}
+
+int bench_mem_fault(int argc, const char **argv, const char *prefix __used)
+{
+	static const char * const modes[] = { "anon", "file" };
+	unsigned long long faults, success, fallback;
+	double secs;
+	int mode;
+
+	argc = parse_options(argc, argv, options, bench_mem_fault_usage, 0);
+	if (!nthreads)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!nthreads || !size_mb || !loops)
+		usage_with_options(bench_mem_fault_usage, options);
+	page_size = sysconf(_SC_PAGESIZE);
+
+	faults = (unsigned long long)nthreads * loops *
+		 (((size_t)size_mb << 20) / page_size);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u threads faulting %u MB %u times each, "
+		       "%u mmap threads\n\n", nthreads, size_mb, loops,
+		       nstress);
+
+	for (mode = 0; mode < 2; mode++) {
+		if (mode == 1)
+			create_file();
+		secs = run(&success, &fallback);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %4s: %.3lf sec, %.0lf faults/sec, "
+			       "spf %llu success %llu fallback\n",
+			       modes[mode], secs, faults / secs,
+			       success, fallback);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf %llu %llu\n", modes[mode], secs,
+			       success, fallback);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	close(file_fd);
+	return 0;
+}
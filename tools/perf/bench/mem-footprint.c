@@ -0,0 +1,199 @@
+/*
+ * mem-footprint.c
+ *
+ * footprint: Cost of polling the memory footprint of many processes
+ *
+ * Forks a number of processes, each with its memory spread over many
+ * mappings, and reads the memory usage of every one of them in turn,
+ * the way a memory monitor does: once from /proc/<pid>/smaps, which walks
+ * all the mappings and page tables of the process, and once from
+ * /proc/<pid>/footprint, which does not.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static unsigned int	nr_procs	= 32;
+static unsigned int	nr_maps		= 256;
+static unsigned int	map_kb		= 64;
+static unsigned int	loops		= 20;
+
+static const struct option options[] = {
+	OPT_UINTEGER('p', "procs", &nr_procs,
+		     "Specify number of processes"),
+	OPT_UINTEGER('m', "maps", &nr_maps,
+		     "Specify number of mappings in each process"),
+	OPT_UINTEGER('s', "size", &map_kb,
+		     "Specify size of each mapping in kB"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of times all processes are polled"),
+	OPT_END()
+};
+
+static const char * const bench_mem_footprint_usage[] = {
+	"perf bench mem footprint <options>",
+	NULL
+};
+
+static void child(int fd)
+{
+	size_t size = (size_t)map_kb << 10;
+	unsigned int i;
+	char *p;
+
+	for (i = 0; i < nr_maps; i++) {
+		/* alternate protections, so that mappings are not merged */
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE |
+			 (i & 1 ? PROT_EXEC : 0),
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			die("mmap");
+		memset(p, 1, size);
+	}
+
+	/* ready, then sleep until killed */
+	if (write(fd, "", 1) != 1)
+		die("write");
+	for (;;)
+		pause();
+}
+
+/* reads the whole file, returns its Rss in kB summed over all lines */
+static unsigned long long read_rss(const char *path)
+{
+	static char buf[1 << 16];
+	unsigned long long rss = 0, kb;
+	ssize_t len, off = 0;
+	char *line;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	while ((len = read(fd, buf + off, sizeof(buf) - 1 - off)) > 0) {
+		off += len;
+		buf[off] = '\0';
+		/* only complete lines are parsed, the rest is kept */
+		line = buf;
+		for (;;) {
+			char *nl = strchr(line, '\n');
+
+			if (!nl)
+				break;
+			if (sscanf(line, "Rss: %llu kB", &kb) == 1)
+				rss += kb;
+			line = nl + 1;
+		}
+		off = buf + off - line;
+		memmove(buf, line, off);
+	}
+	close(fd);
+	return rss;
+}
+
+static double poll_all(const pid_t *pids, const char *file,
+		       unsigned long long *rss)
+{
+	struct timeval start, end, diff;
+	char path[64];
+	unsigned int i, l;
+
+	gettimeofday(&start, NULL);
+	for (l = 0; l < loops; l++) {
+		*rss = 0;
+		for (i = 0; i < nr_procs; i++) {
+			snprintf(path, sizeof(path), "/proc/%d/%s", pids[i],
+				 file);
+			*rss += read_rss(path);
+		}
+	}
+	gettimeofday(&end, NULL);
+
+	timersub(&end, &start, &diff);
+	return diff.tv_sec + diff.tv_usec / 1e6;
+}
+
+int bench_mem_footprint(int argc, const char **argv,
+			const char *prefix __used)
+{
+	static const char * const files[] = { "smaps", "footprint" };
+	unsigned long long rss;
+	unsigned int i, polls;
+	pid_t *pids;
+	int fds[2];
+	double secs;
+	char c;
+
+	argc = parse_options(argc, argv, options, bench_mem_footprint_usage,
+			     0);
+	if (!nr_procs || !nr_maps || !map_kb || !loops)
+		usage_with_options(bench_mem_footprint_usage, options);
+
+	pids = calloc(nr_procs, sizeof(*pids));
+	if (!pids)
+		die("calloc");
+	if (pipe(fds))
+		die("pipe");
+
+	for (i = 0; i < nr_procs; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0)
+			die("fork");
+		if (!pids[i])
+			child(fds[1]);
+	}
+	for (i = 0; i < nr_procs; i++)
+		if (read(fds[0], &c, 1) != 1)
+			die("read");
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u processes with %u mappings of %u kB\n\n",
+		       nr_procs, nr_maps, map_kb);
+
+	polls = loops * nr_procs;
+	for (i = 0; i < ARRAY_SIZE(files); i++) {
+		secs = poll_all(pids, files[i], &rss);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			if (!rss) {
+				printf(" %10s: not supported\n", files[i]);
+				break;
+			}
+			printf(" %10s: %.3lf sec, %.1lf usecs per process, "
+			       "Rss %llu kB\n", files[i], secs,
+			       secs * 1e6 / polls, rss);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf %llu\n", files[i], secs, rss);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	for (i = 0; i < nr_procs; i++)
+		kill(pids[i], SIGKILL);
+	for (i = 0; i < nr_procs; i++)
+		waitpid(pids[i], NULL, 0);
+	close(fds[0]);
+	close(fds[1]);
+	free(pids);
+	return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * mem-madvise.c
+ *
+ * madvise: Freeing memory back the way allocators do
+ *
+ * Like malloc implementations returning free runs to the kernel, a pool
+ * is cycled in chunks: each chunk is written, then given back with
+ * madvise(). MADV_DONTNEED makes every reuse take a fault and a zeroed
+ * page, MADV_FREE lets the chunk be written again at no cost as long as
+ * there is no memory pressure.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#ifndef MADV_FREE
+#define MADV_FREE	8
+#endif
+
+static const char	*length_str	= "64MB";
+static const char	*chunk_str	= "256KB";
+static const char	*advice_str	= "all";
+static int		iterations	= 10;
+
+static const struct option options[] = {
+	OPT_STRING('l', "length", &length_str, "64MB",
+		    "Specify length of the pool. "
+		    "available unit: B, KB, MB, GB (upper and lower)"),
+	OPT_STRING('s', "chunk", &chunk_str, "256KB",
+		    "Specify size of the chunks freed at once"),
+	OPT_STRING('a', "advice", &advice_str, "all",
+		    "Specify advice: dontneed, free or all"),
+	OPT_INTEGER('i', "iterations", &iterations,
+		    "Specify number of passes over the pool"),
+	OPT_END()
+};
+
+static const char * const bench_mem_madvise_usage[] = {
+	"perf bench mem madvise <options>",
+	NULL
+};
+
+struct advice {
+	const char *name;
+	int advice;
+};
+
+static const struct advice advices[] = {
+	{ "dontneed", MADV_DONTNEED },
+	{ "free", MADV_FREE },
+	{ NULL, 0 }
+};
+
+struct result {
+	double secs;
+	long minflt;
+	unsigned long long lazyfree;
+};
+
+/* a counter from /proc/vmstat, 0 if the kernel does not have it */
+static unsigned long long vmstat_read(const char *name)
+{
+	unsigned long long val = 0, v;
+	char key[64];
+	FILE *f;
+
+	f = fopen("/proc/vmstat", "r");
+	if (!f)
+		return 0;
+	while (fscanf(f, "%63s %llu", key, &v) == 2) {
+		if (!strcmp(key, name)) {
+			val = v;
+			break;
+		}
+	}
+	fclose(f);
+	return val;
+}
+
+static int run(const struct advice *a, size_t len, size_t chunk,
+	       struct result *r)
+{
+	struct timeval start, end, diff;
+	struct rusage ru_start, ru_end;
+	unsigned long long lazyfree;
+	size_t off;
+	char *pool;
+	int i;
+
+	pool = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pool == MAP_FAILED)
+		die("mmap");
+	/* the first pass only populates the pool */
+	memset(pool, 1, len);
+
+	lazyfree = vmstat_read("pglazyfree");
+	getrusage(RUSAGE_SELF, &ru_start);
+	gettimeofday(&start, NULL);
+
+	for (i = 0; i < iterations; i++) {
+		for (off = 0; off + chunk <= len; off += chunk) {
+			memset(pool + off, i, chunk);
+			if (madvise(pool + off, chunk, a->advice)) {
+				munmap(pool, len);
+				return -1;
+			}
+		}
+	}
+
+	gettimeofday(&end, NULL);
+	getrusage(RUSAGE_SELF, &ru_end);
+
+	timersub(&end, &start, &diff);
+	r->secs = diff.tv_sec + diff.tv_usec / 1e6;
+	r->minflt = ru_end.ru_minflt - ru_start.ru_minflt;
+	r->lazyfree = vmstat_read("pglazyfree") - lazyfree;
+
+	munmap(pool, len);
+	return 0;
+}
+
+int bench_mem_madvise(int argc, const char **argv,
+		      const char *prefix __used)
+{
+	const struct advice *a;
+	size_t len, chunk;
+	struct result r;
+	bool all, found = false;
+
+	argc = parse_options(argc, argv, options,
+			     bench_mem_madvise_usage, 0);
+
+	len = (size_t)perf_atoll((char *)length_str);
+	chunk = (size_t)perf_atoll((char *)chunk_str);
+	if ((s64)len <= 0 || (s64)chunk <= 0 || chunk > len ||
+	    iterations <= 0) {
+		fprintf(stderr, "Invalid length, chunk size or iterations\n");
+		return 1;
+	}
+	all = !strcmp(advice_str, "all");
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# Cycling %s in %s chunks, %d iterations\n\n",
+		       length_str, chunk_str, iterations);
+
+	for (a = advices; a->name; a++) {
+		if (!all && strcmp(advice_str, a->name))
+			continue;
+		found = true;
+
+		if (run(a, len, chunk, &r)) {
+			fprintf(stderr, "madvise(%s) failed: %s\n", a->name,
+				strerror(errno));
+			continue;
+		}
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %8s: %.6lf sec, %ld page faults, "
+			       "%llu pages lazily freed\n",
+			       a->name, r.secs, r.minflt, r.lazyfree);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf %ld\n", a->name, r.secs, r.minflt);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	if (!found) {
+		fprintf(stderr, "Unknown advice: %s\n", advice_str);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,441 @@
+/*
+ *
+ * sched-binder.c
+ *
+ * binder: Latency of synchronous binder transactions
+ *
+ * A child process becomes the context manager of a binder device and
+ * answers every transaction with the scheduling policy and priority it
+ * handled it at. The parent, optionally running SCHED_FIFO, measures the
+ * round trip of empty transactions to it while background threads load
+ * the cpus with SCHED_OTHER work.
+ *
+ * The device must not have a context manager yet, so on a running Android
+ * system a separate one is needed, see the binder.devices parameter.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/*
+ * The parts of the binder interface used here, see drivers/android/binder.h.
+ * 32 bit kernels use the old protocol, as ANDROID_BINDER_IPC_32BIT does.
+ */
+#ifdef __LP64__
+typedef u_int64_t bench_binder_size_t;
+typedef u_int64_t bench_binder_uintptr_t;
+#define BENCH_BINDER_PROTOCOL_VERSION	8
+#else
+typedef u_int32_t bench_binder_size_t;
+typedef u_int32_t bench_binder_uintptr_t;
+#define BENCH_BINDER_PROTOCOL_VERSION	7
+#endif
+
+struct bench_binder_write_read {
+	bench_binder_size_t	write_size;
+	bench_binder_size_t	write_consumed;
+	bench_binder_uintptr_t	write_buffer;
+	bench_binder_size_t	read_size;
+	bench_binder_size_t	read_consumed;
+	bench_binder_uintptr_t	read_buffer;
+};
+
+struct bench_binder_transaction_data {
+	union {
+		u_int32_t		handle;
+		bench_binder_uintptr_t	ptr;
+	} target;
+	bench_binder_uintptr_t	cookie;
+	u_int32_t		code;
+	u_int32_t		flags;
+	pid_t			sender_pid;
+	uid_t			sender_euid;
+	bench_binder_size_t	data_size;
+	bench_binder_size_t	offsets_size;
+	union {
+		struct {
+			bench_binder_uintptr_t	buffer;
+			bench_binder_uintptr_t	offsets;
+		} ptr;
+		u_int8_t	buf[8];
+	} data;
+};
+
+#define BINDER_WRITE_READ	_IOWR('b', 1, struct bench_binder_write_read)
+#define BINDER_SET_MAX_THREADS	_IOW('b', 5, u_int32_t)
+#define BINDER_SET_CONTEXT_MGR	_IOW('b', 7, int32_t)
+#define BINDER_VERSION		_IOWR('b', 9, int32_t)
+
+#define BR_TRANSACTION		_IOR('r', 2, struct bench_binder_transaction_data)
+#define BR_REPLY		_IOR('r', 3, struct bench_binder_transaction_data)
+#define BR_DEAD_REPLY		_IO('r', 5)
+#define BR_FAILED_REPLY		_IO('r', 17)
+
+#define BC_TRANSACTION		_IOW('c', 0, struct bench_binder_transaction_data)
+#define BC_REPLY		_IOW('c', 1, struct bench_binder_transaction_data)
+#define BC_FREE_BUFFER		_IOW('c', 3, bench_binder_uintptr_t)
+#define BC_ENTER_LOOPER		_IO('c', 12)
+
+#define BENCH_BINDER_MAP_SIZE	(128 * 1024)
+
+/* transaction codes */
+enum {
+	BENCH_BINDER_PING,
+	BENCH_BINDER_QUIT,
+};
+
+/* what the server replies with */
+struct bench_binder_reply {
+	int32_t policy;
+	int32_t priority;	/* rt priority, or nice for SCHED_OTHER */
+};
+
+static const char *device = "/dev/binder";
+static unsigned int loops = 10000;
+static unsigned int nbackground;
+static unsigned int fifo_prio;
+
+static volatile int done;
+
+static const struct option options[] = {
+	OPT_STRING('D', "device", &device, "path",
+		   "Specify the binder device"),
+	OPT_UINTEGER('l', "loop", &loops,
+		     "Specify number of transactions"),
+	OPT_UINTEGER('b', "background", &nbackground,
+		     "Specify amount of SCHED_OTHER cpu hogs"),
+	OPT_UINTEGER('f', "fifo", &fifo_prio,
+		     "Run the caller SCHED_FIFO at this priority"),
+	OPT_END()
+};
+
+static const char * const bench_sched_binder_usage[] = {
+	"perf bench sched binder <options>",
+	NULL
+};
+
+struct bench_binder {
+	int fd;
+	void *map;
+	/* commands to send with the next BINDER_WRITE_READ */
+	u_int32_t wbuf[32];
+	size_t wlen;
+	u_int32_t rbuf[64];
+};
+
+static int binder_open(struct bench_binder *b)
+{
+	int32_t version;
+
+	b->fd = open(device, O_RDWR | O_CLOEXEC);
+	if (b->fd < 0)
+		return -1;
+	if (ioctl(b->fd, BINDER_VERSION, &version) < 0)
+		return -1;
+	if (version != BENCH_BINDER_PROTOCOL_VERSION) {
+		errno = EPROTO;
+		return -1;
+	}
+	b->map = mmap(NULL, BENCH_BINDER_MAP_SIZE, PROT_READ, MAP_PRIVATE,
+		      b->fd, 0);
+	if (b->map == MAP_FAILED)
+		return -1;
+	b->wlen = 0;
+	return 0;
+}
+
+static void binder_put(struct bench_binder *b, const void *data, size_t len)
+{
+	memcpy((char *)b->wbuf + b->wlen, data, len);
+	b->wlen += len;
+}
+
+static void binder_put_cmd(struct bench_binder *b, u_int32_t cmd,
+			   const void *data, size_t len)
+{
+	binder_put(b, &cmd, sizeof(cmd));
+	if (len)
+		binder_put(b, data, len);
+}
+
+/*
+ * Write what is pending, then read until a transaction or reply arrives.
+ * Returns BR_TRANSACTION or BR_REPLY, or 0 on error.
+ */
+static u_int32_t binder_transact(struct bench_binder *b,
+				 struct bench_binder_transaction_data *txn)
+{
+	struct bench_binder_write_read bwr;
+	u_int32_t cmd;
+	char *ptr, *end;
+
+	memset(&bwr, 0, sizeof(bwr));
+	bwr.write_buffer = (unsigned long)b->wbuf;
+	bwr.write_size = b->wlen;
+
+	for (;;) {
+		bwr.read_buffer = (unsigned long)b->rbuf;
+		bwr.read_size = sizeof(b->rbuf);
+		bwr.read_consumed = 0;
+
+		if (ioctl(b->fd, BINDER_WRITE_READ, &bwr) < 0) {
+			if (errno == EINTR)
+				continue;
+			return 0;
+		}
+		b->wlen = 0;
+		bwr.write_size = 0;
+
+		ptr = (char *)b->rbuf;
+		end = ptr + bwr.read_consumed;
+		while (ptr + sizeof(cmd) <= end) {
+			memcpy(&cmd, ptr, sizeof(cmd));
+			ptr += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_TRANSACTION:
+			case BR_REPLY:
+				memcpy(txn, ptr, sizeof(*txn));
+				return cmd;
+			case BR_DEAD_REPLY:
+			case BR_FAILED_REPLY:
+				errno = EPIPE;
+				return 0;
+			default:
+				ptr += _IOC_SIZE(cmd);
+				break;
+			}
+		}
+	}
+}
+
+static void server(int ready)
+{
+	struct bench_binder_transaction_data txn, reply_txn;
+	struct bench_binder_reply reply;
+	struct sched_param param;
+	struct bench_binder b;
+	u_int32_t max_threads = 0;
+	int err = 0;
+
+	if (binder_open(&b) ||
+	    ioctl(b.fd, BINDER_SET_MAX_THREADS, &max_threads) ||
+	    ioctl(b.fd, BINDER_SET_CONTEXT_MGR, 0))
+		err = errno;
+	if (write(ready, &err, sizeof(err)) != sizeof(err) || err)
+		exit(1);
+
+	binder_put_cmd(&b, BC_ENTER_LOOPER, NULL, 0);
+	for (;;) {
+		if (binder_transact(&b, &txn) != BR_TRANSACTION)
+			exit(1);
+
+		reply.policy = sched_getscheduler(0);
+		if (reply.policy == SCHED_FIFO || reply.policy == SCHED_RR) {
+			sched_getparam(0, &param);
+			reply.priority = param.sched_priority;
+		} else {
+			reply.priority = getpriority(PRIO_PROCESS, 0);
+		}
+
+		memset(&reply_txn, 0, sizeof(reply_txn));
+		reply_txn.data_size = sizeof(reply);
+		reply_txn.data.ptr.buffer = (unsigned long)&reply;
+		binder_put_cmd(&b, BC_FREE_BUFFER, &txn.data.ptr.buffer,
+			       sizeof(txn.data.ptr.buffer));
+		binder_put_cmd(&b, BC_REPLY, &reply_txn, sizeof(reply_txn));
+
+		if (txn.code == BENCH_BINDER_QUIT) {
+			struct bench_binder_write_read bwr;
+
+			memset(&bwr, 0, sizeof(bwr));
+			bwr.write_buffer = (unsigned long)b.wbuf;
+			bwr.write_size = b.wlen;
+			ioctl(b.fd, BINDER_WRITE_READ, &bwr);
+			exit(0);
+		}
+	}
+}
+
+static unsigned long long clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int call(struct bench_binder *b, u_int32_t code,
+		struct bench_binder_reply *reply)
+{
+	struct bench_binder_transaction_data txn;
+
+	memset(&txn, 0, sizeof(txn));
+	txn.target.handle = 0;
+	txn.code = code;
+	binder_put_cmd(b, BC_TRANSACTION, &txn, sizeof(txn));
+
+	if (binder_transact(b, &txn) != BR_REPLY)
+		return -1;
+
+	if (reply && txn.data_size >= sizeof(*reply))
+		memcpy(reply, (void *)(unsigned long)txn.data.ptr.buffer,
+		       sizeof(*reply));
+	/* freed along with the next transaction */
+	binder_put_cmd(b, BC_FREE_BUFFER, &txn.data.ptr.buffer,
+		       sizeof(txn.data.ptr.buffer));
+	return 0;
+}
+
+static void *background_fn(void *arg __used)
+{
+	while (!done)
+		;
+	return NULL;
+}
+
+static const char *policy_name(int policy)
+{
+	switch (policy) {
+	case SCHED_OTHER:
+		return "SCHED_OTHER";
+	case SCHED_FIFO:
+		return "SCHED_FIFO";
+	case SCHED_RR:
+		return "SCHED_RR";
+	default:
+		return "other";
+	}
+}
+
+int bench_sched_binder(int argc, const char **argv,
+		       const char *prefix __used)
+{
+	unsigned long long start, lat, sum = 0, max = 0;
+	struct bench_binder_reply reply;
+	struct sched_param param;
+	struct bench_binder b;
+	pthread_t *background;
+	int ready[2], err;
+	unsigned int i;
+	pid_t pid;
+
+	argc = parse_options(argc, argv, options,
+			     bench_sched_binder_usage, 0);
+	if (!loops)
+		usage_with_options(bench_sched_binder_usage, options);
+
+	if (pipe(ready))
+		die("pipe");
+
+	pid = fork();
+	if (pid < 0)
+		die("fork");
+	if (!pid) {
+		close(ready[0]);
+		server(ready[1]);
+	}
+
+	close(ready[1]);
+	if (read(ready[0], &err, sizeof(err)) != sizeof(err))
+		err = EIO;
+	close(ready[0]);
+	if (err) {
+		fprintf(stderr, "Cannot become context manager of %s: %s\n",
+			device, strerror(err));
+		waitpid(pid, NULL, 0);
+		exit(1);
+	}
+
+	if (binder_open(&b)) {
+		fprintf(stderr, "Cannot open %s: %s\n", device,
+			strerror(errno));
+		kill(pid, SIGKILL);
+		exit(1);
+	}
+
+	background = calloc(nbackground + 1, sizeof(*background));
+	if (!background)
+		die("calloc");
+	for (i = 0; i < nbackground; i++)
+		if (pthread_create(&background[i], NULL, background_fn, NULL))
+			die("pthread_create");
+
+	if (fifo_prio) {
+		param.sched_priority = fifo_prio;
+		if (sched_setscheduler(0, SCHED_FIFO, &param)) {
+			fprintf(stderr, "Cannot set SCHED_FIFO: %s\n",
+				strerror(errno));
+			kill(pid, SIGKILL);
+			exit(1);
+		}
+	}
+
+	memset(&reply, 0, sizeof(reply));
+	for (i = 0; i < loops; i++) {
+		start = clock_ns();
+		if (call(&b, BENCH_BINDER_PING, &reply))
+			die("binder transaction");
+		lat = clock_ns() - start;
+
+		sum += lat;
+		if (lat > max)
+			max = lat;
+	}
+
+	done = 1;
+	for (i = 0; i < nbackground; i++)
+		pthread_join(background[i], NULL);
+
+	call(&b, BENCH_BINDER_QUIT, NULL);
+	waitpid(pid, NULL, 0);
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u transactions on %s from a %s caller, "
+		       "%u background threads\n\n",
+		       loops, device, fifo_prio ? "SCHED_FIFO" : "SCHED_OTHER",
+		       nbackground);
+
+		printf(" %14s: %.3lf [usec]\n", "Avg latency",
+		       (double)sum / loops / 1000);
+		printf(" %14s: %.3lf [usec]\n", "Max latency",
+		       (double)max / 1000);
+		printf(" %14s: %s %d\n", "Server ran at",
+		       policy_name(reply.policy), reply.priority);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3lf\n", (double)sum / loops / 1000);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(background);
+
+	return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ *
+ * sched-deadline.c
+ *
+ * deadline: Deadline miss rate of periodic SCHED_DEADLINE tasks
+ *
+ * Each thread reserves runtime/deadline/period with sched_setattr() and
+ * then runs a job of a given amount of cpu time every period, released
+ * at absolute times. A job misses its deadline when it completes later
+ * than its release plus the relative deadline. Background threads can
+ * be added to load the cpus with SCHED_OTHER work.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE		6
+#endif
+
+/* the first published struct sched_attr, SCHED_ATTR_SIZE_VER0 */
+struct bench_sched_attr {
+	u_int32_t size;
+	u_int32_t sched_policy;
+	u_int64_t sched_flags;
+	int32_t sched_nice;
+	u_int32_t sched_priority;
+	u_int64_t sched_runtime;
+	u_int64_t sched_deadline;
+	u_int64_t sched_period;
+};
+
+static unsigned int nthreads = 1;
+static unsigned int nbackground;
+static unsigned int runtime_us = 2000;
+static unsigned int deadline_us;
+static unsigned int period_us = 16666;
+static unsigned int work_us = 1000;
+static unsigned int duration = 5;
+
+static volatile int done;
+
+struct dl_thread {
+	pthread_t thread;
+	int err;
+	unsigned long long jobs;
+	unsigned long long misses;
+	unsigned long long max_late_ns;
+	unsigned long long sum_late_ns;
+};
+
+static const struct option options[] = {
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify amount of SCHED_DEADLINE threads"),
+	OPT_UINTEGER('b', "background", &nbackground,
+		     "Specify amount of SCHED_OTHER cpu hogs"),
+	OPT_UINTEGER('r', "runtime", &runtime_us,
+		     "Reserved runtime per period [usec]"),
+	OPT_UINTEGER('d', "deadline", &deadline_us,
+		     "Relative deadline [usec] (default: period)"),
+	OPT_UINTEGER('p', "period", &period_us,
+		     "Period [usec]"),
+	OPT_UINTEGER('w', "work", &work_us,
+		     "Cpu time each job consumes [usec]"),
+	OPT_UINTEGER('l', "length", &duration,
+		     "Specify run length [sec]"),
+	OPT_END()
+};
+
+static const char * const bench_sched_deadline_usage[] = {
+	"perf bench sched deadline <options>",
+	NULL
+};
+
+static unsigned long long ts_ns(const struct timespec *ts)
+{
+	return ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static unsigned long long clock_ns(clockid_t clk)
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return ts_ns(&ts);
+}
+
+static int set_deadline(void)
+{
+#ifdef __NR_sched_setattr
+	struct bench_sched_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.sched_policy = SCHED_DEADLINE;
+	attr.sched_runtime = runtime_us * 1000ULL;
+	attr.sched_deadline = deadline_us * 1000ULL;
+	attr.sched_period = period_us * 1000ULL;
+
+	return syscall(__NR_sched_setattr, 0, &attr, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/* burn the given amount of cpu time, however long that takes */
+static void work(unsigned long long ns)
+{
+	unsigned long long end = clock_ns(CLOCK_THREAD_CPUTIME_ID) + ns;
+
+	while (clock_ns(CLOCK_THREAD_CPUTIME_ID) < end)
+		;
+}
+
+static void *dl_fn(void *arg)
+{
+	struct dl_thread *t = arg;
+	unsigned long long release, finish, late;
+	struct timespec next;
+
+	if (set_deadline()) {
+		t->err = errno;
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!done) {
+		release = ts_ns(&next);
+		work(work_us * 1000ULL);
+		finish = clock_ns(CLOCK_MONOTONIC);
+
+		t->jobs++;
+		if (finish > release + deadline_us * 1000ULL) {
+			late = finish - release - deadline_us * 1000ULL;
+			t->misses++;
+			t->sum_late_ns += late;
+			if (late > t->max_late_ns)
+				t->max_late_ns = late;
+		}
+
+		next.tv_nsec += period_us * 1000L;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	return NULL;
+}
+
+static void *background_fn(void *arg __used)
+{
+	while (!done)
+		;
+	return NULL;
+}
+
+int bench_sched_deadline(int argc, const char **argv,
+			 const char *prefix __used)
+{
+	unsigned long long jobs = 0, misses = 0, max_late = 0, sum_late = 0;
+	struct dl_thread *threads;
+	pthread_t *background;
+	unsigned int i;
+
+	argc = parse_options(argc, argv, options,
+			     bench_sched_deadline_usage, 0);
+
+	if (!deadline_us)
+		deadline_us = period_us;
+	if (!nthreads || !runtime_us || runtime_us > deadline_us ||
+	    deadline_us > period_us)
+		usage_with_options(bench_sched_deadline_usage, options);
+
+	threads = calloc(nthreads, sizeof(*threads));
+	background = calloc(nbackground + 1, sizeof(*background));
+	if (!threads || !background)
+		die("calloc");
+
+	for (i = 0; i < nbackground; i++)
+		if (pthread_create(&background[i], NULL, background_fn, NULL))
+			die("pthread_create");
+	for (i = 0; i < nthreads; i++)
+		if (pthread_create(&threads[i].thread, NULL, dl_fn,
+				   &threads[i]))
+			die("pthread_create");
+
+	sleep(duration);
+	done = 1;
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i].thread, NULL);
+	for (i = 0; i < nbackground; i++)
+		pthread_join(background[i], NULL);
+
+	for (i = 0; i < nthreads; i++) {
+		if (threads[i].err) {
+			fprintf(stderr, "Cannot set SCHED_DEADLINE: %s\n",
+				strerror(threads[i].err));
+			exit(1);
+		}
+		jobs += threads[i].jobs;
+		misses += threads[i].misses;
+		sum_late += threads[i].sum_late_ns;
+		if (threads[i].max_late_ns > max_late)
+			max_late = threads[i].max_late_ns;
+	}
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u SCHED_DEADLINE threads of %u/%u/%u usec "
+		       "running %u usec jobs, %u background threads\n\n",
+		       nthreads, runtime_us, deadline_us, period_us,
+		       work_us, nbackground);
+
+		printf(" %14s: %llu\n", "Jobs", jobs);
+		printf(" %14s: %llu (%.3lf%%)\n", "Misses", misses,
+		       jobs ? 100.0 * misses / jobs : 0.0);
+		printf(" %14s: %.3lf [usec]\n", "Avg lateness",
+		       misses ? (double)sum_late / misses / 1000 : 0.0);
+		printf(" %14s: %.3lf [usec]\n", "Max lateness",
+		       (double)max_late / 1000);
+		break;
+
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3lf\n", jobs ? 100.0 * misses / jobs : 0.0);
+		break;
+
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+
+	free(background);
+	free(threads);
+
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ *
+ * sched-freezer.c
+ *
+ * freezer: Latency of freezing and thawing a cgroup
+ *
+ * Threads sleeping on a pipe, as the threads of a cached app do, are put
+ * in a freezer cgroup of their own, which is then frozen and thawed. The
+ * time to FROZEN runs from the write to freezer.state until the state is
+ * observed, through the cgroup event on freezer.state when the kernel
+ * supports it and by polling freezer.state otherwise. Both modes of the
+ * cgroup are measured when freezer.fast exists.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+
+static const char	*mount_point	= "/sys/fs/cgroup/freezer";
+static unsigned int	nthreads	= 100;
+static unsigned int	loops		= 100;
+
+static const struct option options[] = {
+	OPT_STRING('m', "mount", &mount_point, "path",
+		   "Specify where the freezer hierarchy is mounted"),
+	OPT_UINTEGER('t', "threads", &nthreads,
+		     "Specify number of threads in the cgroup"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of freeze/thaw cycles"),
+	OPT_END()
+};
+
+static const char * const bench_sched_freezer_usage[] = {
+	"perf bench sched freezer <options>",
+	NULL
+};
+
+struct freezer_cg {
+	char path[PATH_MAX];
+	int state;	/* freezer.state, kept open */
+	int event;	/* eventfd registered on it, or -1 to poll */
+};
+
+struct lat {
+	unsigned long long sum, max;
+};
+
+static int sleep_pipe[2];
+static int ready_pipe[2];
+
+static unsigned long long clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int write_file(const char *dir, const char *name, const char *val)
+{
+	char path[PATH_MAX];
+	ssize_t ret;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		return -1;
+	ret = write(fd, val, strlen(val));
+	close(fd);
+	return ret < 0 ? -1 : 0;
+}
+
+static void *sleeper_fn(void *arg)
+{
+	struct freezer_cg *cg = arg;
+	char tid[16], c;
+
+	snprintf(tid, sizeof(tid), "%ld", (long)syscall(__NR_gettid));
+	c = write_file(cg->path, "tasks", tid) ? 1 : 0;
+	if (write(ready_pipe[1], &c, 1) != 1 || c)
+		return NULL;
+
+	/* sleeps until the end of the benchmark */
+	while (read(sleep_pipe[0], &c, 1) < 0 && errno == EINTR)
+		;
+	return NULL;
+}
+
+static int state_is(struct freezer_cg *cg, const char *state)
+{
+	char buf[16];
+	ssize_t len;
+
+	len = pread(cg->state, buf, sizeof(buf) - 1, 0);
+	if (len < 0)
+		die("read freezer.state");
+	buf[len] = '\0';
+	return !strncmp(buf, state, strlen(state));
+}
+
+static void set_state(struct freezer_cg *cg, const char *state)
+{
+	if (pwrite(cg->state, state, strlen(state), 0) < 0)
+		die("write freezer.state");
+}
+
+static void wait_state(struct freezer_cg *cg, const char *state)
+{
+	struct pollfd pfd = { .fd = cg->event, .events = POLLIN };
+	u_int64_t cnt;
+
+	while (!state_is(cg, state)) {
+		if (cg->event < 0)
+			continue;
+		/* the event is not sent for tasks frozen before registering */
+		if (poll(&pfd, 1, 10) > 0 &&
+		    read(cg->event, &cnt, sizeof(cnt)) < 0)
+			die("read eventfd");
+	}
+}
+
+static void register_event(struct freezer_cg *cg)
+{
+	char buf[32];
+
+	cg->event = eventfd(0, EFD_NONBLOCK);
+	if (cg->event < 0)
+		return;
+	snprintf(buf, sizeof(buf), "%d %d", cg->event, cg->state);
+	if (write_file(cg->path, "cgroup.event_control", buf)) {
+		close(cg->event);
+		cg->event = -1;
+	}
+}
+
+static void run(struct freezer_cg *cg, struct lat *freeze, struct lat *thaw)
+{
+	unsigned long long start, lat;
+	unsigned int i;
+
+	memset(freeze, 0, sizeof(*freeze));
+	memset(thaw, 0, sizeof(*thaw));
+
+	for (i = 0; i < loops; i++) {
+		start = clock_ns();
+		set_state(cg, "FROZEN");
+		wait_state(cg, "FROZEN");
+		lat = clock_ns() - start;
+		freeze->sum += lat;
+		if (lat > freeze->max)
+			freeze->max = lat;
+
+		start = clock_ns();
+		set_state(cg, "THAWED");
+		wait_state(cg, "THAWED");
+		lat = clock_ns() - start;
+		thaw->sum += lat;
+		if (lat > thaw->max)
+			thaw->max = lat;
+	}
+}
+
+static void print_lat(const char *mode, const char *what, struct lat *l)
+{
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf(" %6s %6s: %10.3lf avg %10.3lf max [usec]\n", mode,
+		       what, (double)l->sum / loops / 1000,
+		       (double)l->max / 1000);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%s %s %lf %lf\n", mode, what,
+		       (double)l->sum / loops / 1000, (double)l->max / 1000);
+		break;
+	default:
+		/* reaching here is something disaster */
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+		break;
+	}
+}
+
+int bench_sched_freezer(int argc, const char **argv,
+			const char *prefix __used)
+{
+	static const char * const modes[] = { "normal", "fast" };
+	struct freezer_cg cg;
+	struct lat freeze, thaw;
+	pthread_t *threads;
+	unsigned int i, started = 0;
+	int has_fast, mode;
+	char c;
+
+	argc = parse_options(argc, argv, options,
+			     bench_sched_freezer_usage, 0);
+	if (!loops || !nthreads)
+		usage_with_options(bench_sched_freezer_usage, options);
+
+	snprintf(cg.path, sizeof(cg.path), "%s/perf-bench-freezer-%d",
+		 mount_point, getpid());
+	if (mkdir(cg.path, 0755)) {
+		fprintf(stderr, "Cannot create %s: %s\n", cg.path,
+			strerror(errno));
+		exit(1);
+	}
+	snprintf(cg.path + strlen(cg.path), sizeof(cg.path) - strlen(cg.path),
+		 "/freezer.state");
+	cg.state = open(cg.path, O_RDWR);
+	*strrchr(cg.path, '/') = '\0';
+	if (cg.state < 0)
+		die("open freezer.state");
+	register_event(&cg);
+
+	if (pipe(sleep_pipe) || pipe(ready_pipe))
+		die("pipe");
+	threads = calloc(nthreads, sizeof(*threads));
+	if (!threads)
+		die("calloc");
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, sleeper_fn, &cg))
+			break;
+		if (read(ready_pipe[0], &c, 1) != 1 || c) {
+			pthread_join(threads[i], NULL);
+			break;
+		}
+		started++;
+	}
+	if (started != nthreads) {
+		fprintf(stderr, "Cannot start %u threads in %s\n", nthreads,
+			cg.path);
+		goto out;
+	}
+
+	has_fast = !write_file(cg.path, "freezer.fast", "0");
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %u freeze/thaw cycles of %u sleeping threads, "
+		       "%s\n\n", loops, nthreads,
+		       cg.event < 0 ? "polling freezer.state" :
+		       "waiting for freezer.state events");
+
+	for (mode = 0; mode <= has_fast; mode++) {
+		if (has_fast && write_file(cg.path, "freezer.fast",
+					   mode ? "1" : "0"))
+			die("write freezer.fast");
+		run(&cg, &freeze, &thaw);
+		print_lat(modes[mode], "freeze", &freeze);
+		print_lat(modes[mode], "thaw", &thaw);
+	}
+
+out:
+	/* closing the pipe lets the threads return, the cgroup empties */
+	close(sleep_pipe[1]);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	if (cg.event >= 0)
+		close(cg.event);
+	close(cg.state);
+	if (rmdir(cg.path))
+		fprintf(stderr, "Cannot remove %s: %s\n", cg.path,
+			strerror(errno));
+
+	return started == nthreads ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/*
+ *
+ * sched-unix.c
+ *
+ * unix: Message rate of unix seqpacket sockets, the input channel way
+ *
+ * A publisher thread sends bursts of small events over a SOCK_SEQPACKET
+ * socketpair, as the input dispatcher does to an app window, and waits
+ * for one "finished" message per event in return. The consumer thread
+ * sleeps in poll() until events arrive, reads all that are available,
+ * either one recv() at a time or with a single recvmmsg(), and
+ * acknowledges each of them.
+ *
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "../builtin.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define MAX_BURST	64
+/* InputConsumer sends back a seq and a handled flag */
+#define FINISHED_SIZE	12
+
+static unsigned int	size		= 96;
+static unsigned int	burst		= 8;
+static unsigned int	loops		= 100000;
+static const char	*recv_str	= "all";
+
+static const struct option options[] = {
+	OPT_UINTEGER('s', "size", &size,
+		     "Specify size of the events in bytes"),
+	OPT_UINTEGER('b', "burst", &burst,
+		     "Specify number of events sent at once (max 64)"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of bursts"),
+	OPT_STRING('r', "recv", &recv_str, "all",
+		   "Specify how events are read: recv, recvmmsg or all"),
+	OPT_END()
+};
+
+static const char * const bench_sched_unix_usage[] = {
+	"perf bench sched unix <options>",
+	NULL
+};
+
+struct consumer {
+	int fd;
+	bool mmsg;
+};
+
+static int recv_events(struct consumer *c, char *bufs, int max)
+{
+	struct mmsghdr msgs[MAX_BURST];
+	struct iovec iov[MAX_BURST];
+	int i, n;
+
+	if (!c->mmsg) {
+		for (n = 0; n < max; n++)
+			if (recv(c->fd, bufs + n * size, size,
+				 MSG_DONTWAIT) <= 0)
+				break;
+		return n;
+	}
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < max; i++) {
+		iov[i].iov_base = bufs + i * size;
+		iov[i].iov_len = size;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	n = recvmmsg(c->fd, msgs, max, MSG_DONTWAIT, NULL);
+	return n < 0 ? 0 : n;
+}
+
+static void *consumer_fn(void *arg)
+{
+	struct consumer *c = arg;
+	char *bufs;
+	char finished[FINISHED_SIZE];
+	struct pollfd pfd = { .fd = c->fd, .events = POLLIN };
+	int i, n;
+
+	bufs = malloc(MAX_BURST * size);
+	if (!bufs)
+		die("malloc");
+	memset(finished, 0, sizeof(finished));
+
+	for (;;) {
+		if (poll(&pfd, 1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("poll");
+		}
+		if (pfd.revents & (POLLHUP | POLLERR))
+			break;
+
+		n = recv_events(c, bufs, MAX_BURST);
+		for (i = 0; i < n; i++)
+			if (send(c->fd, finished, sizeof(finished), 0) < 0)
+				die("send");
+	}
+
+	free(bufs);
+	return NULL;
+}
+
+static double run(bool mmsg)
+{
+	struct timeval start, end, diff;
+	struct consumer c;
+	char finished[FINISHED_SIZE];
+	pthread_t thread;
+	unsigned int i, j;
+	int fds[2];
+	char *event;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds))
+		die("socketpair");
+	c.fd = fds[1];
+	c.mmsg = mmsg;
+	if (pthread_create(&thread, NULL, consumer_fn, &c))
+		die("pthread_create");
+
+	event = calloc(1, size);
+	if (!event)
+		die("calloc");
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < loops; i++) {
+		for (j = 0; j < burst; j++)
+			if (send(fds[0], event, size, 0) < 0)
+				die("send");
+		for (j = 0; j < burst; j++)
+			if (recv(fds[0], finished, sizeof(finished), 0) < 0)
+				die("recv");
+	}
+	gettimeofday(&end, NULL);
+
+	close(fds[0]);
+	pthread_join(thread, NULL);
+	close(fds[1]);
+	free(event);
+
+	timersub(&end, &start, &diff);
+	return diff.tv_sec + diff.tv_usec / 1e6;
+}
+
+int bench_sched_unix(int argc, const char **argv,
+		     const char *prefix __used)
+{
+	static const char * const modes[] = { "recv", "recvmmsg" };
+	unsigned long long nr;
+	bool all, found = false;
+	double secs;
+	int mode;
+
+	argc = parse_options(argc, argv, options, bench_sched_unix_usage, 0);
+	if (!size || !loops || !burst || burst > MAX_BURST)
+		usage_with_options(bench_sched_unix_usage, options);
+	all = !strcmp(recv_str, "all");
+	nr = (unsigned long long)loops * burst;
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %llu events of %u bytes in bursts of %u\n\n",
+		       nr, size, burst);
+
+	for (mode = 0; mode < 2; mode++) {
+		if (!all && strcmp(recv_str, modes[mode]))
+			continue;
+		found = true;
+
+		secs = run(mode);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %8s: %.3lf sec, %.0lf events/sec, "
+			       "%.3lf usecs/event\n", modes[mode], secs,
+			       nr / secs, secs * 1e6 / nr);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%s %lf\n", modes[mode], secs);
+			break;
+		default:
+			/* reaching here is something disaster */
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+			break;
+		}
+	}
+
+	if (!found) {
+		fprintf(stderr, "Unknown receive mode: %s\n", recv_str);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * sound-pcm.c
+ *
+ * pcm: Wakeup jitter of a low-latency pcm stream
+ *
+ * Plays (or captures) silence through a pcm device with small periods,
+ * the way a low-latency audio client does, sleeping in poll() or in a
+ * blocking write/read between periods. The time between two wakeups is
+ * compared to the period time, and xruns are counted. Unless a period
+ * size is given, this is done for every power of two size in a range,
+ * and the smallest size that ran without xruns is reported. Meant to be
+ * run on snd-dummy or snd-aloop, where no hardware stands in the way;
+ * the kernel's own statistics of the substream are shown afterwards
+ * when CONFIG_SND_PCM_LATENCY_STATS is set.
+ */
+
+#include "../perf.h"
+#include "../util/util.h"
+#include "../util/parse-options.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <sound/asound.h>
+
+#define PCM_CHANNELS	2
+#define PCM_FRAME_BYTES	(PCM_CHANNELS * 2)	/* S16_LE */
+
+static unsigned int	card;
+static unsigned int	device;
+static unsigned int	rate		= 48000;
+static unsigned int	pin_period;
+static unsigned int	min_period	= 16;
+static unsigned int	max_period	= 1024;
+static unsigned int	periods		= 4;
+static unsigned int	loops		= 2000;
+static bool		capture;
+
+/* the period size being run */
+static unsigned int	period_size;
+
+static const struct option options[] = {
+	OPT_UINTEGER('c', "card", &card,
+		     "Specify card number of the pcm"),
+	OPT_UINTEGER('d', "device", &device,
+		     "Specify device number of the pcm"),
+	OPT_UINTEGER('r', "rate", &rate,
+		     "Specify sample rate"),
+	OPT_UINTEGER('p', "period", &pin_period,
+		     "Specify period size in frames, instead of a sweep"),
+	OPT_UINTEGER('m', "min-period", &min_period,
+		     "Specify smallest period size of the sweep in frames"),
+	OPT_UINTEGER('M', "max-period", &max_period,
+		     "Specify largest period size of the sweep in frames"),
+	OPT_UINTEGER('n', "periods", &periods,
+		     "Specify number of periods in the buffer"),
+	OPT_UINTEGER('l', "loops", &loops,
+		     "Specify number of periods to run per period size"),
+	OPT_BOOLEAN('C', "capture", &capture,
+		    "Capture instead of playback"),
+	OPT_END()
+};
+
+static const char * const bench_sound_pcm_usage[] = {
+	"perf bench sound pcm <options>",
+	NULL
+};
+
+struct result {
+	unsigned int wakeups;
+	unsigned int xruns;
+	double jitter_sum;	/* |wakeup interval - period time| [usec] */
+	double jitter_max;
+};
+
+static double now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static struct snd_mask *param_mask(struct snd_pcm_hw_params *p, int n)
+{
+	return &p->masks[n - SNDRV_PCM_HW_PARAM_FIRST_MASK];
+}
+
+static struct snd_interval *param_interval(struct snd_pcm_hw_params *p, int n)
+{
+	return &p->intervals[n - SNDRV_PCM_HW_PARAM_FIRST_INTERVAL];
+}
+
+static void param_set_mask(struct snd_pcm_hw_params *p, int n,
+			   unsigned int bit)
+{
+	struct snd_mask *m = param_mask(p, n);
+
+	memset(m, 0, sizeof(*m));
+	m->bits[bit >> 5] |= 1U << (bit & 31);
+}
+
+static void param_set_int(struct snd_pcm_hw_params *p, int n,
+			  unsigned int val)
+{
+	struct snd_interval *i = param_interval(p, n);
+
+	i->min = i->max = val;
+	i->integer = 1;
+}
+
+static void param_init(struct snd_pcm_hw_params *p)
+{
+	int n;
+
+	memset(p, 0, sizeof(*p));
+	for (n = SNDRV_PCM_HW_PARAM_FIRST_MASK;
+	     n <= SNDRV_PCM_HW_PARAM_LAST_MASK; n++)
+		memset(param_mask(p, n), 0xff, sizeof(struct snd_mask));
+	for (n = SNDRV_PCM_HW_PARAM_FIRST_INTERVAL;
+	     n <= SNDRV_PCM_HW_PARAM_LAST_INTERVAL; n++)
+		param_interval(p, n)->max = ~0U;
+	p->rmask = ~0U;
+	p->info = ~0U;
+}
+
+/* returns -1 if the pcm does not support the period size */
+static int pcm_open(void)
+{
+	struct snd_pcm_hw_params hw;
+	struct snd_pcm_sw_params sw;
+	char path[64];
+	int fd;
+
+	snprintf(path, sizeof(path), "/dev/snd/pcmC%uD%u%c", card, device,
+		 capture ? 'c' : 'p');
+	fd = open(path, O_RDWR);
+	if (fd < 0)
+		die("open pcm");
+
+	param_init(&hw);
+	param_set_mask(&hw, SNDRV_PCM_HW_PARAM_ACCESS,
+		       SNDRV_PCM_ACCESS_RW_INTERLEAVED);
+	param_set_mask(&hw, SNDRV_PCM_HW_PARAM_FORMAT,
+		       SNDRV_PCM_FORMAT_S16_LE);
+	param_set_mask(&hw, SNDRV_PCM_HW_PARAM_SUBFORMAT,
+		       SNDRV_PCM_SUBFORMAT_STD);
+	param_set_int(&hw, SNDRV_PCM_HW_PARAM_CHANNELS, PCM_CHANNELS);
+	param_set_int(&hw, SNDRV_PCM_HW_PARAM_RATE, rate);
+	param_set_int(&hw, SNDRV_PCM_HW_PARAM_PERIOD_SIZE, period_size);
+	param_set_int(&hw, SNDRV_PCM_HW_PARAM_PERIODS, periods);
+	if (ioctl(fd, SNDRV_PCM_IOCTL_HW_PARAMS, &hw)) {
+		if (errno != EINVAL)
+			die("pcm hw params");
+		close(fd);
+		return -1;
+	}
+
+	memset(&sw, 0, sizeof(sw));
+	sw.tstamp_mode = SNDRV_PCM_TSTAMP_NONE;
+	sw.period_step = 1;
+	sw.avail_min = period_size;
+	sw.start_threshold = capture ? 1 : period_size * periods;
+	sw.stop_threshold = period_size * periods;
+	sw.boundary = period_size * periods;
+	while (sw.boundary * 2 <= 0x7fffffffUL - period_size * periods)
+		sw.boundary *= 2;
+	if (ioctl(fd, SNDRV_PCM_IOCTL_SW_PARAMS, &sw))
+		die("pcm sw params");
+
+	if (ioctl(fd, SNDRV_PCM_IOCTL_PREPARE))
+		die("pcm prepare");
+	return fd;
+}
+
+/* returns false on an xrun, after which the stream is prepared again */
+static bool pcm_transfer(int fd, char *buf)
+{
+	struct snd_xferi x;
+
+	x.result = 0;
+	x.buf = buf;
+	x.frames = period_size;
+	if (!ioctl(fd, capture ? SNDRV_PCM_IOCTL_READI_FRAMES :
+				 SNDRV_PCM_IOCTL_WRITEI_FRAMES, &x))
+		return true;
+	if (errno != EPIPE)
+		die("pcm transfer");
+	if (ioctl(fd, SNDRV_PCM_IOCTL_PREPARE))
+		die("pcm prepare");
+	return false;
+}
+
+static bool run(bool use_poll, struct result *r)
+{
+	struct pollfd pfd;
+	double period_us, last = 0, t, jitter;
+	unsigned int i;
+	char *buf;
+	int fd;
+
+	memset(r, 0, sizeof(*r));
+	period_us = period_size * 1e6 / rate;
+
+	buf = calloc(period_size, PCM_FRAME_BYTES);
+	if (!buf)
+		die("calloc");
+
+	fd = pcm_open();
+	if (fd < 0) {
+		free(buf);
+		return false;
+	}
+	pfd.fd = fd;
+	pfd.events = capture ? POLLIN : POLLOUT;
+
+	/* fill the buffer, playback starts once it is full */
+	if (!capture)
+		for (i = 0; i < periods; i++)
+			pcm_transfer(fd, buf);
+
+	for (i = 0; i < loops; i++) {
+		if (use_poll && poll(&pfd, 1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("poll");
+		}
+		if (!pcm_transfer(fd, buf)) {
+			r->xruns++;
+			last = 0;
+			continue;
+		}
+
+		t = now_us();
+		if (last) {
+			jitter = t - last - period_us;
+			if (jitter < 0)
+				jitter = -jitter;
+			r->jitter_sum += jitter;
+			if (jitter > r->jitter_max)
+				r->jitter_max = jitter;
+			r->wakeups++;
+		}
+		last = t;
+	}
+
+	ioctl(fd, SNDRV_PCM_IOCTL_DROP);
+	close(fd);
+	free(buf);
+	return true;
+}
+
+static void show_kernel_stats(void)
+{
+	char path[128], line[256];
+	FILE *f;
+
+	snprintf(path, sizeof(path),
+		 "/proc/asound/card%u/pcm%u%c/sub0/latency",
+		 card, device, capture ? 'c' : 'p');
+	f = fopen(path, "r");
+	if (!f)
+		return;
+	printf("\n# %s\n", path);
+	while (fgets(line, sizeof(line), f))
+		printf("%s", line);
+	fclose(f);
+}
+
+int bench_sound_pcm(int argc, const char **argv, const char *prefix __used)
+{
+	static const char * const modes[] = { "blocking", "poll" };
+	/* smallest period size without xruns, per mode */
+	unsigned int best[2] = { 0, 0 };
+	struct result r;
+	int mode;
+
+	argc = parse_options(argc, argv, options, bench_sound_pcm_usage, 0);
+	if (pin_period)
+		min_period = max_period = pin_period;
+	if (!rate || !min_period || min_period > max_period ||
+	    periods < 2 || !loops)
+		usage_with_options(bench_sound_pcm_usage, options);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# %s of %u periods per size at %u Hz on "
+		       "card %u device %u\n\n",
+		       capture ? "capture" : "playback",
+		       loops, rate, card, device);
+
+	for (period_size = min_period; period_size <= max_period;
+	     period_size *= 2) {
+		for (mode = 0; mode < 2; mode++) {
+			if (!run(mode, &r)) {
+				if (pin_period)
+					die("pcm hw params");
+				if (bench_format == BENCH_FORMAT_DEFAULT)
+					printf(" %5u frames: not supported\n",
+					       period_size);
+				break;
+			}
+			if (!r.xruns && !best[mode])
+				best[mode] = period_size;
+
+			switch (bench_format) {
+			case BENCH_FORMAT_DEFAULT:
+				printf(" %5u frames %8s: wakeup jitter "
+				       "%.1lf usecs avg, %.1lf usecs max, "
+				       "%u xruns\n", period_size, modes[mode],
+				       r.wakeups ? r.jitter_sum / r.wakeups : 0,
+				       r.jitter_max, r.xruns);
+				break;
+			case BENCH_FORMAT_SIMPLE:
+				printf("%u %s %lf %lf %u\n", period_size,
+				       modes[mode],
+				       r.wakeups ? r.jitter_sum / r.wakeups : 0,
+				       r.jitter_max, r.xruns);
+				break;
+			default:
+				/* reaching here is something disaster */
+				fprintf(stderr, "Unknown format:%d\n",
+					bench_format);
+				exit(1);
+				break;
+			}
+		}
+		/* do not wrap around on a huge max */
+		if (period_size > max_period / 2)
+			break;
+	}
+
+	if (bench_format == BENCH_FORMAT_DEFAULT) {
+		printf("\n");
+		for (mode = 0; mode < 2; mode++) {
+			if (best[mode])
+				printf(" %8s: smallest period without xruns "
+				       "%u frames (%.2lf msecs)\n", modes[mode],
+				       best[mode], best[mode] * 1e3 / rate);
+			else
+				printf(" %8s: no period without xruns\n",
+				       modes[mode]);
+		}
+		show_kernel_stats();
+	}
+	return 0;
+}
@@ -13,6 +13,9 @@
  * Available subsystem list:
  *  sched ... scheduler and IPC mechanism
  *  mem   ... memory access performance
+ *  futex ... futex hashing and wait/wake performance
+ *  fs    ... filesystem notification and async I/O
+ *  sound ... audio latency
  *
  */
 
@@ -42,6 +45,18 @@ static struct bench_suite sched_suites[] = {
 	{ "pipe",
 	  "Flood of communication over pipe() between two processes",
 	  bench_sched_pipe      },
+	{ "deadline",
+	  "Deadline miss rate of periodic SCHED_DEADLINE tasks",
+	  bench_sched_deadline  },
+	{ "binder",
+	  "Latency of synchronous binder transactions",
+	  bench_sched_binder    },
+	{ "freezer",
+	  "Latency of freezing and thawing a cgroup",
+	  bench_sched_freezer   },
+	{ "unix",
+	  "Message rate of unix seqpacket sockets, the input channel way",
+	  bench_sched_unix      },
 	suite_all,
 	{ NULL,
 	  NULL,
@@ -55,6 +70,57 @@ static struct bench_suite mem_suites[] = {
 	{ "memset",
 	  "Simple memory set in various ways",
 	  bench_mem_memset },
+	{ "madvise",
+	  "Reusing memory freed with MADV_DONTNEED and MADV_FREE",
+	  bench_mem_madvise },
+	{ "footprint",
+	  "Cost of polling the memory footprint of many processes",
+	  bench_mem_footprint },
+	{ "fault",
+	  "Page fault throughput next to mmap and munmap",
+	  bench_mem_fault },
+	{ "charge",
+	  "Page fault throughput of processes in many memory cgroups",
+	  bench_mem_charge },
+	suite_all,
+	{ NULL,
+	  NULL,
+	  NULL             }
+};
+
+static struct bench_suite futex_suites[] = {
+	{ "hash",
+	  "Benchmark for futex hash bucket contention",
+	  bench_futex_hash },
+	{ "wake",
+	  "Benchmark for futex wait/wake throughput",
+	  bench_futex_wake },
+	{ "wait-multiple",
+	  "Waiting on any of several events, futexes against epoll",
+	  bench_futex_wait_multiple },
+	suite_all,
+	{ NULL,
+	  NULL,
+	  NULL             }
+};
+
+static struct bench_suite fs_suites[] = {
+	{ "inotify",
+	  "Cost of watching a file flooded with writes",
+	  bench_fs_inotify },
+	{ "aio",
+	  "Native aio on buffered files",
+	  bench_fs_aio },
+	suite_all,
+	{ NULL,
+	  NULL,
+	  NULL             }
+};
+
+static struct bench_suite sound_suites[] = {
+	{ "pcm",
+	  "Wakeup jitter of a low-latency pcm stream",
+	  bench_sound_pcm },
 	suite_all,
 	{ NULL,
 	  NULL,
@@ -74,6 +140,15 @@ static struct bench_subsys subsystems[] = {
 	{ "mem",
 	  "memory access performance",
 	  mem_suites },
+	{ "futex",
+	  "futex hashing and wait/wake performance",
+	  futex_suites },
+	{ "fs",
+	  "filesystem notification performance",
+	  fs_suites },
+	{ "sound",
+	  "audio latency",
+	  sound_suites },
 	{ "all",		/* sentinel: easy for help */
 	  "test all subsystem (pseudo subsystem)",
 	  NULL },
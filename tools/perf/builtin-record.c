@@ -795,6 +795,8 @@ const struct option record_options[] = {
 		    "put the counters into a counter group"),
 	OPT_BOOLEAN('g', "call-graph", &record.opts.call_graph,
 		    "do call-graph (stack chain/backtrace) recording"),
+	OPT_UINTEGER(0, "user-stack", &record.opts.stack_dump_size,
+		     "sample user registers and this many bytes of user stack"),
 	OPT_INCR('v', "verbose", &verbose,
 		    "be more verbose (show counter open errors, etc)"),
 	OPT_BOOLEAN('q', "quiet", &quiet, "don't print any message"),
@@ -856,6 +858,20 @@ int cmd_record(int argc, const char **argv, const char *prefix __used)
 		rec->write_mode = WRITE_FORCE;
 	}
 
+	if (rec->opts.stack_dump_size) {
+		if (!PERF_REGS_MASK) {
+			fprintf(stderr, "user stack sampling is not supported"
+				" on this architecture\n");
+			usage_with_options(record_usage, record_options);
+		}
+		if (rec->opts.stack_dump_size % sizeof(u64) ||
+		    rec->opts.stack_dump_size >= USHRT_MAX) {
+			fprintf(stderr, "user stack size must be a multiple of"
+				" 8 below %u\n", USHRT_MAX);
+			usage_with_options(record_usage, record_options);
+		}
+	}
+
 	if (nr_cgroups && !rec->opts.system_wide) {
 		fprintf(stderr, "cgroup monitoring only available in"
 			" system-wide mode\n");
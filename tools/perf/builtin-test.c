@@ -563,8 +563,8 @@ static int test__basic_mmap(void)
 			goto out_munmap;
 		}
 
-		err = perf_event__parse_sample(event, attr.sample_type, sample_size,
-					       false, &sample, false);
+		err = perf_event__parse_sample(event, attr.sample_type, 0,
+					       sample_size, false, &sample, false);
 		if (err) {
 			pr_err("Can't parse sample, err = %d\n", err);
 			goto out_munmap;
@@ -1323,7 +1323,7 @@ static int test__PERF_RECORD(void)
 				if (type < PERF_RECORD_MAX)
 					nr_events[type]++;
 
-				err = perf_event__parse_sample(event, sample_type,
+				err = perf_event__parse_sample(event, sample_type, 0,
 							       sample_size, true,
 							       &sample, false);
 				if (err < 0) {
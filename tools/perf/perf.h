@@ -79,6 +79,8 @@ void get_term_dimensions(struct winsize *ws);
 
 #ifdef __arm__
 #include "../../arch/arm/include/asm/unistd.h"
+#include "../../arch/arm/include/asm/perf_regs.h"
+#define PERF_REGS_MASK	((1ULL << PERF_REG_ARM_MAX) - 1)
 /*
  * Use the __kuser_memory_barrier helper in the CPU helper page. See
  * arch/arm/kernel/entry-armv.S in the kernel source for details.
@@ -147,6 +149,10 @@ static inline void perf_mmap__write_tail(struct perf_mmap *md,
 # define NSEC_PER_SEC			1000000000ULL
 #endif
 
+#ifndef PERF_REGS_MASK
+#define PERF_REGS_MASK	0
+#endif
+
 static inline unsigned long long rdclock(void)
 {
 	struct timespec ts;
@@ -229,6 +235,7 @@ struct perf_record_opts {
 	unsigned int mmap_pages;
 	unsigned int user_freq;
 	int	     branch_stack;
+	unsigned int stack_dump_size;
 	u64	     default_interval;
 	u64	     user_interval;
 	const char   *cpu_list;
@@ -8,6 +8,7 @@
  */
 
 #include <byteswap.h>
+#include <linux/bitops.h>
 #include "asm/bug.h"
 #include "evsel.h"
 #include "evlist.h"
@@ -132,6 +133,13 @@ void perf_evsel__config(struct perf_evsel *evsel, struct perf_record_opts *opts,
 		attr->branch_sample_type = opts->branch_stack;
 	}
 
+	if (opts->stack_dump_size) {
+		attr->sample_type	|= PERF_SAMPLE_REGS_USER;
+		attr->sample_type	|= PERF_SAMPLE_STACK_USER;
+		attr->sample_regs_user	 = PERF_REGS_MASK;
+		attr->sample_stack_user	 = opts->stack_dump_size;
+	}
+
 	attr->mmap = track;
 	attr->comm = track;
 
@@ -452,7 +460,7 @@ static bool sample_overlap(const union perf_event *event,
 }
 
 int perf_event__parse_sample(const union perf_event *event, u64 type,
-			     int sample_size, bool sample_id_all,
+			     u64 regs_user, int sample_size, bool sample_id_all,
 			     struct perf_sample *data, bool swapped)
 {
 	const u64 *array;
@@ -594,6 +602,45 @@ int perf_event__parse_sample(const union perf_event *event, u64 type,
 		sz /= sizeof(u64);
 		array += sz;
 	}
+
+	if (type & PERF_SAMPLE_REGS_USER) {
+		if (sample_overlap(event, array, sizeof(u64)))
+			return -EFAULT;
+
+		/* First u64 tells us if we have any regs in sample. */
+		data->user_regs.abi = *array;
+		array++;
+
+		if (data->user_regs.abi) {
+			u64 sz = hweight64(regs_user) * sizeof(u64);
+
+			if (sample_overlap(event, array, sz))
+				return -EFAULT;
+
+			data->user_regs.regs = (u64 *)array;
+			array = (void *)array + sz;
+		}
+	}
+
+	if (type & PERF_SAMPLE_STACK_USER) {
+		u64 size;
+
+		if (sample_overlap(event, array, sizeof(u64)))
+			return -EFAULT;
+
+		size = *array++;
+		data->user_stack.size = 0;
+
+		if (size) {
+			if (sample_overlap(event, array, size + sizeof(u64)))
+				return -EFAULT;
+
+			data->user_stack.data = (char *)array;
+			array = (void *)array + size;
+			/* only the dynamic size was actually copied */
+			data->user_stack.size = *array++;
+		}
+	}
 	return 0;
 }
 
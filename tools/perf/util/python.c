@@ -806,6 +806,7 @@ static PyObject *pyrf_evlist__read_on_cpu(struct pyrf_evlist *pevlist,
 
 		first = list_entry(evlist->entries.next, struct perf_evsel, node);
 		err = perf_event__parse_sample(event, first->attr.sample_type,
+					       first->attr.sample_regs_user,
 					       perf_evsel__sample_size(first),
 					       sample_id_all, &pevent->sample, false);
 		if (err)
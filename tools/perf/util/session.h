@@ -41,6 +41,7 @@ struct perf_session {
 	 */
 	struct hists		hists;
 	u64			sample_type;
+	u64			sample_regs_user;
 	int			sample_size;
 	int			fd;
 	bool			fd_pipe;
@@ -133,6 +134,7 @@ static inline int perf_session__parse_sample(struct perf_session *session,
 					     struct perf_sample *sample)
 {
 	return perf_event__parse_sample(event, session->sample_type,
+					session->sample_regs_user,
 					session->sample_size,
 					session->sample_id_all, sample,
 					session->header.needs_swap);